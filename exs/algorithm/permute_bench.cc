@@ -0,0 +1,123 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <boost/chrono.hpp>
+#include <libhpc/algorithm/morton.hh>
+#include <libhpc/algorithm/sort_by_key.hh>
+#include <libhpc/algorithm/permute.hh>
+#include <libhpc/algorithm/reorder.hh>
+#include <libhpc/system/timer.hh>
+
+///
+/// Compares ways of sorting twelve particle attribute arrays by
+/// Morton key. `sort_by_key` sorts a copy of the keys alongside each
+/// attribute through the permuting iterator, as was done before
+/// `permute` existed. `permute` computes the sort permutation once
+/// and gathers each array out of place. `reorder_arrays` inverts the
+/// permutation and reorders all twelve arrays in place, following
+/// each cycle once. Reports the time of each in milliseconds and
+/// whether the results agree.
+///
+/// Usage: permute_bench [size] [repeats]
+///
+
+typedef hpc::timer<boost::chrono::duration<double>,boost::chrono::high_resolution_clock> timer_type;
+typedef std::vector<std::vector<double> > attrs_type;
+
+static const unsigned num_attrs = 12;
+
+void
+fill( attrs_type& attrs,
+      long size )
+{
+   attrs.resize( num_attrs );
+   for( unsigned ii = 0; ii < num_attrs; ++ii )
+   {
+      attrs[ii].resize( size );
+      for( long jj = 0; jj < size; ++jj )
+         attrs[ii][jj] = jj + 0.1*ii;
+   }
+}
+
+int
+main( int argc,
+      char* argv[] )
+{
+   long size = (argc > 1) ? atol( argv[1] ) : 4000000;
+   int repeats = (argc > 2) ? atoi( argv[2] ) : 3;
+
+   std::vector<uint32_t> keys( size );
+   for( long ii = 0; ii < size; ++ii )
+   {
+      uint64_t hash = (ii + 1)*11400714819323198485ull;
+      keys[ii] = hpc::morton<3>( (uint16_t)(hash & 1023), (uint16_t)((hash >> 20) & 1023), (uint16_t)((hash >> 40) & 1023) );
+   }
+
+   attrs_type by_key, gathered, in_place;
+   std::vector<uint32_t> tmp_keys;
+   std::vector<long> perm, inv( size );
+   timer_type by_key_timer, permute_timer, in_place_timer;
+   for( int rr = 0; rr < repeats; ++rr )
+   {
+      fill( by_key, size );
+      by_key_timer.start_explicit();
+      for( unsigned ii = 0; ii < num_attrs; ++ii )
+      {
+         tmp_keys = keys;
+         hpc::impl::sort_by_key( tmp_keys.begin(), tmp_keys.end(), by_key[ii].begin(), by_key[ii].end(), boost::false_type() );
+      }
+      by_key_timer.stop();
+
+      fill( gathered, size );
+      permute_timer.start_explicit();
+      perm = hpc::sort_permutation( keys );
+      for( unsigned ii = 0; ii < num_attrs; ++ii )
+         hpc::permute( perm, gathered[ii] );
+      permute_timer.stop();
+
+      fill( in_place, size );
+      in_place_timer.start_explicit();
+      perm = hpc::sort_permutation( keys );
+      hpc::invert_permutation( perm.begin(), perm.end(), inv.begin() );
+      hpc::reorder_arrays( inv.begin(), inv.end(),
+                           in_place[0].begin(), in_place[1].begin(), in_place[2].begin(),
+                           in_place[3].begin(), in_place[4].begin(), in_place[5].begin(),
+                           in_place[6].begin(), in_place[7].begin(), in_place[8].begin(),
+                           in_place[9].begin(), in_place[10].begin(), in_place[11].begin() );
+      in_place_timer.stop();
+   }
+
+   // The comparison sort isn't stable, so compare sorted keys.
+   bool match = (gathered == in_place);
+   for( unsigned ii = 0; ii < num_attrs && match; ++ii )
+   {
+      for( long jj = 0; jj < size && match; ++jj )
+         match = (keys[(long)by_key[ii][jj]] == keys[(long)gathered[ii][jj]]);
+   }
+
+   std::cout << "size: " << size << ", arrays: " << num_attrs << "\n";
+   std::cout << "sort_by_key (ms), permute (ms), reorder_arrays (ms), match\n";
+   std::cout << 1e3*by_key_timer.total().count()/repeats << ", "
+             << 1e3*permute_timer.total().count()/repeats << ", "
+             << 1e3*in_place_timer.total().count()/repeats << ", "
+             << match << "\n";
+   return EXIT_SUCCESS;
+}
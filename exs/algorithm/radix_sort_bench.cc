@@ -0,0 +1,121 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <boost/chrono.hpp>
+#include <libhpc/algorithm/morton.hh>
+#include <libhpc/algorithm/sort_by_key.hh>
+#include <libhpc/algorithm/radix_sort.hh>
+#include <libhpc/system/timer.hh>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+///
+/// Compares `radix_sort_by_key` against sorting through the
+/// permuting iterator, for 32 bit Morton keys of pseudo-random points
+/// and for 64 bit keys, each carrying a long index as the value. The
+/// radix sort runs with one thread and then with all OpenMP threads.
+/// Reports the time of each in milliseconds and whether the radix
+/// sort's keys match.
+///
+/// Usage: radix_sort_bench [size] [repeats]
+///
+
+typedef hpc::timer<boost::chrono::duration<double>,boost::chrono::high_resolution_clock> timer_type;
+
+template< class Key >
+void
+run( std::vector<Key> const& keys,
+     char const* name,
+     int repeats )
+{
+   std::vector<Key> cmp_keys, rad_keys;
+   std::vector<long> vals( keys.size() );
+   timer_type cmp_timer, serial_timer, parallel_timer;
+   bool match = true;
+#ifdef _OPENMP
+   int num_threads = omp_get_max_threads();
+#endif
+
+   for( int ii = 0; ii < repeats; ++ii )
+   {
+      cmp_keys = keys;
+      for( size_t jj = 0; jj < vals.size(); ++jj )
+         vals[jj] = jj;
+      cmp_timer.start_explicit();
+      hpc::impl::sort_by_key( cmp_keys.begin(), cmp_keys.end(), vals.begin(), vals.end(), boost::false_type() );
+      cmp_timer.stop();
+
+#ifdef _OPENMP
+      omp_set_num_threads( 1 );
+#endif
+      rad_keys = keys;
+      serial_timer.start_explicit();
+      hpc::radix_sort_by_key( rad_keys.begin(), rad_keys.end(), vals.begin() );
+      serial_timer.stop();
+      match = match && (rad_keys == cmp_keys);
+
+#ifdef _OPENMP
+      omp_set_num_threads( num_threads );
+#endif
+      rad_keys = keys;
+      parallel_timer.start_explicit();
+      hpc::radix_sort_by_key( rad_keys.begin(), rad_keys.end(), vals.begin() );
+      parallel_timer.stop();
+      match = match && (rad_keys == cmp_keys);
+   }
+
+   std::cout << name << ", "
+             << 1e3*cmp_timer.total().count()/repeats << ", "
+             << 1e3*serial_timer.total().count()/repeats << ", "
+             << 1e3*parallel_timer.total().count()/repeats << ", "
+             << match << "\n";
+}
+
+int
+main( int argc,
+      char* argv[] )
+{
+   long size = (argc > 1) ? atol( argv[1] ) : 10000000;
+   int repeats = (argc > 2) ? atoi( argv[2] ) : 5;
+
+#ifdef _OPENMP
+   std::cout << "threads: " << omp_get_max_threads() << ", size: " << size << "\n";
+#else
+   std::cout << "threads: 1, size: " << size << "\n";
+#endif
+   std::cout << "keys, comparison (ms), radix serial (ms), radix parallel (ms), match\n";
+
+   std::vector<uint32_t> mortons( size );
+   for( long ii = 0; ii < size; ++ii )
+   {
+      uint64_t hash = (ii + 1)*11400714819323198485ull;
+      mortons[ii] = hpc::morton<3>( (uint16_t)(hash & 1023), (uint16_t)((hash >> 20) & 1023), (uint16_t)((hash >> 40) & 1023) );
+   }
+   run( mortons, "morton uint32", repeats );
+
+   std::vector<uint64_t> wide( size );
+   for( long ii = 0; ii < size; ++ii )
+      wide[ii] = (ii + 1)*11400714819323198485ull;
+   run( wide, "uint64", repeats );
+
+   return EXIT_SUCCESS;
+}
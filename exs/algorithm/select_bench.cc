@@ -0,0 +1,152 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <boost/chrono.hpp>
+#include <libhpc/mpi/init.hh>
+#include <libhpc/mpi/comm.hh>
+#include <libhpc/algorithm/select.hh>
+#include <libhpc/system/timer.hh>
+
+///
+/// Compares sample-based `select` against the Ridders version for a
+/// distributed median. Run under mpirun; each rank holds
+/// `values_per_rank` values, either uniform doubles or integers with
+/// many duplicates. Ridders can't select integers, so it runs on a
+/// copy converted to double. Reports the time of each, the number of
+/// rounds `select` needed and both results. Then compares choosing
+/// `splitters` evenly spaced splitters with repeated `select` calls
+/// against one `select_many`, on the unsorted values and on values
+/// already sorted locally, where `select_many` can skip its sort.
+///
+/// Usage: select_bench [values_per_rank] [repeats] [splitters]
+///
+
+typedef hpc::timer<boost::chrono::duration<double>,boost::chrono::high_resolution_clock> timer_type;
+typedef hpc::mpi::comm comm;
+
+template< class T >
+void
+run( std::vector<T> const& values,
+     char const* name,
+     int repeats )
+{
+   long pos = comm::world.all_reduce( (long)values.size() )/2;
+   std::vector<double> reals( values.begin(), values.end() );
+   T exact;
+   double approx;
+   unsigned rounds;
+
+   comm::world.barrier();
+   timer_type sample_timer( true );
+   for( int ii = 0; ii < repeats; ++ii )
+      exact = hpc::select( values.begin(), values.end(), pos, comm::world, &rounds );
+   sample_timer.stop();
+
+   comm::world.barrier();
+   timer_type ridders_timer( true );
+   for( int ii = 0; ii < repeats; ++ii )
+      approx = hpc::ridders_select( reals.begin(), reals.end(), pos, comm::world );
+   ridders_timer.stop();
+
+   if( comm::world.rank() == 0 )
+   {
+      std::cout << name << ", "
+                << 1e3*ridders_timer.total().count()/repeats << ", "
+                << 1e3*sample_timer.total().count()/repeats << ", "
+                << rounds << ", "
+                << exact << ", " << approx << "\n";
+   }
+}
+
+void
+run_splitters( std::vector<double> const& values,
+               char const* name,
+               int num_splitters,
+               int repeats )
+{
+   long size = comm::world.all_reduce( (long)values.size() );
+   std::vector<long> pos( num_splitters );
+   for( int ii = 0; ii < num_splitters; ++ii )
+      pos[ii] = (size*(ii + 1))/(num_splitters + 1);
+   std::vector<double> many, single( num_splitters );
+   unsigned rounds;
+
+   comm::world.barrier();
+   timer_type single_timer( true );
+   for( int ii = 0; ii < repeats; ++ii )
+   {
+      for( int jj = 0; jj < num_splitters; ++jj )
+         single[jj] = hpc::select( values.begin(), values.end(), pos[jj], comm::world );
+   }
+   single_timer.stop();
+
+   comm::world.barrier();
+   timer_type many_timer( true );
+   for( int ii = 0; ii < repeats; ++ii )
+      many = hpc::select_many( values.begin(), values.end(), pos, comm::world, &rounds );
+   many_timer.stop();
+
+   if( comm::world.rank() == 0 )
+   {
+      std::cout << name << ", " << num_splitters << ", "
+                << 1e3*single_timer.total().count()/repeats << ", "
+                << 1e3*many_timer.total().count()/repeats << ", "
+                << rounds << ", "
+                << (many == single) << "\n";
+   }
+}
+
+int
+main( int argc,
+      char* argv[] )
+{
+   hpc::mpi::initialise( argc, argv );
+   long size = (argc > 1) ? atol( argv[1] ) : 10000000;
+   int repeats = (argc > 2) ? atoi( argv[2] ) : 5;
+   int num_splitters = (argc > 3) ? atoi( argv[3] ) : 63;
+   int rank = comm::world.rank();
+
+   if( rank == 0 )
+   {
+      std::cout << "ranks: " << comm::world.size() << ", values per rank: " << size << "\n";
+      std::cout << "data, ridders (ms), sample (ms), rounds, sample value, ridders value\n";
+   }
+
+   std::vector<double> reals( size );
+   for( long ii = 0; ii < size; ++ii )
+      reals[ii] = fmod( (ii + 1)*0.6180339887 + rank*0.4142135623, 1.0 );
+   run( reals, "uniform double", repeats );
+
+   std::vector<long> ints( size );
+   for( long ii = 0; ii < size; ++ii )
+      ints[ii] = ((ii + rank)*2654435761UL)%1000;
+   run( ints, "duplicate long", repeats );
+
+   if( rank == 0 )
+      std::cout << "data, splitters, select (ms), select_many (ms), rounds, agree\n";
+   run_splitters( reals, "unsorted double", num_splitters, repeats );
+   std::sort( reals.begin(), reals.end() );
+   run_splitters( reals, "sorted double", num_splitters, repeats );
+
+   hpc::mpi::finalise();
+   return EXIT_SUCCESS;
+}
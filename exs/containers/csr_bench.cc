@@ -0,0 +1,96 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <iostream>
+#include <libhpc/containers/csr.hh>
+#include <libhpc/system/timer.hh>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+///
+/// Scaling benchmark for csr::setup_3phase_parallel. Builds a csr
+/// from a pseudo-random row assignment with the serial and threaded
+/// constructions for 1 up to the maximum number of threads.
+///
+/// Usage: csr_bench [num_entries] [num_rows]
+///
+
+struct row_of
+{
+   typedef hpc::index mapped_type;
+
+   row_of( hpc::index num_rows )
+      : num_rows( num_rows )
+   {
+   }
+
+   mapped_type
+   operator()( hpc::index value ) const
+   {
+      return (value*2654435761UL)%num_rows;
+   }
+
+   hpc::index num_rows;
+};
+
+int
+main( int argc,
+      char* argv[] )
+{
+   hpc::index num_entries = (argc > 1) ? atol( argv[1] ) : 100000000;
+   hpc::index num_rows = (argc > 2) ? atol( argv[2] ) : num_entries/10;
+
+   hpc::vector<hpc::index> values( num_entries );
+   for( hpc::index ii = 0; ii < num_entries; ++ii )
+      values[ii] = ii;
+
+   hpc::csr<hpc::index> serial, parallel;
+   double serial_time;
+   {
+      hpc::timer<> timer( true );
+      serial.setup_3phase( num_rows, values.begin(), values.end(), row_of( num_rows ), hpc::always<hpc::index>() );
+      timer.stop();
+      serial_time = timer.total().count();
+   }
+   std::cout << "entries: " << num_entries << ", rows: " << num_rows << "\n";
+   std::cout << "serial: " << serial_time << " s\n";
+
+#ifdef _OPENMP
+   int max_threads = omp_get_max_threads();
+   for( int nt = 1; nt <= max_threads; nt *= 2 )
+   {
+      omp_set_num_threads( nt );
+      hpc::timer<> timer( true );
+      parallel.setup_3phase_parallel( num_rows, values.begin(), values.end(), row_of( num_rows ), hpc::always<hpc::index>() );
+      timer.stop();
+      double time = timer.total().count();
+      std::cout << "threads: " << nt << ", " << time << " s, speedup: " << serial_time/time;
+      if( parallel != serial )
+      {
+         std::cout << " (MISMATCH)\n";
+         return EXIT_FAILURE;
+      }
+      std::cout << "\n";
+   }
+#else
+   std::cout << "OpenMP not enabled, no threaded results.\n";
+#endif
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <boost/chrono.hpp>
+#include <libhpc/containers/po2_mpmc_queue.hh>
+#include <libhpc/containers/po2_ring_buffer.hh>
+#include <libhpc/system/timer.hh>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+///
+/// Contention benchmark for po2_mpmc_queue. Half the threads push
+/// and half pop through one queue, for 2 up to 64 threads; if the
+/// runtime grants a smaller or odd team the pops are shared among
+/// the remaining threads. The
+/// lock-free queue, with both wait policies, is compared against a
+/// po2_ring_buffer guarded by `omp critical`.
+///
+/// Usage: mpmc_bench [values_per_thread] [queue_size]
+///
+
+typedef hpc::timer<boost::chrono::duration<double>,boost::chrono::high_resolution_clock> timer_type;
+
+#ifdef _OPENMP
+
+///
+/// Split the team actually granted into producers and consumers, so
+/// a reduced or odd team still pushes and pops the same number of
+/// values. The lower half produce `num_values` each; the rest share
+/// popping them. Returns how many values this thread handles.
+///
+long
+split_roles( long num_values,
+	     bool& producer,
+	     long& total )
+{
+   int team = omp_get_num_threads();
+   int tid = omp_get_thread_num();
+   int num_producers = std::max( team/2, 1 );
+   int num_consumers = std::max( team - num_producers, 1 );
+   total = num_producers*num_values;
+   producer = (tid < num_producers);
+   if( producer )
+      return num_values;
+   int cid = (team == 1) ? 0 : tid - num_producers;
+   return (total*(cid + 1))/num_consumers - (total*cid)/num_consumers;
+}
+
+///
+/// Returns millions of pushes and pops per second.
+///
+template< class Queue >
+double
+run_queue( Queue& queue,
+	   int num_threads,
+	   long num_values )
+{
+   long total;
+   timer_type timer( true );
+#pragma omp parallel num_threads( num_threads )
+   {
+      bool producer;
+      long team_total;
+      long num = split_roles( num_values, producer, team_total );
+#pragma omp master
+      total = team_total;
+      if( omp_get_num_threads() == 1 )
+      {
+	 // Alone, alternate so the bounded queue never fills.
+	 for( long ii = 0; ii < num; ++ii )
+	 {
+	    queue.push( ii );
+	    queue.pop();
+	 }
+      }
+      else if( producer )
+      {
+	 for( long ii = 0; ii < num; ++ii )
+	    queue.push( ii );
+      }
+      else
+      {
+	 for( long ii = 0; ii < num; ++ii )
+	    queue.pop();
+      }
+   }
+   timer.stop();
+   return 2e-6*total/timer.total().count();
+}
+
+double
+run_critical( hpc::po2_ring_buffer<long>& queue,
+	      int num_threads,
+	      long num_values )
+{
+   long total;
+   timer_type timer( true );
+#pragma omp parallel num_threads( num_threads )
+   {
+      bool producer;
+      long team_total;
+      long num = split_roles( num_values, producer, team_total );
+#pragma omp master
+      total = team_total;
+      bool alone = (omp_get_num_threads() == 1);
+      for( long ii = 0; ii < num; )
+      {
+	 bool done;
+#pragma omp critical( mpmc_bench_queue )
+	 {
+	    if( alone )
+	    {
+	       queue.insert( ii );
+	       queue.pop();
+	       done = true;
+	    }
+	    else if( producer )
+	    {
+	       done = queue.vacant() > 0;
+	       if( done )
+		  queue.insert( ii );
+	    }
+	    else
+	    {
+	       done = !queue.empty();
+	       if( done )
+		  queue.pop();
+	    }
+	 }
+	 if( done )
+	    ++ii;
+      }
+   }
+   timer.stop();
+   return 2e-6*total/timer.total().count();
+}
+
+#endif
+
+int
+main( int argc,
+      char* argv[] )
+{
+   long num_values = (argc > 1) ? atol( argv[1] ) : 100000;
+   size_t queue_size = (argc > 2) ? atol( argv[2] ) : 1024;
+
+#ifdef _OPENMP
+   std::cout << "values per thread: " << num_values << ", queue size: " << queue_size << "\n";
+   std::cout << "threads, critical (Mops/s), spin (Mops/s), spin-park (Mops/s)\n";
+   for( int nt = 2; nt <= 64; nt *= 2 )
+   {
+      hpc::po2_ring_buffer<long> ring( queue_size );
+      double crit = run_critical( ring, nt, num_values );
+
+      hpc::po2_mpmc_queue<long,hpc::spin_wait> spin( queue_size );
+      double spin_rate = run_queue( spin, nt, num_values );
+
+      hpc::po2_mpmc_queue<long> park( queue_size );
+      double park_rate = run_queue( park, nt, num_values );
+
+      std::cout << nt << ", " << crit << ", " << spin_rate << ", " << park_rate << "\n";
+   }
+#else
+   std::cout << "OpenMP not enabled, no threaded results.\n";
+#endif
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <iostream>
+#include <libhpc/containers/csr.hh>
+#include <libhpc/containers/csr_spmv.hh>
+#include <libhpc/system/timer.hh>
+
+///
+/// Bandwidth benchmark for the csr spmv kernels. Reports the
+/// effective bandwidth of each instruction set, serial and threaded,
+/// alongside a STREAM triad measured on the same machine, which is
+/// the practical upper bound for a memory bound kernel.
+///
+/// Usage: spmv_bench [num_rows] [values_per_row] [iterations]
+///
+
+// The default process clock is too coarse for single kernel calls.
+typedef hpc::timer<boost::chrono::duration<double>,boost::chrono::high_resolution_clock> timer_type;
+
+static const char* level_names[] = { "scalar", "avx2", "avx512" };
+
+double
+triad_bandwidth( hpc::index size,
+		 int its )
+{
+   hpc::vector<double> a( size ), b( size ), c( size );
+   std::fill( b.begin(), b.end(), 1.0 );
+   std::fill( c.begin(), c.end(), 2.0 );
+   double best = 0.0;
+   for( int it = 0; it < its; ++it )
+   {
+      timer_type timer( true );
+#pragma omp parallel for
+      for( hpc::index ii = 0; ii < size; ++ii )
+	 a[ii] = b[ii] + 3.0*c[ii];
+      timer.stop();
+      best = std::max( best, 3.0*size*sizeof(double)/timer.total().count() );
+   }
+   return best*1e-9;
+}
+
+int
+main( int argc,
+      char* argv[] )
+{
+   hpc::index num_rows = (argc > 1) ? atol( argv[1] ) : 2000000;
+   hpc::index row_size = (argc > 2) ? atol( argv[2] ) : 16;
+   int its = (argc > 3) ? atoi( argv[3] ) : 20;
+
+   // Banded pattern with some scatter, so x has a mix of local and
+   // remote accesses.
+   hpc::csr<hpc::index> cols;
+   hpc::csr<double> vals;
+   {
+      hpc::vector<hpc::index> cnts( num_rows );
+      std::fill( cnts.begin(), cnts.end(), row_size );
+      cols.copy_counts( cnts.begin(), num_rows );
+      cols.setup_array( true );
+   }
+   vals.num_rows( num_rows );
+   vals.mod_displs().duplicate( cols.displs() );
+   vals.setup_array();
+   srand( 1 );
+   for( hpc::index row = 0; row < num_rows; ++row )
+   {
+      for( hpc::index jj = 0; jj < row_size; ++jj )
+      {
+	 hpc::index col = (jj%4 == 3) ? rand()%num_rows : row + jj - row_size/2;
+	 cols( row, jj ) = std::min( std::max<hpc::index>( col, 0 ), num_rows - 1 );
+	 vals( row, jj ) = 1.0/(jj + 1);
+      }
+   }
+   hpc::vector<double> x( num_rows ), y( num_rows );
+   std::fill( x.begin(), x.end(), 1.0 );
+
+   // Minimum traffic: values, columns and displacements once, plus x
+   // and y once each.
+   double bytes = vals.array().size()*(sizeof(double) + sizeof(hpc::index)) +
+      (num_rows + 1)*sizeof(hpc::index) + 2*num_rows*sizeof(double);
+   double stream = triad_bandwidth( num_rows*4, its );
+
+   std::cout << "rows: " << num_rows << ", values: " << vals.array().size() << "\n";
+   std::cout << "stream triad: " << stream << " GB/s\n";
+   for( int level = hpc::simd_scalar; level <= hpc::best_simd_level(); ++level )
+   {
+      for( int par = 0; par < 2; ++par )
+      {
+	 double best = 0.0;
+	 for( int it = 0; it < its; ++it )
+	 {
+	    timer_type timer( true );
+	    if( par )
+	       hpc::spmv_parallel( vals, cols, x, y, (hpc::simd_level)level );
+	    else
+	       hpc::spmv( vals, cols, x, y, (hpc::simd_level)level );
+	    timer.stop();
+	    best = std::max( best, bytes/timer.total().count() );
+	 }
+	 best *= 1e-9;
+	 std::cout << level_names[level] << (par ? " parallel: " : ": ")
+		   << best << " GB/s (" << 100.0*best/stream << "% of stream)\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
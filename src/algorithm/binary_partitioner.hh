@@ -132,9 +132,10 @@ namespace hpc {
 	 // Different version depending on serial or parallel.
 	 if( comm.size() > 1 )
 	 {
-	    // Calculate an initial median.
+	    // Calculate an initial median. Values up to and including
+	    // the median go left, so select the last left value.
 	    unsigned left_size = mpi::balanced_left_size( _lsize, comm );
-	    coord_type med = select( crd_begin, crd_end, left_size, comm );
+	    coord_type med = select( crd_begin, crd_end, left_size - 1, comm );
 
 	    // Calculate which ranks will collect on the left.
 	    mpi::balanced_partition part( comm );
@@ -146,7 +147,7 @@ namespace hpc {
 	    bool root_on_left = comm.bcast2( part.collecting_left() );
 	    unsigned root_sub_size = comm.bcast2( sub_size );
 	    left_size = root_on_left ? root_sub_size : (_gsize - root_sub_size);
-	    med = select( crd_begin, crd_end, left_size, comm );
+	    med = select( crd_begin, crd_end, left_size - 1, comm );
 
 	    // Calculate mpi::partition.
 	    part.connect( median_iterator_type( crd_begin, med ), median_iterator_type( crd_end ) );
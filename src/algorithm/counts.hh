@@ -168,7 +168,9 @@ namespace hpc {
       Iter cur = first++;
       while(--size) {
 	 ASSERT(*first >= *cur, "Invalid displacements.");
-	 *cur = *first++ - *cur++;
+	 *cur = *first - *cur;
+	 ++cur;
+	 ++first;
       }
       return cur;
    }
@@ -0,0 +1,214 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_algorithm_permute_hh
+#define hpc_algorithm_permute_hh
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/system/cc_version.hh"
+#include "radix_sort.hh"
+
+namespace hpc {
+
+   ///
+   /// Number of destinations each thread gathers at a time. Large
+   /// enough to amortise scheduling, small enough that a block of
+   /// indices and output stays in cache.
+   ///
+   static const size_t permute_block_size = 1 << 12;
+
+   namespace impl {
+
+      template< class KeyIter >
+      struct permutation_less
+      {
+         permutation_less( KeyIter const& keys )
+            : keys( keys )
+         {
+         }
+
+         template< class Index >
+         bool
+         operator()( Index op_a,
+                     Index op_b ) const
+         {
+            return keys[op_a] < keys[op_b];
+         }
+
+         KeyIter keys;
+      };
+
+      template< class KeyIter,
+                class IndexIter >
+      void
+      sort_permutation( KeyIter const& key_begin,
+                        KeyIter const& key_end,
+                        IndexIter const& perm_begin,
+                        boost::false_type )
+      {
+         std::stable_sort( perm_begin, perm_begin + (key_end - key_begin), permutation_less<KeyIter>( key_begin ) );
+      }
+
+      template< class KeyIter,
+                class IndexIter >
+      void
+      sort_permutation( KeyIter const& key_begin,
+                        KeyIter const& key_end,
+                        IndexIter const& perm_begin,
+                        boost::true_type )
+      {
+         typedef typename std::iterator_traits<KeyIter>::value_type key_type;
+         if( use_radix_sort( key_begin, key_end ) )
+         {
+            std::vector<key_type> keys( key_begin, key_end );
+            radix_sort_by_key( keys.begin(), keys.end(), perm_begin );
+         }
+         else
+            sort_permutation( key_begin, key_end, perm_begin, boost::false_type() );
+      }
+
+   }
+
+   ///
+   /// Compute the permutation that stably sorts a range of keys,
+   /// leaving the keys alone: `perm[ii]` is the index of the key that
+   /// belongs at position `ii`. Long runs of integer keys whose range
+   /// spans at most `radix_sort_max_span` bits are radix sorted, as in
+   /// `sort_by_key`. Apply the result to any number of arrays with
+   /// `permute`.
+   ///
+   template< class KeyIter,
+             class IndexIter >
+   void
+   sort_permutation( KeyIter const& key_begin,
+                     KeyIter const& key_end,
+                     IndexIter const& perm_begin )
+   {
+      typedef typename std::iterator_traits<KeyIter>::value_type key_type;
+      typedef typename std::iterator_traits<IndexIter>::value_type index_type;
+
+      long size = key_end - key_begin;
+      for( long ii = 0; ii < size; ++ii )
+         perm_begin[ii] = (index_type)ii;
+      impl::sort_permutation( key_begin, key_end, perm_begin, is_radix_key<key_type>() );
+   }
+
+   template< class KeySeq >
+   std::vector<long>
+   sort_permutation( KeySeq const& keys )
+   {
+      std::vector<long> perm( keys.size() );
+      sort_permutation( keys.begin(), keys.end(), perm.begin() );
+      return perm;
+   }
+
+   ///
+   /// Invert a permutation, so `inv[perm[ii]] = ii`. Converts between
+   /// the gather form used by `permute` and the scatter form used by
+   /// `reorder`.
+   ///
+   template< class IndexIter,
+             class OutIter >
+   void
+   invert_permutation( IndexIter const& perm_begin,
+                       IndexIter const& perm_end,
+                       OutIter const& inv_begin )
+   {
+      typedef typename std::iterator_traits<OutIter>::value_type index_type;
+
+      long size = perm_end - perm_begin;
+#pragma omp parallel for schedule(static)
+      for( long ii = 0; ii < size; ++ii )
+         inv_begin[perm_begin[ii]] = (index_type)ii;
+   }
+
+   ///
+   /// Gather `dst[ii] = src[perm[ii]]` for each index in the
+   /// permutation. The destination is split into blocks of
+   /// `permute_block_size` spread over the OpenMP threads with static
+   /// schedule, so each thread writes whole pages of output and reads
+   /// its indices once.
+   ///
+   template< class SrcIter,
+             class IndexIter,
+             class DstIter >
+   void
+   gather( SrcIter const& src_begin,
+           IndexIter const& perm_begin,
+           IndexIter const& perm_end,
+           DstIter const& dst_begin )
+   {
+      long size = perm_end - perm_begin;
+      long num_blocks = (size + permute_block_size - 1)/permute_block_size;
+#pragma omp parallel for schedule(static)
+      for( long blk = 0; blk < num_blocks; ++blk )
+      {
+         long first = blk*permute_block_size;
+         long last = std::min<long>( first + permute_block_size, size );
+         for( long ii = first; ii < last; ++ii )
+            dst_begin[ii] = src_begin[perm_begin[ii]];
+      }
+   }
+
+   ///
+   /// Rearrange a vector so `data[ii]` becomes the old
+   /// `data[perm[ii]]`, gathering into a fresh buffer with the same
+   /// allocator and swapping it in.
+   ///
+   template< class IndexSeq,
+             class T,
+             class Alloc >
+   void
+   permute( IndexSeq const& perm,
+            std::vector<T,Alloc>& data )
+   {
+      ASSERT( perm.size() == data.size(), "Permutation and data sizes differ." );
+      std::vector<T,Alloc> tmp( data.get_allocator() );
+      tmp.resize( data.size() );
+      gather( data.begin(), perm.begin(), perm.end(), tmp.begin() );
+      data.swap( tmp );
+   }
+
+#ifdef CXX_0X
+
+   ///
+   /// Apply one permutation to several vectors, for example every
+   /// attribute array of a set of particles after computing the
+   /// permutation once with `sort_permutation`. Each vector is
+   /// gathered in turn, so only one scratch buffer is live at once.
+   ///
+   template< class IndexSeq,
+             class T,
+             class Alloc,
+             class... Seqs >
+   void
+   permute( IndexSeq const& perm,
+            std::vector<T,Alloc>& data,
+            Seqs&... rest )
+   {
+      permute( perm, data );
+      permute( perm, rest... );
+   }
+
+#endif
+
+}
+
+#endif
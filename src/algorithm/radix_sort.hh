@@ -0,0 +1,385 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_algorithm_radix_sort_hh
+#define hpc_algorithm_radix_sort_hh
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
+#include "libhpc/debug/assert.hh"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace hpc {
+
+   ///
+   /// Inputs of integer keys at least this long are radix sorted by
+   /// `sort_by_key` and `sort_permutation`.
+   ///
+   static const size_t radix_sort_threshold = 1 << 10;
+
+   ///
+   /// Widest span of key bits that is radix sorted by `sort_by_key`
+   /// and `sort_permutation`. Beyond this the passes cost more than a
+   /// comparison sort, as with random 64 bit keys.
+   ///
+   static const unsigned radix_sort_max_span = 32;
+
+   ///
+   /// Key types `radix_sort_by_key` accepts: integers other than
+   /// bool.
+   ///
+   template< class Key >
+   struct is_radix_key
+      : boost::integral_constant<bool,
+                                 boost::is_integral<Key>::value &&
+                                 !boost::is_same<Key,bool>::value>
+   {
+   };
+
+   namespace impl {
+
+      ///
+      /// A key as unsigned, with the sign bit of signed keys flipped so
+      /// negative values order first.
+      ///
+      template< class Key >
+      inline
+      typename boost::make_unsigned<Key>::type
+      radix_flip( Key key )
+      {
+         typedef typename boost::make_unsigned<Key>::type ukey_type;
+         ukey_type flip = boost::is_signed<Key>::value ? ((ukey_type)1 << (8*sizeof(Key) - 1)) : 0;
+         return (ukey_type)key ^ flip;
+      }
+
+      ///
+      /// Digit `shift` of a key's offset from `base`, the smallest
+      /// flipped key.
+      ///
+      template< class Key >
+      inline
+      unsigned
+      radix_digit( Key key,
+                   typename boost::make_unsigned<Key>::type base,
+                   unsigned shift,
+                   unsigned mask )
+      {
+         return ((radix_flip( key ) - base) >> shift) & mask;
+      }
+
+      ///
+      /// Extent of a run of keys: the bits in which any differ from a
+      /// reference key, and the least and greatest flipped keys.
+      ///
+      template< class UKey >
+      struct radix_bounds
+      {
+         radix_bounds()
+            : diff( 0 ),
+              min( ~(UKey)0 ),
+              max( 0 )
+         {
+         }
+
+         void
+         merge( radix_bounds const& op )
+         {
+            diff |= op.diff;
+            min = std::min( min, op.min );
+            max = std::max( max, op.max );
+         }
+
+         UKey diff;
+         UKey min;
+         UKey max;
+      };
+
+      ///
+      /// Bounds of keys [first, last), with `ref` the reference key.
+      ///
+      template< class KeyIter,
+                class Key >
+      radix_bounds<typename boost::make_unsigned<Key>::type>
+      radix_scan( KeyIter keys,
+                  size_t first,
+                  size_t last,
+                  Key ref )
+      {
+         typedef typename boost::make_unsigned<Key>::type ukey_type;
+         radix_bounds<ukey_type> bnds;
+         for( size_t ii = first; ii < last; ++ii )
+         {
+            ukey_type key = radix_flip( (Key)keys[ii] );
+            bnds.diff |= (ukey_type)keys[ii] ^ (ukey_type)ref;
+            bnds.min = std::min( bnds.min, key );
+            bnds.max = std::max( bnds.max, key );
+         }
+         return bnds;
+      }
+
+      ///
+      /// Number of bits a radix sort of keys with bounds `bnds` must
+      /// cover, starting from bit `low`. Keys offset from the least
+      /// are below `max - min`, and share every bit below the lowest
+      /// that differs, so the span runs from that bit to the top of
+      /// `max - min`. A narrow signed range that crosses zero is
+      /// narrow here too.
+      ///
+      template< class UKey >
+      unsigned
+      radix_span( radix_bounds<UKey> const& bnds,
+                  unsigned& low )
+      {
+         UKey range = bnds.max - bnds.min;
+         unsigned high = 0;
+         while( high < 8*sizeof(UKey) && (range >> high) )
+            ++high;
+         low = 0;
+         while( low < high && !((bnds.diff >> low) & 1) )
+            ++low;
+         return high - low;
+      }
+
+      ///
+      /// Whether radix sorting keys [key_begin, key_end) should beat
+      /// a comparison sort: there are enough of them and their range
+      /// spans at most `radix_sort_max_span` bits. Costs one read of
+      /// the keys.
+      ///
+      template< class KeyIter >
+      bool
+      use_radix_sort( KeyIter const& key_begin,
+                      KeyIter const& key_end )
+      {
+         size_t size = key_end - key_begin;
+         if( size < radix_sort_threshold )
+            return false;
+         unsigned low;
+         return radix_span( radix_scan( key_begin, 0, size, *key_begin ), low ) <= radix_sort_max_span;
+      }
+
+      ///
+      /// Count the digits of keys [first, last) into `hist`.
+      ///
+      template< class KeyIter >
+      void
+      radix_histogram( KeyIter keys,
+                       size_t first,
+                       size_t last,
+                       typename boost::make_unsigned<typename std::iterator_traits<KeyIter>::value_type>::type base,
+                       unsigned shift,
+                       unsigned mask,
+                       size_t* hist )
+      {
+         std::fill( hist, hist + mask + 1, 0 );
+         for( size_t ii = first; ii < last; ++ii )
+            ++hist[radix_digit( keys[ii], base, shift, mask )];
+      }
+
+      ///
+      /// Move pairs [first, last) to their places in the output, with
+      /// `offs` holding the next free slot for each digit.
+      ///
+      template< class KeySrc,
+                class ValSrc,
+                class KeyDst,
+                class ValDst >
+      void
+      radix_scatter( KeySrc src_keys,
+                     ValSrc src_vals,
+                     KeyDst dst_keys,
+                     ValDst dst_vals,
+                     size_t first,
+                     size_t last,
+                     typename boost::make_unsigned<typename std::iterator_traits<KeySrc>::value_type>::type base,
+                     unsigned shift,
+                     unsigned mask,
+                     size_t* offs )
+      {
+         for( size_t ii = first; ii < last; ++ii )
+         {
+            size_t pos = offs[radix_digit( src_keys[ii], base, shift, mask )]++;
+            dst_keys[pos] = src_keys[ii];
+            dst_vals[pos] = src_vals[ii];
+         }
+      }
+
+   }
+
+   ///
+   /// Stable least significant digit radix sort of integer keys,
+   /// permuting values alongside. Suited to large arrays of 32 or
+   /// 64 bit keys, such as Morton codes.
+   ///
+   /// Each pass histograms one digit and scatters the pairs between
+   /// the input and one buffer of the same size. Digits are 11 bits
+   /// for large inputs, to save passes, and 8 bits otherwise, to keep
+   /// the histograms small; `digit_bits` overrides this. Digits are
+   /// taken from each key's offset from the least key, and passes
+   /// cover only the span of bits those offsets use, found in one
+   /// read beforehand. A pass is skipped when every key has the same
+   /// digit. Morton codes of a small region, narrow values held in
+   /// wide keys, or small signed ranges around zero so take fewer
+   /// passes.
+   ///
+   /// With OpenMP each thread takes a contiguous block of the pairs,
+   /// and offsets are computed from per-thread histograms so the
+   /// blocks scatter in order and the sort stays stable.
+   ///
+   /// The value type must be default constructible, as the scratch
+   /// buffer for values is sized up front.
+   ///
+   template< class KeyIter,
+             class ValIter >
+   void
+   radix_sort_by_key( KeyIter const& key_begin,
+                      KeyIter const& key_end,
+                      ValIter const& val_begin,
+                      unsigned digit_bits = 0 )
+   {
+      typedef typename std::iterator_traits<KeyIter>::value_type key_type;
+      typedef typename std::iterator_traits<ValIter>::value_type value_type;
+      typedef typename boost::make_unsigned<key_type>::type ukey_type;
+
+      size_t size = key_end - key_begin;
+      if( size < 2 )
+         return;
+      if( !digit_bits )
+         digit_bits = (size >= (1 << 16)) ? 11 : 8;
+      ASSERT( digit_bits > 0 && digit_bits <= 16, "Invalid radix digit size." );
+      unsigned num_buckets = 1 << digit_bits;
+      unsigned mask = num_buckets - 1;
+      key_type ref = *key_begin;
+
+      std::vector<key_type> tmp_keys( size );
+      std::vector<value_type> tmp_vals( size );
+      std::vector<size_t> hists;
+      std::vector<impl::radix_bounds<ukey_type> > bounds;
+      bool in_tmp = false;
+
+#pragma omp parallel
+      {
+#ifdef _OPENMP
+         unsigned num_threads = omp_get_num_threads();
+         unsigned tid = omp_get_thread_num();
+#else
+         unsigned num_threads = 1;
+         unsigned tid = 0;
+#endif
+
+#pragma omp single
+         {
+            hists.resize( num_threads*num_buckets );
+            bounds.resize( num_threads );
+         }
+
+         size_t first = (size*tid)/num_threads;
+         size_t last = (size*(tid + 1))/num_threads;
+         size_t* hist = hists.data() + tid*num_buckets;
+
+         // Limit the passes to the bits the offsets use.
+         bounds[tid] = impl::radix_scan( key_begin, first, last, ref );
+#pragma omp barrier
+         impl::radix_bounds<ukey_type> bnds;
+         for( unsigned tt = 0; tt < num_threads; ++tt )
+            bnds.merge( bounds[tt] );
+         ukey_type base = bnds.min;
+         unsigned low;
+         unsigned span = impl::radix_span( bnds, low );
+         unsigned high = low + span;
+
+         for( unsigned shift = low; shift < high; shift += digit_bits )
+         {
+            // Barriers keep every thread's view of `in_tmp` in step.
+            if( in_tmp )
+               impl::radix_histogram( tmp_keys.begin(), first, last, base, shift, mask, hist );
+            else
+               impl::radix_histogram( key_begin, first, last, base, shift, mask, hist );
+#pragma omp barrier
+
+            // Turn the counts into starting offsets, ordered by digit
+            // then thread. If one digit holds everything the pass
+            // would not move anything, so skip it.
+            bool skip = false;
+            for( unsigned dd = 0; dd < num_buckets && !skip; ++dd )
+            {
+               size_t cnt = 0;
+               for( unsigned tt = 0; tt < num_threads; ++tt )
+                  cnt += hists[tt*num_buckets + dd];
+               skip = (cnt == size);
+            }
+            if( !skip )
+            {
+#pragma omp barrier
+#pragma omp single
+               {
+                  size_t sum = 0;
+                  for( unsigned dd = 0; dd < num_buckets; ++dd )
+                  {
+                     for( unsigned tt = 0; tt < num_threads; ++tt )
+                     {
+                        size_t cnt = hists[tt*num_buckets + dd];
+                        hists[tt*num_buckets + dd] = sum;
+                        sum += cnt;
+                     }
+                  }
+               }
+               if( in_tmp )
+                  impl::radix_scatter( tmp_keys.begin(), tmp_vals.begin(), key_begin, val_begin, first, last, base, shift, mask, hist );
+               else
+                  impl::radix_scatter( key_begin, val_begin, tmp_keys.begin(), tmp_vals.begin(), first, last, base, shift, mask, hist );
+#pragma omp barrier
+#pragma omp single
+               in_tmp = !in_tmp;
+            }
+            else
+            {
+#pragma omp barrier
+            }
+         }
+
+         // Finish with the pairs back in the input.
+         if( in_tmp )
+         {
+            std::copy( tmp_keys.begin() + first, tmp_keys.begin() + last, key_begin + first );
+            std::copy( tmp_vals.begin() + first, tmp_vals.begin() + last, val_begin + first );
+         }
+      }
+   }
+
+   template< class KeySeq,
+             class ValSeq >
+   void
+   radix_sort_by_key( KeySeq& keys,
+                      ValSeq& vals,
+                      unsigned digit_bits = 0 )
+   {
+      ASSERT( keys.size() == vals.size(), "Must have one value per key." );
+      radix_sort_by_key( keys.begin(), keys.end(), vals.begin(), digit_bits );
+   }
+
+}
+
+#endif
@@ -18,6 +18,11 @@
 #ifndef libhpc_algorithm_reorder_hh
 #define libhpc_algorithm_reorder_hh
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "libhpc/system/cc_version.hh"
+
 namespace hpc {
 
    template< class DataIter,
@@ -49,6 +54,71 @@ namespace hpc {
       }
    }
 
+#ifdef CXX_0X
+
+   namespace impl {
+
+      template< class Index >
+      inline
+      void
+      reorder_swap( Index,
+	            Index )
+      {
+      }
+
+      template< class Index,
+	        class DataIter,
+	        class... DataIters >
+      void
+      reorder_swap( Index src,
+	            Index dst,
+	            DataIter data,
+	            DataIters... rest )
+      {
+	 std::swap( data[src], data[dst] );
+	 reorder_swap( src, dst, rest... );
+      }
+
+   }
+
+   ///
+   /// Reorder several arrays in place by one permutation, with the
+   /// same meaning as `reorder`: the value at `ii` moves to
+   /// `order[ii]`. Each cycle of the permutation is followed once,
+   /// moving every array along it together, so the order is read
+   /// once however many arrays there are. Visited positions are kept
+   /// in a bit per element, which bounds the time by the size even
+   /// for long cycles.
+   ///
+   template< class OrderIter,
+	     class... DataIters >
+   void
+   reorder_arrays( OrderIter const& order_begin,
+	           OrderIter const& order_end,
+	           DataIters... data_begins )
+   {
+      typedef typename std::iterator_traits<OrderIter>::value_type index_type;
+
+      index_type size = order_end - order_begin;
+      std::vector<bool> done( size );
+      for( index_type s = 0; s < size; ++s )
+      {
+	 if( done[s] )
+	    continue;
+	 done[s] = true;
+
+	 // Swapping the cycle's start with each member in turn leaves
+	 // every value one step further along.
+	 for( index_type d = order_begin[s]; d != s; d = order_begin[d] )
+	 {
+	    impl::reorder_swap( s, d, data_begins... );
+	    done[d] = true;
+	 }
+      }
+   }
+
+#endif
+
 }
 
 #endif
@@ -0,0 +1,264 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_algorithm_sample_sort_hh
+#define hpc_algorithm_sample_sort_hh
+
+#include <algorithm>
+#include <vector>
+#include <queue>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/mpi/comm.hh"
+#include "select.hh"
+
+namespace hpc {
+   namespace impl {
+
+      template< class Key >
+      struct sample_sort_index_less
+      {
+         sample_sort_index_less( std::vector<Key> const& keys )
+            : keys( keys )
+         {
+         }
+
+         bool
+         operator()( long op_a,
+                     long op_b ) const
+         {
+            return keys[op_a] < keys[op_b];
+         }
+
+         std::vector<Key> const& keys;
+      };
+
+      ///
+      /// Heap entries order by key and then by run, so the merge
+      /// takes equal keys from earlier runs first.
+      ///
+      template< class Key >
+      struct sample_sort_head
+      {
+         Key key;
+         long pos;
+         int run;
+
+         bool
+         operator<( sample_sort_head const& op ) const
+         {
+            // Inverted, for a min-heap from std::priority_queue.
+            return (op.key < key) || (!(key < op.key) && op.run < run);
+         }
+      };
+
+      ///
+      /// Merge the sorted runs `keys[displs[ii], displs[ii + 1])` into
+      /// `out`, recording in `perm` where each output came from if
+      /// given. Stable with respect to run order.
+      ///
+      template< class Key >
+      void
+      kway_merge( std::vector<Key> const& keys,
+                  std::vector<long> const& displs,
+                  std::vector<Key>& out,
+                  std::vector<long>* perm )
+      {
+         out.resize( keys.size() );
+         if( perm )
+            perm->resize( keys.size() );
+         std::priority_queue<sample_sort_head<Key> > heap;
+         for( int ii = 0; ii < (int)displs.size() - 1; ++ii )
+         {
+            if( displs[ii] < displs[ii + 1] )
+            {
+               sample_sort_head<Key> head = { keys[displs[ii]], displs[ii], ii };
+               heap.push( head );
+            }
+         }
+         long dst = 0;
+         while( !heap.empty() )
+         {
+            sample_sort_head<Key> head = heap.top();
+            heap.pop();
+            out[dst] = head.key;
+            if( perm )
+               (*perm)[dst] = head.pos;
+            ++dst;
+            if( ++head.pos < displs[head.run + 1] )
+            {
+               head.key = keys[head.pos];
+               heap.push( head );
+            }
+         }
+      }
+
+      template< class T >
+      void
+      sample_sort_permute( std::vector<T>& data,
+                           std::vector<long> const& perm )
+      {
+         std::vector<T> tmp( data.size() );
+         for( size_t ii = 0; ii < perm.size(); ++ii )
+            tmp[ii] = data[perm[ii]];
+         data.swap( tmp );
+      }
+
+      ///
+      /// Find where to cut the locally sorted `keys` so that rank r
+      /// of the communicator receives exactly the values at global
+      /// positions [r*N/P, (r + 1)*N/P), with the remainder spread
+      /// over the lowest ranks. Equal keys straddling a cut are
+      /// assigned in rank order, which keeps the sort stable.
+      ///
+      template< class Key >
+      std::vector<int>
+      sample_sort_counts( std::vector<Key> const& keys,
+                          mpi::comm const& comm )
+      {
+         int num_ranks = comm.size();
+         long size = comm.all_reduce( (long)keys.size() );
+         long base = size/num_ranks, rem = size%num_ranks;
+
+         // Global offsets of each output rank; the splitters are the
+         // values at those positions.
+         std::vector<long> offs( num_ranks - 1 ), pos;
+         for( int ii = 1; ii < num_ranks; ++ii )
+         {
+            offs[ii - 1] = ii*base + std::min<long>( ii, rem );
+            if( offs[ii - 1] < size )
+               pos.push_back( offs[ii - 1] );
+         }
+         std::vector<Key> splitters = select_many( keys.begin(), keys.end(), pos, comm );
+
+         // Count values below and equal to each splitter, globally
+         // and on lower ranks.
+         std::vector<long> below( pos.size() ), equal( pos.size() );
+         for( size_t ii = 0; ii < pos.size(); ++ii )
+         {
+            typename std::vector<Key>::const_iterator lo = std::lower_bound( keys.begin(), keys.end(), splitters[ii] );
+            typename std::vector<Key>::const_iterator hi = std::upper_bound( lo, keys.end(), splitters[ii] );
+            below[ii] = lo - keys.begin();
+            equal[ii] = hi - lo;
+         }
+         std::vector<long> global_below( below ), equal_before( equal );
+         comm.all_reduce( view<std::vector<long> >( global_below ) );
+         comm.scan( view<std::vector<long> >( equal_before ) );
+
+         // Cut points, then counts.
+         std::vector<long> cuts( num_ranks + 1 );
+         cuts[0] = 0;
+         cuts[num_ranks] = keys.size();
+         for( int ii = 1; ii < num_ranks; ++ii )
+         {
+            if( ii - 1 < (int)pos.size() )
+            {
+               long take = offs[ii - 1] - global_below[ii - 1] - equal_before[ii - 1];
+               cuts[ii] = below[ii - 1] + std::max( 0l, std::min( take, equal[ii - 1] ) );
+            }
+            else
+               cuts[ii] = keys.size();
+         }
+         std::vector<int> cnts( num_ranks );
+         for( int ii = 0; ii < num_ranks; ++ii )
+            cnts[ii] = cuts[ii + 1] - cuts[ii];
+         return cnts;
+      }
+
+      inline
+      std::vector<long>
+      sample_sort_displs( std::vector<int> const& cnts )
+      {
+         std::vector<long> displs( cnts.size() + 1 );
+         displs[0] = 0;
+         for( size_t ii = 0; ii < cnts.size(); ++ii )
+            displs[ii + 1] = displs[ii] + cnts[ii];
+         return displs;
+      }
+
+   }
+
+   ///
+   /// Sort keys distributed over a communicator. Afterwards each
+   /// rank's keys are sorted, every key on rank r is no greater than
+   /// any on rank r + 1, and each rank holds N/P keys, with the
+   /// remainder on the lowest ranks.
+   ///
+   /// Keys are sorted locally, splitters chosen exactly with
+   /// `select_many`, the sorted runs exchanged with one all-to-all
+   /// and the incoming runs merged with a k-way heap merge. Per-rank
+   /// message sizes are limited to what fits in an int.
+   ///
+   template< class Key >
+   void
+   sample_sort( std::vector<Key>& keys,
+                mpi::comm const& comm = mpi::comm::world )
+   {
+      std::sort( keys.begin(), keys.end() );
+      if( comm.size() == 1 )
+         return;
+
+      std::vector<int> cnts = impl::sample_sort_counts( keys, comm );
+      std::vector<int> inc_cnts;
+      std::vector<Key> inc = comm.all_to_allv( keys, cnts, &inc_cnts );
+      impl::kway_merge( inc, impl::sample_sort_displs( inc_cnts ), keys, (std::vector<long>*)0 );
+   }
+
+   ///
+   /// Sort key/value pairs distributed over a communicator, as for
+   /// the keys-only version. With `stable` pairs with equal keys keep
+   /// their order by rank and then by position within the rank;
+   /// otherwise their order is unspecified.
+   ///
+   template< class Key,
+             class Value >
+   void
+   sample_sort( std::vector<Key>& keys,
+                std::vector<Value>& values,
+                mpi::comm const& comm = mpi::comm::world,
+                bool stable = false )
+   {
+      ASSERT( keys.size() == values.size(), "Must have one value per key." );
+
+      // Sort a permutation locally and apply it to both.
+      std::vector<long> perm( keys.size() );
+      for( size_t ii = 0; ii < perm.size(); ++ii )
+         perm[ii] = ii;
+      if( stable )
+         std::stable_sort( perm.begin(), perm.end(), impl::sample_sort_index_less<Key>( keys ) );
+      else
+         std::sort( perm.begin(), perm.end(), impl::sample_sort_index_less<Key>( keys ) );
+      impl::sample_sort_permute( keys, perm );
+      impl::sample_sort_permute( values, perm );
+      if( comm.size() == 1 )
+         return;
+
+      std::vector<int> cnts = impl::sample_sort_counts( keys, comm );
+      std::vector<int> inc_cnts;
+      std::vector<Key> inc_keys = comm.all_to_allv( keys, cnts, &inc_cnts );
+      std::vector<Value> inc_values = comm.all_to_allv( values, cnts );
+
+      // Incoming runs are in rank order, so a merge favouring earlier
+      // runs keeps the sort stable.
+      impl::kway_merge( inc_keys, impl::sample_sort_displs( inc_cnts ), keys, &perm );
+      values.resize( inc_values.size() );
+      for( size_t ii = 0; ii < perm.size(); ++ii )
+         values[ii] = inc_values[perm[ii]];
+   }
+
+}
+
+#endif
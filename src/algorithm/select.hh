@@ -18,13 +18,21 @@
 #ifndef hpc_algorithm_select_hh
 #define hpc_algorithm_select_hh
 
+#include <math.h>
+#include <string.h>
 #include <algorithm>
+#include <iterator>
+#include <vector>
+#include <random>
 #include "libhpc/debug/assert.hh"
 #include "libhpc/mpi/comm.hh"
 #include "ridders.hh"
 
 namespace hpc {
 
+   static unsigned const default_select_samples = 4096;
+   static unsigned const default_select_many_samples = 256;
+
    template< typename Iterator >
    struct select_function
    {
@@ -58,12 +66,18 @@ namespace hpc {
       mpi::comm const& comm;
    };
 
+   ///
+   /// Selection by root finding on the count of values less than x.
+   /// Each iteration is a full pass and a reduction, and the result
+   /// is only approximate for integer types. Kept for comparison;
+   /// prefer `select`.
+   ///
    template< class Iterator >
    typename Iterator::value_type
-   select( Iterator const& start,
-           Iterator const& finish,
-           long position,
-           mpi::comm const& comm = mpi::comm::world )
+   ridders_select( Iterator const& start,
+                   Iterator const& finish,
+                   long position,
+                   mpi::comm const& comm = mpi::comm::world )
    {
       typedef typename Iterator::value_type value_type;
 
@@ -79,6 +93,476 @@ namespace hpc {
       return ridders( func, x1, x2 );
    }
 
+   namespace impl {
+
+      ///
+      /// Which side of the pivot window [lo, hi] a value is on: 0 for
+      /// below, 1 for inside and 2 for above.
+      ///
+      template< class T >
+      inline
+      unsigned
+      select_class( T const& x,
+                    T const& lo,
+                    T const& hi )
+      {
+         return (x < lo) ? 0 : ((hi < x) ? 2 : 1);
+      }
+
+      template< class T >
+      struct select_side
+      {
+         select_side( T const& lo,
+                      T const& hi,
+                      unsigned side )
+            : lo( lo ),
+              hi( hi ),
+              side( side )
+         {
+         }
+
+         bool
+         operator()( T const& x ) const
+         {
+            return select_class( x, lo, hi ) == side;
+         }
+
+         T const& lo;
+         T const& hi;
+         unsigned side;
+      };
+
+      ///
+      /// Choose a pivot window from a sorted sample of `size` values
+      /// that is expected to contain the value at `position`.
+      ///
+      template< class Iterator,
+                class T >
+      void
+      select_window( Iterator const& start,
+                     Iterator const& finish,
+                     long size,
+                     long position,
+                     bool single,
+                     T& lo,
+                     T& hi )
+      {
+         // The sample rank of the target has a standard deviation
+         // of about half the root of the sample size, so a window of
+         // two deviations either side almost always contains it.
+         long total = std::distance( start, finish );
+         long pos = (long)(((double)position/(double)size)*(double)total);
+         pos = std::min( pos, total - 1 );
+         long delta = single ? 0 : std::max( 1l, (long)sqrt( (double)total ) );
+         lo = start[std::max( pos - delta, 0l )];
+         hi = start[std::min( pos + delta, total - 1 )];
+      }
+
+      ///
+      /// Choose a pivot window expected to contain the value at
+      /// `position` out of `size` from a sample drawn across all
+      /// ranks. With `single` both ends are the sample's estimate of
+      /// the value itself, which is guaranteed to make progress.
+      ///
+      template< class Iterator,
+                class T >
+      void
+      select_pivots( Iterator const& start,
+                     Iterator const& finish,
+                     long size,
+                     long position,
+                     unsigned num_samples,
+                     bool single,
+                     std::minstd_rand& rng,
+                     mpi::comm const& comm,
+                     T& lo,
+                     T& hi )
+      {
+         // Sample in proportion to the values each rank holds.
+         long local_size = std::distance( start, finish );
+         long num = (local_size*(long)num_samples + size - 1)/size;
+         std::vector<T> samples( num );
+         if( local_size )
+         {
+            std::uniform_int_distribution<long> dist( 0, local_size - 1 );
+            for( long ii = 0; ii < num; ++ii )
+               samples[ii] = start[dist( rng )];
+         }
+         samples = comm.all_gatherv( samples );
+         std::sort( samples.begin(), samples.end() );
+         select_window( samples.begin(), samples.end(), size, position, single, lo, hi );
+      }
+
+      ///
+      /// Gather values grouped by the position they belong to from all
+      /// ranks, and bucket them by position. Each rank sends one block
+      /// of bytes holding its count for every position followed by
+      /// the values, so this is a single `all_gatherv`, which is one
+      /// gather of the block sizes and one of the blocks.
+      ///
+      template< class T >
+      void
+      gather_grouped( std::vector<T> const& values,
+                      std::vector<int> const& counts,
+                      mpi::comm const& comm,
+                      std::vector<T>& out,
+                      std::vector<long>& displs )
+      {
+         unsigned num_pos = counts.size();
+         size_t cnts_size = num_pos*sizeof(int);
+         std::vector<unsigned char> block( cnts_size + values.size()*sizeof(T) );
+         if( num_pos )
+            memcpy( block.data(), counts.data(), cnts_size );
+         if( !values.empty() )
+            memcpy( block.data() + cnts_size, values.data(), values.size()*sizeof(T) );
+         std::vector<unsigned char> all = comm.all_gatherv( block );
+
+         // The blocks arrive in rank order, each sized by its counts.
+         displs.assign( num_pos + 1, 0 );
+         std::vector<int> cnts( num_pos );
+         for( size_t pos = 0; pos < all.size(); )
+         {
+            if( num_pos )
+               memcpy( cnts.data(), all.data() + pos, cnts_size );
+            pos += cnts_size;
+            for( unsigned ii = 0; ii < num_pos; ++ii )
+            {
+               displs[ii + 1] += cnts[ii];
+               pos += cnts[ii]*sizeof(T);
+            }
+         }
+         for( unsigned ii = 0; ii < num_pos; ++ii )
+            displs[ii + 1] += displs[ii];
+         out.resize( displs[num_pos] );
+         std::vector<long> offs( displs.begin(), displs.end() - 1 );
+         for( size_t pos = 0; pos < all.size(); )
+         {
+            if( num_pos )
+               memcpy( cnts.data(), all.data() + pos, cnts_size );
+            pos += cnts_size;
+            for( unsigned ii = 0; ii < num_pos; ++ii )
+            {
+               if( cnts[ii] )
+                  memcpy( out.data() + offs[ii], all.data() + pos, cnts[ii]*sizeof(T) );
+               offs[ii] += cnts[ii];
+               pos += cnts[ii]*sizeof(T);
+            }
+         }
+      }
+
+   }
+
+   ///
+   /// The value that would be at `position` if the values on all ranks
+   /// were sorted together. Exact for any type with a strict weak
+   /// ordering, including integers with duplicates. `Iterator` must be
+   /// random access; the values themselves are not reordered.
+   ///
+   /// Each round samples the remaining candidates on all ranks,
+   /// chooses a pivot window around the target from the sample and
+   /// keeps only the candidates on the target's side. The first round
+   /// counts the input and copies out the surviving candidates, later
+   /// rounds partition that copy in place, so the input is normally
+   /// read only once. Once few enough candidates
+   /// remain they are gathered and selected from directly. Each round
+   /// costs one gather of the sample and one reduction, and shrinks
+   /// the candidates by a factor of about the root of the sample size
+   /// over four, so large inputs take only a few rounds.
+   ///
+   template< class Iterator >
+   typename std::iterator_traits<Iterator>::value_type
+   select( Iterator const& start,
+           Iterator const& finish,
+           long position,
+           mpi::comm const& comm = mpi::comm::world,
+           unsigned* num_rounds = 0,
+           unsigned num_samples = default_select_samples )
+   {
+      typedef typename std::iterator_traits<Iterator>::value_type value_type;
+      typedef typename std::vector<value_type>::iterator work_iterator;
+
+      ASSERT( position >= 0, "Invalid selection position." );
+
+      long size = comm.all_reduce( (long)std::distance( start, finish ) );
+      ASSERT( position < size, "Selection position beyond the end of the values." );
+
+      std::minstd_rand rng( comm.rank() + 1 );
+      std::vector<value_type> work;
+      std::vector<long> cnts( 2 );
+      bool copied = false, single = false, found = false;
+      unsigned rounds = 0;
+      value_type lo, hi;
+      while( size > (long)num_samples )
+      {
+         ++rounds;
+         unsigned side;
+         if( !copied )
+         {
+            // Count against the input, copying out the window as we
+            // go since the target is almost always inside it.
+            impl::select_pivots( start, finish, size, position, num_samples, single, rng, comm, lo, hi );
+            std::fill( cnts.begin(), cnts.end(), 0 );
+            for( Iterator it = start; it != finish; ++it )
+            {
+               unsigned cls = impl::select_class( *it, lo, hi );
+               if( cls < 2 )
+                  ++cnts[cls];
+               if( cls == 1 )
+                  work.push_back( *it );
+            }
+            comm.all_reduce( view<std::vector<long> >( cnts ) );
+            side = (position < cnts[0]) ? 0 : ((position < cnts[0] + cnts[1]) ? 1 : 2);
+            if( side == 1 && !(lo < hi) )
+            {
+               found = true;
+               break;
+            }
+            if( side != 1 )
+            {
+               work.clear();
+               for( Iterator it = start; it != finish; ++it )
+               {
+                  if( impl::select_class( *it, lo, hi ) == side )
+                     work.push_back( *it );
+               }
+            }
+            copied = true;
+         }
+         else
+         {
+            impl::select_pivots( work.begin(), work.end(), size, position, num_samples, single, rng, comm, lo, hi );
+            work_iterator mid_start = std::partition( work.begin(), work.end(),
+                                                      impl::select_side<value_type>( lo, hi, 0 ) );
+            work_iterator mid_finish = std::partition( mid_start, work.end(),
+                                                       impl::select_side<value_type>( lo, hi, 1 ) );
+            cnts[0] = mid_start - work.begin();
+            cnts[1] = mid_finish - mid_start;
+            comm.all_reduce( view<std::vector<long> >( cnts ) );
+            side = (position < cnts[0]) ? 0 : ((position < cnts[0] + cnts[1]) ? 1 : 2);
+            if( side == 1 && !(lo < hi) )
+            {
+               found = true;
+               break;
+            }
+            work_iterator first = (side == 0) ? work.begin() : ((side == 1) ? mid_start : mid_finish);
+            work_iterator last = (side == 0) ? mid_start : ((side == 1) ? mid_finish : work.end());
+            work.erase( last, work.end() );
+            work.erase( work.begin(), first );
+         }
+
+         // Narrow the target down to the chosen side. If the window
+         // failed to exclude anything, use a single pivot next time.
+         long new_size = (side == 0) ? cnts[0] : ((side == 1) ? cnts[1] : size - cnts[0] - cnts[1]);
+         if( side > 0 )
+            position -= cnts[0];
+         if( side > 1 )
+            position -= cnts[1];
+         single = (new_size == size);
+         size = new_size;
+      }
+
+      if( num_rounds )
+         *num_rounds = rounds;
+
+      // The target is in a window of equal values.
+      if( found )
+         return lo;
+
+      // Few enough remain to gather them all.
+      if( !copied )
+         work.assign( start, finish );
+      std::vector<value_type> all = comm.all_gatherv( work );
+      std::nth_element( all.begin(), all.begin() + position, all.end() );
+      return all[position];
+   }
+
+   namespace impl {
+
+      ///
+      /// `select_many` on locally sorted values.
+      ///
+      template< class Iterator >
+      std::vector<typename std::iterator_traits<Iterator>::value_type>
+      select_many_sorted( Iterator const& start,
+                          Iterator const& finish,
+                          std::vector<long> const& positions,
+                          mpi::comm const& comm,
+                          unsigned* num_rounds,
+                          unsigned num_samples )
+      {
+         typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+         unsigned num_pos = positions.size();
+         long local_size = finish - start;
+         long size = comm.all_reduce( local_size );
+
+         // Each position's candidates are start[first, last), with the
+         // target at `rel` out of `cands` candidates over all ranks.
+         std::vector<long> first( num_pos, 0 ), last( num_pos, local_size );
+         std::vector<long> rel( positions ), cands( num_pos, size );
+         std::vector<char> done( num_pos, 0 ), single( num_pos, 0 );
+         std::vector<value_type> result( num_pos ), lo( num_pos ), hi( num_pos );
+         for( unsigned ii = 0; ii < num_pos; ++ii )
+         {
+            ASSERT( positions[ii] >= 0, "Invalid selection position." );
+            ASSERT( positions[ii] < size, "Selection position beyond the end of the values." );
+         }
+
+         std::minstd_rand rng( comm.rank() + 1 );
+         std::vector<value_type> samples, gathered;
+         std::vector<int> smp_cnts, active;
+         std::vector<long> displs, cnts;
+         unsigned rounds = 0;
+         for( ;; )
+         {
+            active.clear();
+            for( unsigned ii = 0; ii < num_pos; ++ii )
+            {
+               if( !done[ii] && cands[ii] > (long)num_samples )
+                  active.push_back( ii );
+            }
+            if( active.empty() )
+               break;
+            ++rounds;
+
+            // Sample every active position's candidates in proportion
+            // to the number each rank holds.
+            samples.clear();
+            smp_cnts.assign( active.size(), 0 );
+            for( unsigned ii = 0; ii < active.size(); ++ii )
+            {
+               int pp = active[ii];
+               long num_local = last[pp] - first[pp];
+               long num = (num_local*(long)num_samples + cands[pp] - 1)/cands[pp];
+               if( num_local )
+               {
+                  std::uniform_int_distribution<long> dist( first[pp], last[pp] - 1 );
+                  for( long jj = 0; jj < num; ++jj )
+                     samples.push_back( start[dist( rng )] );
+                  smp_cnts[ii] = num;
+               }
+            }
+            gather_grouped( samples, smp_cnts, comm, gathered, displs );
+
+            // Choose windows and count the local candidates below and
+            // inside each.
+            cnts.resize( 2*active.size() );
+            for( unsigned ii = 0; ii < active.size(); ++ii )
+            {
+               int pp = active[ii];
+               typename std::vector<value_type>::iterator smp_start = gathered.begin() + displs[ii];
+               typename std::vector<value_type>::iterator smp_finish = gathered.begin() + displs[ii + 1];
+               std::sort( smp_start, smp_finish );
+               select_window( smp_start, smp_finish, cands[pp], rel[pp], single[pp], lo[pp], hi[pp] );
+               long mid_start = std::lower_bound( start + first[pp], start + last[pp], lo[pp] ) - start;
+               long mid_finish = std::upper_bound( start + mid_start, start + last[pp], hi[pp] ) - start;
+               cnts[2*ii] = mid_start - first[pp];
+               cnts[2*ii + 1] = mid_finish - mid_start;
+            }
+            std::vector<long> global( cnts );
+            comm.all_reduce( view<std::vector<long> >( global ) );
+
+            // Narrow each position to the side holding its target.
+            for( unsigned ii = 0; ii < active.size(); ++ii )
+            {
+               int pp = active[ii];
+               long below = global[2*ii], inside = global[2*ii + 1];
+               long mid_start = first[pp] + cnts[2*ii];
+               long mid_finish = mid_start + cnts[2*ii + 1];
+               long new_cands;
+               if( rel[pp] < below )
+               {
+                  last[pp] = mid_start;
+                  new_cands = below;
+               }
+               else if( rel[pp] < below + inside )
+               {
+                  if( !(lo[pp] < hi[pp]) )
+                  {
+                     result[pp] = lo[pp];
+                     done[pp] = 1;
+                     continue;
+                  }
+                  first[pp] = mid_start;
+                  last[pp] = mid_finish;
+                  rel[pp] -= below;
+                  new_cands = inside;
+               }
+               else
+               {
+                  first[pp] = mid_finish;
+                  rel[pp] -= below + inside;
+                  new_cands = cands[pp] - below - inside;
+               }
+               single[pp] = (new_cands == cands[pp]);
+               cands[pp] = new_cands;
+            }
+         }
+
+         if( num_rounds )
+            *num_rounds = rounds;
+
+         // Gather the remaining candidates of every unresolved position.
+         samples.clear();
+         smp_cnts.clear();
+         active.clear();
+         for( unsigned ii = 0; ii < num_pos; ++ii )
+         {
+            if( done[ii] )
+               continue;
+            samples.insert( samples.end(), start + first[ii], start + last[ii] );
+            smp_cnts.push_back( last[ii] - first[ii] );
+            active.push_back( ii );
+         }
+         if( !active.empty() )
+         {
+            gather_grouped( samples, smp_cnts, comm, gathered, displs );
+            for( unsigned ii = 0; ii < active.size(); ++ii )
+            {
+               int pp = active[ii];
+               typename std::vector<value_type>::iterator smp_start = gathered.begin() + displs[ii];
+               std::nth_element( smp_start, smp_start + rel[pp], gathered.begin() + displs[ii + 1] );
+               result[pp] = smp_start[rel[pp]];
+            }
+         }
+         return result;
+      }
+
+   }
+
+   ///
+   /// The values at each of `positions` as if the values on all ranks
+   /// were sorted together, in the order the positions are given.
+   /// Exact, as for `select`, and `Iterator` must be random access.
+   ///
+   /// All positions are refined together, so each round costs three
+   /// collectives however many positions are asked for: the two of
+   /// one `all_gatherv` of the samples and one reduction. The
+   /// local values are sorted into a copy, unless already sorted,
+   /// after which every position's candidates are a contiguous slice
+   /// and are narrowed by binary search. Each round gathers about
+   /// `num_samples` values per unresolved position and reduces two
+   /// counts per position. Positions whose candidates fit in one
+   /// sample are resolved by gathering them.
+   ///
+   template< class Iterator >
+   std::vector<typename std::iterator_traits<Iterator>::value_type>
+   select_many( Iterator const& start,
+                Iterator const& finish,
+                std::vector<long> const& positions,
+                mpi::comm const& comm = mpi::comm::world,
+                unsigned* num_rounds = 0,
+                unsigned num_samples = default_select_many_samples )
+   {
+      typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+      if( std::is_sorted( start, finish ) )
+         return impl::select_many_sorted( start, finish, positions, comm, num_rounds, num_samples );
+      std::vector<value_type> local( start, finish );
+      std::sort( local.begin(), local.end() );
+      return impl::select_many_sorted( local.begin(), local.end(), positions, comm, num_rounds, num_samples );
+   }
+
 }
 
 #endif
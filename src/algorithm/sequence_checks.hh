@@ -51,7 +51,7 @@ namespace hpc {
       typename Seq::const_iterator it = seq.begin();
       if( it != seq.end() )
       {
-         typename Seq::value_type last = it++;
+         typename Seq::const_iterator last = it++;
          while( it != seq.end() )
          {
             if( *it++ <= *last++ )
@@ -21,12 +21,57 @@
 #ifndef _GLIBCXX_DEBUG
 
 #include <algorithm>
+#include <iterator>
 #include <tuple>
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_default_constructible.hpp>
+#include <boost/type_traits/integral_constant.hpp>
 #include "sort_permute_iter.hh"
+#include "radix_sort.hh"
 
 namespace hpc {
 
+   namespace impl {
+
+      template< class KeyIter,
+                class ValIter >
+      void
+      sort_by_key( KeyIter const& key_begin,
+                   KeyIter const& key_end,
+                   ValIter const& val_begin,
+                   ValIter const& val_end,
+                   boost::false_type )
+      {
+         std::sort(
+            make_sort_permute_iter( key_begin, val_begin ),
+            make_sort_permute_iter( key_end, val_end ),
+            sort_permute_iter_compare<KeyIter,ValIter>()
+            );
+      }
+
+      template< class KeyIter,
+                class ValIter >
+      void
+      sort_by_key( KeyIter const& key_begin,
+                   KeyIter const& key_end,
+                   ValIter const& val_begin,
+                   ValIter const& val_end,
+                   boost::true_type )
+      {
+         if( use_radix_sort( key_begin, key_end ) )
+            radix_sort_by_key( key_begin, key_end, val_begin );
+         else
+            sort_by_key( key_begin, key_end, val_begin, val_end, boost::false_type() );
+      }
+
+   }
+
+   ///
+   /// Sort values by their keys. Long runs of integer keys whose range
+   /// spans at most `radix_sort_max_span` bits, with default
+   /// constructible values, use `radix_sort_by_key`, which is stable;
+   /// otherwise the order of values with equal keys is unspecified.
+   ///
    template< class KeyIter,
 	     class ValIter >
    void
@@ -35,11 +80,12 @@ namespace hpc {
 		ValIter const& val_begin,
 		ValIter const& val_end )
    {
-      std::sort(
-	 make_sort_permute_iter( key_begin, val_begin ),
-	 make_sort_permute_iter( key_end, val_end ),
-	 sort_permute_iter_compare<KeyIter,ValIter>()
-	 );
+      typedef typename std::iterator_traits<KeyIter>::value_type key_type;
+      typedef typename std::iterator_traits<ValIter>::value_type value_type;
+      impl::sort_by_key( key_begin, key_end, val_begin, val_end,
+                         boost::integral_constant<bool,
+                            is_radix_key<key_type>::value &&
+                            boost::is_default_constructible<value_type>::value>() );
    }
 
    template< class KeySeq,
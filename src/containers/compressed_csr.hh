@@ -0,0 +1,478 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef containers_compressed_csr_hh
+#define containers_compressed_csr_hh
+
+#include <stdint.h>
+#include <limits>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
+#include <boost/static_assert.hpp>
+#include "libhpc/debug/assert.hh"
+#include "vector.hh"
+#include "csr.hh"
+
+namespace hpc {
+
+   ///
+   /// Displacement array that stores 32 bit values whenever the
+   /// final displacement fits, falling back to 64 bit otherwise.
+   ///
+   class compact_displs
+   {
+   public:
+
+      compact_displs()
+	 : _wide( false )
+      {
+      }
+
+      void
+      deallocate()
+      {
+	 this->_narrow.deallocate();
+	 this->_wide_displs.deallocate();
+	 this->_wide = false;
+      }
+
+      template< class Seq >
+      void
+      set( const Seq& displs )
+      {
+	 this->deallocate();
+	 if(!displs.size())
+	    return;
+	 this->_wide = (uint64_t)displs[displs.size() - 1] > std::numeric_limits<uint32_t>::max();
+	 if(this->_wide) {
+	    this->_wide_displs.resize(displs.size());
+	    std::copy(displs.begin(), displs.end(), this->_wide_displs.begin());
+	 }
+	 else {
+	    this->_narrow.resize(displs.size());
+	    std::copy(displs.begin(), displs.end(), this->_narrow.begin());
+	 }
+      }
+
+      bool
+      wide() const
+      {
+	 return this->_wide;
+      }
+
+      index
+      size() const
+      {
+	 return this->_wide ? this->_wide_displs.size() : this->_narrow.size();
+      }
+
+      size_t
+      bytes() const
+      {
+	 return this->_wide ? this->_wide_displs.size()*sizeof(uint64_t) : this->_narrow.size()*sizeof(uint32_t);
+      }
+
+      index
+      operator[]( index idx ) const
+      {
+	 return this->_wide ? (index)this->_wide_displs[idx] : (index)this->_narrow[idx];
+      }
+
+   private:
+      vector<uint32_t> _narrow;
+      vector<uint64_t> _wide_displs;
+      bool _wide;
+   };
+
+   ///
+   /// Read-only csr with compacted displacements. Rows are accessed
+   /// as views, the same as csr.
+   ///
+   template< class T >
+   class compact_csr
+   {
+   public:
+
+      compact_csr()
+	 : _num_rows( 0 )
+      {
+      }
+
+      compact_csr( const csr<T>& src )
+      {
+	 this->set(src);
+      }
+
+      void
+      deallocate()
+      {
+	 this->_displs.deallocate();
+	 this->_array.deallocate();
+	 this->_num_rows = 0;
+      }
+
+      void
+      set( const csr<T>& src )
+      {
+	 this->_num_rows = src.num_rows();
+	 this->_displs.set(src.displs());
+	 this->_array.duplicate(src.array());
+      }
+
+      void
+      unpack( csr<T>& dst ) const
+      {
+	 vector<index> displs(this->_displs.size());
+	 for(index ii = 0; ii < displs.size(); ++ii)
+	    displs[ii] = this->_displs[ii];
+	 vector<T> array;
+	 array.duplicate(this->_array);
+	 dst.take(displs, array);
+      }
+
+      index
+      num_rows() const
+      {
+	 return this->_num_rows;
+      }
+
+      bool
+      empty() const
+      {
+	 return !this->_num_rows;
+      }
+
+      const compact_displs&
+      displs() const
+      {
+	 return this->_displs;
+      }
+
+      const vector<T>&
+      array() const
+      {
+	 return this->_array;
+      }
+
+      size_t
+      bytes() const
+      {
+	 return this->_displs.bytes() + this->_array.size()*sizeof(T);
+      }
+
+      index
+      row_size( index row ) const
+      {
+	 return this->_displs[row + 1] - this->_displs[row];
+      }
+
+      const typename vector<T>::view
+      operator[]( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 return typename vector<T>::view(this->_array, this->row_size(row), this->_displs[row]);
+      }
+
+      const T&
+      operator()( index row,
+		  index col ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 ASSERT(col >= 0 && col < this->row_size(row), "Invalid column index.");
+	 return this->_array[this->_displs[row] + col];
+      }
+
+   private:
+      index _num_rows;
+      compact_displs _displs;
+      vector<T> _array;
+   };
+
+   ///
+   /// Forward iterator over one row of a varint_csr, decoding each
+   /// value as it goes.
+   ///
+   template< class T >
+   class varint_csr_iterator
+      : public boost::iterator_facade< varint_csr_iterator<T>,
+				       T,
+				       std::forward_iterator_tag,
+				       T >
+   {
+      friend class boost::iterator_core_access;
+
+   public:
+
+      typedef typename boost::make_unsigned<T>::type unsigned_type;
+
+      varint_csr_iterator()
+	 : _cur( 0 ),
+	   _next( 0 ),
+	   _end( 0 ),
+	   _val( 0 )
+      {
+      }
+
+      varint_csr_iterator( const uint8_t* ptr,
+			   const uint8_t* end )
+	 : _cur( ptr ),
+	   _next( ptr ),
+	   _end( end ),
+	   _val( 0 )
+      {
+	 this->_decode();
+      }
+
+   protected:
+
+      void
+      _decode()
+      {
+	 if(this->_cur == this->_end)
+	    return;
+	 unsigned_type delta = 0;
+	 unsigned shift = 0;
+	 uint8_t byte;
+	 do {
+	    byte = *this->_next++;
+	    delta |= (unsigned_type)(byte & 0x7f) << shift;
+	    shift += 7;
+	 }
+	 while(byte & 0x80);
+	 this->_val = (T)((unsigned_type)this->_val + delta);
+      }
+
+      void
+      increment()
+      {
+	 this->_cur = this->_next;
+	 this->_decode();
+      }
+
+      bool
+      equal( const varint_csr_iterator& op ) const
+      {
+	 return this->_cur == op._cur;
+      }
+
+      T
+      dereference() const
+      {
+	 return this->_val;
+      }
+
+   protected:
+
+      const uint8_t* _cur;
+      const uint8_t* _next;
+      const uint8_t* _end;
+      T _val;
+   };
+
+   ///
+   /// Read-only csr for sorted integer rows. Each row is stored as
+   /// the differences between consecutive values, encoded as 7 bit
+   /// groups with a continuation bit (LEB128). Byte displacements use
+   /// compact_displs. Rows are decoded on the fly by iterating.
+   ///
+   /// Rows must be sorted in ascending order. The first value of a
+   /// row is stored relative to zero, so negative leading values are
+   /// correct but encode to the full width of the type.
+   ///
+   template< class T >
+   class varint_csr
+   {
+   public:
+
+      BOOST_STATIC_ASSERT( boost::is_integral<T>::value );
+
+      typedef varint_csr_iterator<T> iterator;
+      typedef iterator const_iterator;
+      typedef boost::iterator_range<iterator> row_type;
+      typedef typename boost::make_unsigned<T>::type unsigned_type;
+
+      varint_csr()
+	 : _num_rows( 0 ),
+	   _size( 0 )
+      {
+      }
+
+      varint_csr( const csr<T>& src )
+      {
+	 this->set(src);
+      }
+
+      void
+      deallocate()
+      {
+	 this->_displs.deallocate();
+	 this->_bytes.deallocate();
+	 this->_num_rows = 0;
+	 this->_size = 0;
+      }
+
+      void
+      set( const csr<T>& src )
+      {
+	 this->deallocate();
+	 this->_num_rows = src.num_rows();
+	 if(!this->_num_rows)
+	    return;
+	 this->_size = src.array().size();
+
+	 // Count the encoded size of each row first so we only
+	 // allocate once.
+	 vector<index> displs(this->_num_rows + 1);
+	 displs[0] = 0;
+	 for(index ii = 0; ii < this->_num_rows; ++ii) {
+	    index size = 0;
+	    T prev = 0;
+	    for(index jj = 0; jj < src.row_size(ii); ++jj) {
+	       T val = src(ii, jj);
+	       ASSERT(jj == 0 || val >= prev, "Row values must be sorted.");
+	       size += _encoded_size((unsigned_type)val - (unsigned_type)prev);
+	       prev = val;
+	    }
+	    displs[ii + 1] = displs[ii] + size;
+	 }
+
+	 // Encode.
+	 this->_bytes.resize(displs[this->_num_rows]);
+	 uint8_t* ptr = this->_bytes.data();
+	 for(index ii = 0; ii < this->_num_rows; ++ii) {
+	    T prev = 0;
+	    for(index jj = 0; jj < src.row_size(ii); ++jj) {
+	       T val = src(ii, jj);
+	       ptr = _encode((unsigned_type)val - (unsigned_type)prev, ptr);
+	       prev = val;
+	    }
+	 }
+	 this->_displs.set(displs);
+      }
+
+      void
+      unpack( csr<T>& dst ) const
+      {
+	 vector<index> displs(this->_num_rows + 1);
+	 if(this->_num_rows) {
+	    displs[0] = 0;
+	    for(index ii = 0; ii < this->_num_rows; ++ii)
+	       displs[ii + 1] = displs[ii] + this->row_size(ii);
+	 }
+	 vector<T> array(this->_size);
+	 typename vector<T>::iterator out = array.begin();
+	 for(index ii = 0; ii < this->_num_rows; ++ii)
+	    out = std::copy(this->begin(ii), this->end(ii), out);
+	 dst.take(displs, array);
+      }
+
+      index
+      num_rows() const
+      {
+	 return this->_num_rows;
+      }
+
+      bool
+      empty() const
+      {
+	 return !this->_num_rows;
+      }
+
+      index
+      size() const
+      {
+	 return this->_size;
+      }
+
+      size_t
+      bytes() const
+      {
+	 return this->_displs.bytes() + this->_bytes.size();
+      }
+
+      ///
+      /// Number of values in a row. Counts the terminating bytes of
+      /// each encoded value, so doesn't need to decode.
+      ///
+      index
+      row_size( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 index size = 0;
+	 for(index ii = this->_displs[row]; ii < this->_displs[row + 1]; ++ii)
+	    size += !(this->_bytes[ii] & 0x80);
+	 return size;
+      }
+
+      iterator
+      begin( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 return iterator(this->_bytes.data() + this->_displs[row],
+			 this->_bytes.data() + this->_displs[row + 1]);
+      }
+
+      iterator
+      end( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 const uint8_t* end = this->_bytes.data() + this->_displs[row + 1];
+	 return iterator(end, end);
+      }
+
+      row_type
+      operator[]( index row ) const
+      {
+	 return row_type(this->begin(row), this->end(row));
+      }
+
+   protected:
+
+      static index
+      _encoded_size( unsigned_type val )
+      {
+	 index size = 1;
+	 while(val >= 0x80) {
+	    val >>= 7;
+	    ++size;
+	 }
+	 return size;
+      }
+
+      static uint8_t*
+      _encode( unsigned_type val,
+	       uint8_t* ptr )
+      {
+	 while(val >= 0x80) {
+	    *ptr++ = (uint8_t)(val | 0x80);
+	    val >>= 7;
+	 }
+	 *ptr++ = (uint8_t)val;
+	 return ptr;
+      }
+
+   private:
+      index _num_rows;
+      index _size;
+      compact_displs _displs;
+      vector<uint8_t> _bytes;
+   };
+}
+
+#endif
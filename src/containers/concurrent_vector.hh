@@ -0,0 +1,443 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_containers_concurrent_vector_hh
+#define libhpc_containers_concurrent_vector_hh
+
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <boost/atomic.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/system/reallocate.hh"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace hpc {
+
+   ///
+   /// Append-only vector that many threads can grow at once, for
+   /// collecting results from inside parallel loops.
+   ///
+   /// Elements live in segments of geometrically increasing size;
+   /// segment k holds `first_segment_size << k` elements. `push_back`
+   /// and `grow_by` claim indices with a single atomic add and then
+   /// install any missing segments with a compare-and-swap, so neither
+   /// takes a lock and elements never move once constructed. Element
+   /// construction must not throw, and the allocator must be safe to
+   /// call from several threads.
+   ///
+   /// Growing is thread safe. Reading an element is safe once the
+   /// thread that appended it has been synchronised with, such as
+   /// after the end of a parallel region. `size` counts claimed
+   /// elements, which may still be under construction while others
+   /// grow the vector. `flatten`, `clear` and destruction must not
+   /// overlap any growth.
+   ///
+   template< class T,
+             class Alloc = std::allocator<T> >
+   class concurrent_vector
+   {
+   public:
+
+      typedef T value_type;
+      typedef Alloc allocator_type;
+      typedef size_t size_type;
+      typedef T& reference;
+      typedef const T& const_reference;
+      typedef std::allocator_traits<Alloc> alloc_traits;
+
+      static const unsigned max_segments = 48;
+
+      template< class Vector,
+                class Value >
+      class iterator_base
+         : public boost::iterator_facade<iterator_base<Vector,Value>,
+                                         Value,
+                                         std::random_access_iterator_tag>
+      {
+         friend class boost::iterator_core_access;
+         template< class, class > friend class iterator_base;
+
+      public:
+
+         iterator_base()
+            : _vec( 0 ),
+              _idx( 0 )
+         {
+         }
+
+         iterator_base( Vector* vec,
+                        size_type idx )
+            : _vec( vec ),
+              _idx( idx )
+         {
+         }
+
+         template< class OtherVector,
+                   class OtherValue >
+         iterator_base( const iterator_base<OtherVector,OtherValue>& src )
+            : _vec( src._vec ),
+              _idx( src._idx )
+         {
+         }
+
+      protected:
+
+         Value&
+         dereference() const
+         {
+            return (*_vec)[_idx];
+         }
+
+         template< class OtherVector,
+                   class OtherValue >
+         bool
+         equal( const iterator_base<OtherVector,OtherValue>& op ) const
+         {
+            return _idx == op._idx;
+         }
+
+         void
+         increment()
+         {
+            ++_idx;
+         }
+
+         void
+         decrement()
+         {
+            --_idx;
+         }
+
+         void
+         advance( ptrdiff_t offs )
+         {
+            _idx += offs;
+         }
+
+         template< class OtherVector,
+                   class OtherValue >
+         ptrdiff_t
+         distance_to( const iterator_base<OtherVector,OtherValue>& op ) const
+         {
+            return (ptrdiff_t)op._idx - (ptrdiff_t)_idx;
+         }
+
+      protected:
+
+         Vector* _vec;
+         size_type _idx;
+      };
+
+      typedef iterator_base<concurrent_vector,value_type> iterator;
+      typedef iterator_base<const concurrent_vector,const value_type> const_iterator;
+
+   public:
+
+      ///
+      /// `first_segment_size` is rounded up to a power of two.
+      ///
+      concurrent_vector( size_type first_segment_size = 16,
+                         const allocator_type& alloc = allocator_type() )
+         : _log_first( 0 ),
+           _alloc( alloc ),
+           _size( 0 )
+      {
+         while( ((size_type)1 << _log_first) < first_segment_size )
+            ++_log_first;
+         for( unsigned ii = 0; ii < max_segments; ++ii )
+            _segs[ii].store( 0, boost::memory_order_relaxed );
+      }
+
+      ~concurrent_vector()
+      {
+         clear();
+      }
+
+      ///
+      /// Destroy all elements and free all segments. Not thread safe.
+      ///
+      void
+      clear()
+      {
+         size_type size = _size.load( boost::memory_order_relaxed );
+         for( unsigned kk = 0; kk < max_segments; ++kk )
+         {
+            T* seg = _segs[kk].load( boost::memory_order_relaxed );
+            if( !seg )
+               continue;
+            size_type base = _segment_base( kk );
+            size_type num = (size > base) ? std::min( size - base, _segment_size( kk ) ) : 0;
+            for( size_type ii = 0; ii < num; ++ii )
+               alloc_traits::destroy( _alloc, seg + ii );
+            _alloc.deallocate( seg, _segment_size( kk ) );
+            _segs[kk].store( 0, boost::memory_order_relaxed );
+         }
+         _size.store( 0, boost::memory_order_relaxed );
+      }
+
+      ///
+      /// Allocate segments to hold at least `size` elements. Thread
+      /// safe.
+      ///
+      void
+      reserve( size_type size )
+      {
+         if( !size )
+            return;
+         unsigned last = _segment( size - 1 );
+         for( unsigned kk = 0; kk <= last; ++kk )
+            _get_segment( kk );
+      }
+
+      size_type
+      size() const
+      {
+         return _size.load( boost::memory_order_acquire );
+      }
+
+      bool
+      empty() const
+      {
+         return size() == 0;
+      }
+
+      ///
+      /// Elements the allocated segments can hold without growing.
+      ///
+      size_type
+      capacity() const
+      {
+         unsigned kk = 0;
+         while( kk < max_segments && _segs[kk].load( boost::memory_order_acquire ) )
+            ++kk;
+         return _segment_base( kk );
+      }
+
+      ///
+      /// Append a value, returning its index. Thread safe.
+      ///
+      size_type
+      push_back( const value_type& value )
+      {
+         size_type idx = _size.fetch_add( 1, boost::memory_order_relaxed );
+         ASSERT( _segment( idx ) < max_segments, "Concurrent vector is full." );
+         unsigned kk = _segment( idx );
+         alloc_traits::construct( _alloc, _get_segment( kk ) + (idx - _segment_base( kk )), value );
+         return idx;
+      }
+
+      ///
+      /// Append `size` copies of `value`, returning the index of the
+      /// first. The new elements have consecutive indices but may
+      /// straddle segments. Thread safe.
+      ///
+      size_type
+      grow_by( size_type size,
+               const value_type& value = value_type() )
+      {
+         size_type first = _size.fetch_add( size, boost::memory_order_relaxed );
+         size_type last = first + size;
+         ASSERT( !size || _segment( last - 1 ) < max_segments, "Concurrent vector is full." );
+         while( first < last )
+         {
+            unsigned kk = _segment( first );
+            size_type base = _segment_base( kk );
+            size_type stop = std::min( last, base + _segment_size( kk ) );
+            T* seg = _get_segment( kk );
+            for( ; first < stop; ++first )
+               alloc_traits::construct( _alloc, seg + (first - base), value );
+         }
+         return last - size;
+      }
+
+      ///
+      /// Append a range, returning the index of the first value.
+      /// Thread safe.
+      ///
+      template< class Iterator >
+      typename boost::disable_if<boost::is_integral<Iterator>,size_type>::type
+      grow_by( Iterator start,
+               const Iterator& finish )
+      {
+         size_type size = std::distance( start, finish );
+         size_type first = _size.fetch_add( size, boost::memory_order_relaxed );
+         size_type last = first + size;
+         ASSERT( !size || _segment( last - 1 ) < max_segments, "Concurrent vector is full." );
+         while( first < last )
+         {
+            unsigned kk = _segment( first );
+            size_type base = _segment_base( kk );
+            size_type stop = std::min( last, base + _segment_size( kk ) );
+            T* seg = _get_segment( kk );
+            for( ; first < stop; ++first, ++start )
+               alloc_traits::construct( _alloc, seg + (first - base), *start );
+         }
+         return last - size;
+      }
+
+      reference
+      operator[]( size_type idx )
+      {
+         unsigned kk = _segment( idx );
+         return _segs[kk].load( boost::memory_order_acquire )[idx - _segment_base( kk )];
+      }
+
+      const_reference
+      operator[]( size_type idx ) const
+      {
+         unsigned kk = _segment( idx );
+         return _segs[kk].load( boost::memory_order_acquire )[idx - _segment_base( kk )];
+      }
+
+      iterator
+      begin()
+      {
+         return iterator( this, 0 );
+      }
+
+      iterator
+      end()
+      {
+         return iterator( this, size() );
+      }
+
+      const_iterator
+      begin() const
+      {
+         return const_iterator( this, 0 );
+      }
+
+      const_iterator
+      end() const
+      {
+         return const_iterator( this, size() );
+      }
+
+      ///
+      /// Copy the elements into a contiguous vector, in index order.
+      /// Each OpenMP thread copies a contiguous block of the output,
+      /// so with a placed allocator the output pages are first
+      /// touched by the threads that fill them. Not thread safe with
+      /// respect to growth.
+      ///
+      template< class OutAlloc >
+      void
+      flatten( std::vector<T,OutAlloc>& out ) const
+      {
+         size_type size = this->size();
+         hpc::reallocate( out, size );
+         if( !size )
+            return;
+         T* dst = out.data();
+
+#pragma omp parallel
+         {
+#ifdef _OPENMP
+            size_type num_threads = omp_get_num_threads();
+            size_type tid = omp_get_thread_num();
+#else
+            size_type num_threads = 1;
+            size_type tid = 0;
+#endif
+            _copy( (size*tid)/num_threads, (size*(tid + 1))/num_threads, dst );
+         }
+      }
+
+      std::vector<T>
+      flatten() const
+      {
+         std::vector<T> out;
+         flatten( out );
+         return out;
+      }
+
+   protected:
+
+      unsigned
+      _segment( size_type idx ) const
+      {
+         size_type blk = (idx >> _log_first) + 1;
+         return 8*sizeof(unsigned long) - 1 - __builtin_clzl( blk );
+      }
+
+      size_type
+      _segment_base( unsigned kk ) const
+      {
+         return (((size_type)1 << kk) - 1) << _log_first;
+      }
+
+      size_type
+      _segment_size( unsigned kk ) const
+      {
+         return (size_type)1 << (kk + _log_first);
+      }
+
+      ///
+      /// Segment `kk`, allocating it if no other thread has yet.
+      ///
+      T*
+      _get_segment( unsigned kk )
+      {
+         T* seg = _segs[kk].load( boost::memory_order_acquire );
+         if( !seg )
+         {
+            T* fresh = _alloc.allocate( _segment_size( kk ) );
+            if( _segs[kk].compare_exchange_strong( seg, fresh, boost::memory_order_acq_rel ) )
+               seg = fresh;
+            else
+               _alloc.deallocate( fresh, _segment_size( kk ) );
+         }
+         return seg;
+      }
+
+      ///
+      /// Copy elements [first, last) to `out + first`.
+      ///
+      void
+      _copy( size_type first,
+             size_type last,
+             T* out ) const
+      {
+         while( first < last )
+         {
+            unsigned kk = _segment( first );
+            size_type base = _segment_base( kk );
+            size_type stop = std::min( last, base + _segment_size( kk ) );
+            const T* seg = _segs[kk].load( boost::memory_order_acquire );
+            std::copy( seg + (first - base), seg + (stop - base), out + first );
+            first = stop;
+         }
+      }
+
+   protected:
+
+      unsigned _log_first;
+      allocator_type _alloc;
+      boost::atomic<T*> _segs[max_segments];
+      boost::atomic<size_type> _size;
+   };
+
+}
+
+#endif
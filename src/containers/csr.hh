@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <boost/range/algorithm.hpp>
 #include <boost/range/adaptors.hpp>
 #include "libhpc/system/stream_indent.hh"
@@ -28,20 +29,41 @@
 #include "predicates.hh"
 #include "functors.hh"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace hpc {
 
-   template< class T >
+   ///
+   /// `Alloc` supplies the storage for both the displacements and
+   /// the array, for example a memory::arena_allocator for CSRs
+   /// rebuilt every timestep. Temporaries used while building are
+   /// taken from the same allocator.
+   ///
+   template< class T,
+             class Alloc = std::allocator<T> >
    class csr
    {
    public:
 
-      csr( index num_rows=0 )
-	 : _num_rows(0)
+      typedef Alloc                                                  allocator_type;
+      typedef typename Alloc::template rebind<index>::other          displs_allocator_type;
+      typedef vector<index,displs_allocator_type>                    displs_type;
+      typedef vector<T,Alloc>                                        array_type;
+
+      csr( index num_rows=0,
+           const Alloc& alloc=Alloc() )
+	 : _num_rows(0),
+	   _displs(displs_allocator_type(alloc)),
+	   _array(alloc)
       {
 	 this->num_rows(num_rows);
       }
 
       csr( const csr& csr )
+	 : _displs(csr._displs.get_allocator()),
+	   _array(csr._array.get_allocator())
       {
 	 this->duplicate(csr);
       }
@@ -70,6 +92,12 @@ namespace hpc {
 	 return !this->_num_rows;
       }
 
+      allocator_type
+      get_allocator() const
+      {
+	 return this->_array.get_allocator();
+      }
+
       template< class Iter,
 		class Map,
 		class Predicate >
@@ -134,6 +162,127 @@ namespace hpc {
 	 this->_displs[0] = 0;
       }
 
+      ///
+      /// Threaded version of setup_3phase. Each thread counts the
+      /// entries of a contiguous block of the input into its own row
+      /// histogram, the histograms are combined into displacements
+      /// using a parallel prefix sum, and each thread then scatters
+      /// its block into the array. Entries retain their input order
+      /// within each row, so the result is identical to that of
+      /// setup_3phase. Requires random access iterators, and `op` and
+      /// `pred` must be safe to call concurrently. Falls back to
+      /// setup_3phase when OpenMP is not enabled or only one thread
+      /// is available.
+      ///
+      /// Note that the histograms require one index per row per
+      /// thread of temporary storage.
+      ///
+      template< class Iter,
+		class Map,
+		class Predicate >
+      void
+      setup_3phase_parallel( index num_rows,
+			     Iter begin,
+			     Iter end,
+			     Map op,
+			     Predicate pred=always<typename Iter::value_type>() )
+      {
+#ifdef _OPENMP
+	 if(omp_get_max_threads() == 1)
+#endif
+	 {
+	    this->setup_3phase( num_rows, begin, end, op, pred );
+	    return;
+	 }
+
+#ifdef _OPENMP
+	 // Clear myself out first.
+	 this->deallocate();
+
+	 // If there are no rows then finish here.
+	 if(!num_rows)
+	    return;
+	 this->_num_rows = num_rows;
+
+	 // Create my final displacement array.
+	 this->_displs.resize(num_rows + 1);
+
+	 index size = end - begin;
+	 displs_type hists(this->_displs.get_allocator()), block_sums(this->_displs.get_allocator());
+
+#pragma omp parallel
+	 {
+	    index num_threads = omp_get_num_threads();
+	    index tid = omp_get_thread_num();
+
+#pragma omp single
+	    {
+	       hists.resize(num_threads*num_rows);
+	       block_sums.resize(num_threads + 1);
+	    }
+
+	    // Each thread takes a contiguous block of the input; this is
+	    // what keeps the output ordering deterministic.
+	    Iter first = begin + (size*tid)/num_threads;
+	    Iter last = begin + (size*(tid + 1))/num_threads;
+	    index* cnts = hists.data() + tid*num_rows;
+
+	    // Phase one, count entries per row into my histogram.
+	    std::fill(cnts, cnts + num_rows, 0);
+	    for(Iter it = first; it != last; ++it) {
+	       if(pred(*it))
+		  ++cnts[op(*it)];
+	    }
+#pragma omp barrier
+
+	    // Convert the histograms to per-thread offsets within each
+	    // row, leaving the row totals in the displacements.
+#pragma omp for schedule(static)
+	    for(index row = 0; row < num_rows; ++row) {
+	       index sum = 0;
+	       for(index tt = 0; tt < num_threads; ++tt) {
+		  index cnt = hists[tt*num_rows + row];
+		  hists[tt*num_rows + row] = sum;
+		  sum += cnt;
+	       }
+	       this->_displs[row] = sum;
+	    }
+
+	    // Prefix sum over the row totals. Each thread scans a block
+	    // of rows, then the block sums are scanned and added back.
+	    index row_first = (num_rows*tid)/num_threads;
+	    index row_last = (num_rows*(tid + 1))/num_threads;
+	    index sum = 0;
+	    for(index row = row_first; row < row_last; ++row) {
+	       index cnt = this->_displs[row];
+	       this->_displs[row] = sum;
+	       sum += cnt;
+	    }
+	    block_sums[tid + 1] = sum;
+#pragma omp barrier
+#pragma omp single
+	    {
+	       block_sums[0] = 0;
+	       for(index tt = 0; tt < num_threads; ++tt)
+		  block_sums[tt + 1] += block_sums[tt];
+	       this->_displs[num_rows] = block_sums[num_threads];
+	       this->_array.resize(this->_displs[num_rows]);
+	    }
+	    for(index row = row_first; row < row_last; ++row)
+	       this->_displs[row] += block_sums[tid];
+#pragma omp barrier
+
+	    // Phase two, scatter my block into the array.
+	    for(Iter it = first; it != last; ++it) {
+	       if(!pred(*it))
+		  continue;
+	       typename Map::mapped_type row = op(*it);
+	       this->_array[this->_displs[row] + cnts[row]++] = *it;
+	    }
+	 }
+#endif
+      }
+
       index
       num_rows() const
       {
@@ -181,7 +330,7 @@ namespace hpc {
       }
 
       void
-      take_displs( vector<index>& displs )
+      take_displs( displs_type& displs )
       {
 	 this->deallocate();
 	 if(displs.size() > 1) {
@@ -191,7 +340,7 @@ namespace hpc {
       }
 
       void
-      take_array( vector<T>& array )
+      take_array( array_type& array )
       {
 	 ASSERT((!this->_num_rows && !array.size()) ||
 		array.size() == this->_displs[this->_num_rows],
@@ -236,14 +385,14 @@ namespace hpc {
 	 }
       }
 
-      void duplicate( const csr<T>& csr )
+      void duplicate( const csr& csr )
       {
 	 this->_num_rows = csr._num_rows;
 	 this->_displs.duplicate(csr._displs);
 	 this->_array.duplicate(csr._array);
       }
 
-      void take( csr<T>& csr )
+      void take( csr& csr )
       {
 	 this->_num_rows = csr._num_rows;
 	 this->_displs.take(csr._displs);
@@ -251,8 +400,8 @@ namespace hpc {
 	 csr._num_rows = 0;
       }
 
-      void take( vector<index>& displs,
-		 vector<T>& array )
+      void take( displs_type& displs,
+		 array_type& array )
       {
 	 if(displs.size()) {
 	    ASSERT(displs[displs.size() - 1] == array.size(),
@@ -268,7 +417,7 @@ namespace hpc {
       typename vector<index>::view
       counts()
       {
-	 return vector<index>::view(this->_displs, this->_num_rows);
+	 return vector<index>::view(this->_displs.data(), this->_num_rows);
       }
 
       void
@@ -278,25 +427,25 @@ namespace hpc {
 	 displs_to_counts(this->_displs.begin(), this->_displs.end(), cnts.begin());
       }
 
-      const vector<index>&
+      const displs_type&
       displs() const
       {
 	 return this->_displs;
       }
 
-      vector<index>&
+      displs_type&
       mod_displs()
       {
 	 return this->_displs;
       }
 
-      const vector<T>&
+      const array_type&
       array() const
       {
 	 return this->_array;
       }
 
-      vector<T>&
+      array_type&
       mod_array()
       {
 	 return this->_array;
@@ -319,13 +468,13 @@ namespace hpc {
       const typename vector<T>::view
       operator[]( index row ) const
       {
-	 return typename vector<T>::view(this->_array, this->row_size(row), this->_displs[row]);
+	 return typename vector<T>::view(this->_array.data() + this->_displs[row], this->row_size(row));
       }
 
       typename vector<T>::view
       operator[]( index row )
       {
-	 return typename vector<T>::view(this->_array, this->row_size(row), this->_displs[row]);
+	 return typename vector<T>::view(this->_array.data() + this->_displs[row], this->row_size(row));
       }
 
       const T&
@@ -364,7 +513,7 @@ namespace hpc {
 
       friend std::ostream&
       operator<<( std::ostream& strm,
-		  const csr<T>& obj )
+		  const csr& obj )
       {
 	 strm << "num_rows: " << obj._num_rows << "\n";
 	 if(obj._num_rows) {
@@ -388,8 +537,8 @@ namespace hpc {
 
    private:
       index _num_rows;
-      vector<hpc::index> _displs;
-      vector<T> _array;
+      displs_type _displs;
+      array_type _array;
    };
 
    template< class Displ,
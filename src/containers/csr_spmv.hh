@@ -0,0 +1,554 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef containers_csr_spmv_hh
+#define containers_csr_spmv_hh
+
+#include <algorithm>
+#include "libhpc/debug/assert.hh"
+#include "vector.hh"
+#include "csr.hh"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CSR_SPMV_X86
+#define CSR_SPMV_AVX2 __attribute__((target("avx2,fma")))
+#define CSR_SPMV_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+
+namespace hpc {
+
+   ///
+   /// Instruction sets the sparse kernels can use.
+   ///
+   enum simd_level
+   {
+      simd_scalar,
+      simd_avx2,
+      simd_avx512
+   };
+
+   ///
+   /// The best instruction set supported by the running processor,
+   /// detected once on first call.
+   ///
+   inline
+   simd_level
+   best_simd_level()
+   {
+#ifdef CSR_SPMV_X86
+      static const simd_level level =
+	 (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? simd_avx512 :
+	 (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? simd_avx2 :
+	 simd_scalar;
+      return level;
+#else
+      return simd_scalar;
+#endif
+   }
+
+   ///
+   /// First row of `part` when splitting a csr into `num_parts`
+   /// contiguous row blocks with roughly equal numbers of values.
+   ///
+   inline
+   index
+   balanced_row( const vector<index>& displs,
+		 index part,
+		 index num_parts )
+   {
+      if(displs.size() < 2)
+	 return 0;
+      index num_rows = displs.size() - 1;
+      if(part >= num_parts)
+	 return num_rows;
+      index target = (displs[num_rows]*part)/num_parts;
+      return std::lower_bound(displs.begin(), displs.end() - 1, target) - displs.begin();
+   }
+
+   namespace impl {
+
+      template< class T,
+		class Col >
+      void
+      spmv_rows( simd_level,
+		 const index* displs,
+		 const T* vals,
+		 const Col* cols,
+		 const T* x,
+		 T* y,
+		 index begin,
+		 index end )
+      {
+	 for(index row = begin; row < end; ++row) {
+	    T sum = 0;
+	    for(index jj = displs[row]; jj < displs[row + 1]; ++jj)
+	       sum += vals[jj]*x[cols[jj]];
+	    y[row] = sum;
+	 }
+      }
+
+      template< class T,
+		class Col >
+      void
+      spmm_rows( simd_level,
+		 const index* displs,
+		 const T* vals,
+		 const Col* cols,
+		 const T* x,
+		 T* y,
+		 index width,
+		 index begin,
+		 index end )
+      {
+	 for(index row = begin; row < end; ++row) {
+	    T* y_row = y + row*width;
+	    std::fill(y_row, y_row + width, 0);
+	    for(index jj = displs[row]; jj < displs[row + 1]; ++jj) {
+	       T val = vals[jj];
+	       const T* x_row = x + cols[jj]*width;
+	       for(index kk = 0; kk < width; ++kk)
+		  y_row[kk] += val*x_row[kk];
+	    }
+	 }
+      }
+
+#ifdef CSR_SPMV_X86
+
+      ///
+      /// Vector operations for each instruction set and value
+      /// type. Gathers read 64 bit column indices.
+      ///
+      struct avx2_double
+      {
+	 typedef double value_type;
+	 typedef __m256d vec_type;
+	 static const index width = 4;
+
+	 static CSR_SPMV_AVX2 inline vec_type zero() { return _mm256_setzero_pd(); }
+	 static CSR_SPMV_AVX2 inline vec_type set1( double val ) { return _mm256_set1_pd(val); }
+	 static CSR_SPMV_AVX2 inline vec_type load( const double* ptr ) { return _mm256_loadu_pd(ptr); }
+	 static CSR_SPMV_AVX2 inline void store( double* ptr, vec_type val ) { _mm256_storeu_pd(ptr, val); }
+	 static CSR_SPMV_AVX2 inline vec_type fma( vec_type a, vec_type b, vec_type c ) { return _mm256_fmadd_pd(a, b, c); }
+
+	 static CSR_SPMV_AVX2 inline
+	 vec_type
+	 gather( const double* base,
+		 const index* idxs )
+	 {
+	    return _mm256_i64gather_pd(base, _mm256_loadu_si256((const __m256i*)idxs), 8);
+	 }
+
+	 static CSR_SPMV_AVX2 inline
+	 double
+	 sum( vec_type val )
+	 {
+	    __m128d tmp = _mm_add_pd(_mm256_castpd256_pd128(val), _mm256_extractf128_pd(val, 1));
+	    tmp = _mm_add_sd(tmp, _mm_unpackhi_pd(tmp, tmp));
+	    return _mm_cvtsd_f64(tmp);
+	 }
+      };
+
+      struct avx2_float
+      {
+	 typedef float value_type;
+	 typedef __m256 vec_type;
+	 static const index width = 8;
+
+	 static CSR_SPMV_AVX2 inline vec_type zero() { return _mm256_setzero_ps(); }
+	 static CSR_SPMV_AVX2 inline vec_type set1( float val ) { return _mm256_set1_ps(val); }
+	 static CSR_SPMV_AVX2 inline vec_type load( const float* ptr ) { return _mm256_loadu_ps(ptr); }
+	 static CSR_SPMV_AVX2 inline void store( float* ptr, vec_type val ) { _mm256_storeu_ps(ptr, val); }
+	 static CSR_SPMV_AVX2 inline vec_type fma( vec_type a, vec_type b, vec_type c ) { return _mm256_fmadd_ps(a, b, c); }
+
+	 static CSR_SPMV_AVX2 inline
+	 vec_type
+	 gather( const float* base,
+		 const index* idxs )
+	 {
+	    __m128 lo = _mm256_i64gather_ps(base, _mm256_loadu_si256((const __m256i*)idxs), 4);
+	    __m128 hi = _mm256_i64gather_ps(base, _mm256_loadu_si256((const __m256i*)(idxs + 4)), 4);
+	    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	 }
+
+	 static CSR_SPMV_AVX2 inline
+	 float
+	 sum( vec_type val )
+	 {
+	    __m128 tmp = _mm_add_ps(_mm256_castps256_ps128(val), _mm256_extractf128_ps(val, 1));
+	    tmp = _mm_add_ps(tmp, _mm_movehl_ps(tmp, tmp));
+	    tmp = _mm_add_ss(tmp, _mm_shuffle_ps(tmp, tmp, 1));
+	    return _mm_cvtss_f32(tmp);
+	 }
+      };
+
+      struct avx512_double
+      {
+	 typedef double value_type;
+	 typedef __m512d vec_type;
+	 static const index width = 8;
+
+	 static CSR_SPMV_AVX512 inline vec_type zero() { return _mm512_setzero_pd(); }
+	 static CSR_SPMV_AVX512 inline vec_type set1( double val ) { return _mm512_set1_pd(val); }
+	 static CSR_SPMV_AVX512 inline vec_type load( const double* ptr ) { return _mm512_loadu_pd(ptr); }
+	 static CSR_SPMV_AVX512 inline void store( double* ptr, vec_type val ) { _mm512_storeu_pd(ptr, val); }
+	 static CSR_SPMV_AVX512 inline vec_type fma( vec_type a, vec_type b, vec_type c ) { return _mm512_fmadd_pd(a, b, c); }
+	 static CSR_SPMV_AVX512 inline double sum( vec_type val ) { return _mm512_reduce_add_pd(val); }
+
+	 static CSR_SPMV_AVX512 inline
+	 vec_type
+	 gather( const double* base,
+		 const index* idxs )
+	 {
+	    return _mm512_i64gather_pd(_mm512_loadu_si512(idxs), base, 8);
+	 }
+      };
+
+      struct avx512_float
+      {
+	 typedef float value_type;
+	 typedef __m512 vec_type;
+	 static const index width = 16;
+
+	 static CSR_SPMV_AVX512 inline vec_type zero() { return _mm512_setzero_ps(); }
+	 static CSR_SPMV_AVX512 inline vec_type set1( float val ) { return _mm512_set1_ps(val); }
+	 static CSR_SPMV_AVX512 inline vec_type load( const float* ptr ) { return _mm512_loadu_ps(ptr); }
+	 static CSR_SPMV_AVX512 inline void store( float* ptr, vec_type val ) { _mm512_storeu_ps(ptr, val); }
+	 static CSR_SPMV_AVX512 inline vec_type fma( vec_type a, vec_type b, vec_type c ) { return _mm512_fmadd_ps(a, b, c); }
+	 static CSR_SPMV_AVX512 inline float sum( vec_type val ) { return _mm512_reduce_add_ps(val); }
+
+	 static CSR_SPMV_AVX512 inline
+	 vec_type
+	 gather( const float* base,
+		 const index* idxs )
+	 {
+	    __m256 lo = _mm512_i64gather_ps(_mm512_loadu_si512(idxs), base, 4);
+	    __m256 hi = _mm512_i64gather_ps(_mm512_loadu_si512(idxs + 8), base, 4);
+	    return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(lo)),
+						       _mm256_castps_pd(hi), 1));
+	 }
+      };
+
+      ///
+      /// The kernel bodies are repeated per instruction set so the
+      /// compiler only ever emits instructions from that set.
+      ///
+#define CSR_SPMV_KERNELS( target, suffix )				\
+      template< class Ops >						\
+      target void							\
+      spmv_rows_##suffix( const index* displs,				\
+			  const typename Ops::value_type* vals,		\
+			  const index* cols,				\
+			  const typename Ops::value_type* x,		\
+			  typename Ops::value_type* y,			\
+			  index begin,					\
+			  index end )					\
+      {									\
+	 typedef typename Ops::value_type value_type;			\
+	 for(index row = begin; row < end; ++row) {			\
+	    index jj = displs[row], last = displs[row + 1];		\
+	    typename Ops::vec_type acc = Ops::zero();			\
+	    for(; jj + Ops::width <= last; jj += Ops::width)		\
+	       acc = Ops::fma(Ops::load(vals + jj), Ops::gather(x, cols + jj), acc); \
+	    value_type sum = Ops::sum(acc);				\
+	    for(; jj < last; ++jj)					\
+	       sum += vals[jj]*x[cols[jj]];				\
+	    y[row] = sum;						\
+	 }								\
+      }									\
+									\
+      template< class Ops >						\
+      target void							\
+      spmm_rows_##suffix( const index* displs,				\
+			  const typename Ops::value_type* vals,		\
+			  const index* cols,				\
+			  const typename Ops::value_type* x,		\
+			  typename Ops::value_type* y,			\
+			  index width,					\
+			  index begin,					\
+			  index end )					\
+      {									\
+	 typedef typename Ops::value_type value_type;			\
+	 for(index row = begin; row < end; ++row) {			\
+	    value_type* y_row = y + row*width;				\
+	    std::fill(y_row, y_row + width, 0);				\
+	    for(index jj = displs[row]; jj < displs[row + 1]; ++jj) {	\
+	       value_type val = vals[jj];				\
+	       const value_type* x_row = x + cols[jj]*width;		\
+	       typename Ops::vec_type bval = Ops::set1(val);		\
+	       index kk = 0;						\
+	       for(; kk + Ops::width <= width; kk += Ops::width)	\
+		  Ops::store(y_row + kk, Ops::fma(bval, Ops::load(x_row + kk), Ops::load(y_row + kk))); \
+	       for(; kk < width; ++kk)					\
+		  y_row[kk] += val*x_row[kk];				\
+	    }								\
+	 }								\
+      }
+
+      CSR_SPMV_KERNELS( CSR_SPMV_AVX2, avx2 )
+      CSR_SPMV_KERNELS( CSR_SPMV_AVX512, avx512 )
+
+#undef CSR_SPMV_KERNELS
+
+      ///
+      /// Overloads for float and double select a vector kernel. The
+      /// gathers need 64 bit indices, so anything else stays scalar.
+      ///
+      template< class T,
+		class Avx2Ops,
+		class Avx512Ops >
+      void
+      spmv_rows_simd( simd_level level,
+		      const index* displs,
+		      const T* vals,
+		      const index* cols,
+		      const T* x,
+		      T* y,
+		      index begin,
+		      index end )
+      {
+	 if(sizeof(index) != 8)
+	    level = simd_scalar;
+	 if(level == simd_avx512)
+	    spmv_rows_avx512<Avx512Ops>(displs, vals, cols, x, y, begin, end);
+	 else if(level == simd_avx2)
+	    spmv_rows_avx2<Avx2Ops>(displs, vals, cols, x, y, begin, end);
+	 else
+	    spmv_rows<T, index>(simd_scalar, displs, vals, cols, x, y, begin, end);
+      }
+
+      template< class T,
+		class Avx2Ops,
+		class Avx512Ops >
+      void
+      spmm_rows_simd( simd_level level,
+		      const index* displs,
+		      const T* vals,
+		      const index* cols,
+		      const T* x,
+		      T* y,
+		      index width,
+		      index begin,
+		      index end )
+      {
+	 if(level == simd_avx512)
+	    spmm_rows_avx512<Avx512Ops>(displs, vals, cols, x, y, width, begin, end);
+	 else if(level == simd_avx2)
+	    spmm_rows_avx2<Avx2Ops>(displs, vals, cols, x, y, width, begin, end);
+	 else
+	    spmm_rows<T, index>(simd_scalar, displs, vals, cols, x, y, width, begin, end);
+      }
+
+      inline
+      void
+      spmv_rows( simd_level level,
+		 const index* displs,
+		 const double* vals,
+		 const index* cols,
+		 const double* x,
+		 double* y,
+		 index begin,
+		 index end )
+      {
+	 spmv_rows_simd<double, avx2_double, avx512_double>(level, displs, vals, cols, x, y, begin, end);
+      }
+
+      inline
+      void
+      spmv_rows( simd_level level,
+		 const index* displs,
+		 const float* vals,
+		 const index* cols,
+		 const float* x,
+		 float* y,
+		 index begin,
+		 index end )
+      {
+	 spmv_rows_simd<float, avx2_float, avx512_float>(level, displs, vals, cols, x, y, begin, end);
+      }
+
+      inline
+      void
+      spmm_rows( simd_level level,
+		 const index* displs,
+		 const double* vals,
+		 const index* cols,
+		 const double* x,
+		 double* y,
+		 index width,
+		 index begin,
+		 index end )
+      {
+	 spmm_rows_simd<double, avx2_double, avx512_double>(level, displs, vals, cols, x, y, width, begin, end);
+      }
+
+      inline
+      void
+      spmm_rows( simd_level level,
+		 const index* displs,
+		 const float* vals,
+		 const index* cols,
+		 const float* x,
+		 float* y,
+		 index width,
+		 index begin,
+		 index end )
+      {
+	 spmm_rows_simd<float, avx2_float, avx512_float>(level, displs, vals, cols, x, y, width, begin, end);
+      }
+
+#endif
+
+   }
+
+   ///
+   /// Sparse matrix-vector product, y = Ax. The matrix is given as a
+   /// csr of values and a csr of column indices with the same
+   /// structure. `x` must hold at least one value per column and `y`
+   /// one per row. For float and double the inner loops use the
+   /// widest vector instructions available, unless `level` says
+   /// otherwise.
+   ///
+   template< class T,
+	     class Col >
+   void
+   spmv( const csr<T>& vals,
+	 const csr<Col>& cols,
+	 const T* x,
+	 T* y,
+	 simd_level level=best_simd_level() )
+   {
+      ASSERT(vals.displs() == cols.displs(), "Values and columns must have the same structure.");
+      if(vals.empty())
+	 return;
+      impl::spmv_rows(level, vals.displs().data(), vals.array().data(), cols.array().data(),
+		      x, y, 0, vals.num_rows());
+   }
+
+   template< class T,
+	     class Col >
+   void
+   spmv( const csr<T>& vals,
+	 const csr<Col>& cols,
+	 const vector<T>& x,
+	 vector<T>& y,
+	 simd_level level=best_simd_level() )
+   {
+      ASSERT(y.size() >= vals.num_rows(), "Output vector too small.");
+      spmv(vals, cols, x.data(), y.data(), level);
+   }
+
+   ///
+   /// Sparse matrix by dense block product, Y = AX. X and Y are row
+   /// major with `width` columns; the vector instructions run along
+   /// the rows of X.
+   ///
+   template< class T,
+	     class Col >
+   void
+   spmm( const csr<T>& vals,
+	 const csr<Col>& cols,
+	 const T* x,
+	 T* y,
+	 index width,
+	 simd_level level=best_simd_level() )
+   {
+      ASSERT(vals.displs() == cols.displs(), "Values and columns must have the same structure.");
+      if(vals.empty())
+	 return;
+      impl::spmm_rows(level, vals.displs().data(), vals.array().data(), cols.array().data(),
+		      x, y, width, 0, vals.num_rows());
+   }
+
+   ///
+   /// Threaded spmv. Each thread takes a contiguous block of rows
+   /// chosen so the blocks hold similar numbers of values, which
+   /// keeps the threads balanced when row lengths vary. Falls back
+   /// to spmv when OpenMP is not enabled.
+   ///
+   template< class T,
+	     class Col >
+   void
+   spmv_parallel( const csr<T>& vals,
+		  const csr<Col>& cols,
+		  const T* x,
+		  T* y,
+		  simd_level level=best_simd_level() )
+   {
+#ifdef _OPENMP
+      ASSERT(vals.displs() == cols.displs(), "Values and columns must have the same structure.");
+      if(vals.empty())
+	 return;
+#pragma omp parallel
+      {
+	 index num_threads = omp_get_num_threads();
+	 index tid = omp_get_thread_num();
+	 impl::spmv_rows(level, vals.displs().data(), vals.array().data(), cols.array().data(), x, y,
+			 balanced_row(vals.displs(), tid, num_threads),
+			 balanced_row(vals.displs(), tid + 1, num_threads));
+      }
+#else
+      spmv(vals, cols, x, y, level);
+#endif
+   }
+
+   template< class T,
+	     class Col >
+   void
+   spmv_parallel( const csr<T>& vals,
+		  const csr<Col>& cols,
+		  const vector<T>& x,
+		  vector<T>& y,
+		  simd_level level=best_simd_level() )
+   {
+      ASSERT(y.size() >= vals.num_rows(), "Output vector too small.");
+      spmv_parallel(vals, cols, x.data(), y.data(), level);
+   }
+
+   template< class T,
+	     class Col >
+   void
+   spmm_parallel( const csr<T>& vals,
+		  const csr<Col>& cols,
+		  const T* x,
+		  T* y,
+		  index width,
+		  simd_level level=best_simd_level() )
+   {
+#ifdef _OPENMP
+      ASSERT(vals.displs() == cols.displs(), "Values and columns must have the same structure.");
+      if(vals.empty())
+	 return;
+#pragma omp parallel
+      {
+	 index num_threads = omp_get_num_threads();
+	 index tid = omp_get_thread_num();
+	 impl::spmm_rows(level, vals.displs().data(), vals.array().data(), cols.array().data(), x, y, width,
+			 balanced_row(vals.displs(), tid, num_threads),
+			 balanced_row(vals.displs(), tid + 1, num_threads));
+      }
+#else
+      spmm(vals, cols, x, y, width, level);
+#endif
+   }
+}
+
+#endif
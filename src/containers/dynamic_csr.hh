@@ -0,0 +1,324 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef containers_dynamic_csr_hh
+#define containers_dynamic_csr_hh
+
+#include <algorithm>
+#include "libhpc/debug/assert.hh"
+#include "vector.hh"
+#include "csr.hh"
+
+namespace hpc {
+
+   ///
+   /// A csr that supports incremental modification of rows. Each row
+   /// owns a block of the array with some spare capacity (slack).
+   /// Appending to a row that has run out of capacity moves the row
+   /// to the end of the array with double the capacity, so appends
+   /// are amortised O(1). The holes this leaves behind are reclaimed
+   /// by `repack`, or by `compact`, which produces a plain csr.
+   ///
+   /// Note that any operation that can grow the array invalidates
+   /// row views.
+   ///
+   template< class T >
+   class dynamic_csr
+   {
+   public:
+
+      dynamic_csr( index slack=4 )
+	 : _slack( slack ),
+	   _used( 0 )
+      {
+      }
+
+      dynamic_csr( const csr<T>& src,
+		   index slack=4 )
+	 : _slack( slack )
+      {
+	 this->set(src);
+      }
+
+      void
+      deallocate()
+      {
+	 this->_starts.deallocate();
+	 this->_sizes.deallocate();
+	 this->_caps.deallocate();
+	 this->_array.deallocate();
+	 this->_used = 0;
+      }
+
+      ///
+      /// Setup from a plain csr, giving each row `slack` spare slots.
+      ///
+      void
+      set( const csr<T>& src )
+      {
+	 this->deallocate();
+	 index num_rows = src.num_rows();
+	 this->_starts.resize(num_rows);
+	 this->_sizes.resize(num_rows);
+	 this->_caps.resize(num_rows);
+	 index pos = 0;
+	 for(index ii = 0; ii < num_rows; ++ii) {
+	    this->_starts[ii] = pos;
+	    this->_sizes[ii] = src.row_size(ii);
+	    this->_caps[ii] = src.row_size(ii) + this->_slack;
+	    pos += this->_caps[ii];
+	 }
+	 this->_array.resize(pos);
+	 for(index ii = 0; ii < num_rows; ++ii)
+	    std::copy(src[ii].begin(), src[ii].end(), this->_array.begin() + this->_starts[ii]);
+	 this->_used = src.array().size();
+      }
+
+      index
+      slack() const
+      {
+	 return this->_slack;
+      }
+
+      void
+      set_slack( index slack )
+      {
+	 ASSERT(slack >= 0, "Invalid slack.");
+	 this->_slack = slack;
+      }
+
+      index
+      num_rows() const
+      {
+	 return this->_starts.size();
+      }
+
+      bool
+      empty() const
+      {
+	 return this->_starts.empty();
+      }
+
+      ///
+      /// Total number of values stored.
+      ///
+      index
+      size() const
+      {
+	 return this->_used;
+      }
+
+      ///
+      /// Total number of array slots, including slack and holes.
+      ///
+      index
+      capacity() const
+      {
+	 return this->_array.size();
+      }
+
+      index
+      row_size( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 return this->_sizes[row];
+      }
+
+      index
+      row_capacity( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 return this->_caps[row];
+      }
+
+      ///
+      /// Append an empty row, returning its index.
+      ///
+      index
+      add_row()
+      {
+	 index row = this->num_rows();
+	 this->_starts.push_back(this->_array.size());
+	 this->_sizes.push_back(0);
+	 this->_caps.push_back(this->_slack);
+	 this->_array.resize(this->_array.size() + this->_slack);
+	 return row;
+      }
+
+      void
+      push_back( index row,
+		 const T& value )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 if(this->_sizes[row] == this->_caps[row])
+	    this->_grow(row, std::max<index>(2*this->_caps[row], 1));
+	 this->_array[this->_starts[row] + this->_sizes[row]++] = value;
+	 ++this->_used;
+      }
+
+      ///
+      /// Remove a value from a row, preserving the order of the
+      /// remaining values.
+      ///
+      void
+      erase( index row,
+	     index col )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 ASSERT(col >= 0 && col < this->_sizes[row], "Invalid column index.");
+	 typename vector<T>::iterator first = this->_array.begin() + this->_starts[row];
+	 std::copy(first + col + 1, first + this->_sizes[row], first + col);
+	 --this->_sizes[row];
+	 --this->_used;
+      }
+
+      void
+      clear_row( index row )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 this->_used -= this->_sizes[row];
+	 this->_sizes[row] = 0;
+      }
+
+      ///
+      /// Replace the contents of a row.
+      ///
+      template< class Iter >
+      void
+      set_row( index row,
+	       Iter begin,
+	       Iter end )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 index size = std::distance(begin, end);
+	 if(size > this->_caps[row])
+	    this->_grow(row, size + this->_slack);
+	 std::copy(begin, end, this->_array.begin() + this->_starts[row]);
+	 this->_used += size - this->_sizes[row];
+	 this->_sizes[row] = size;
+      }
+
+      ///
+      /// Pack rows back into row order, leaving `slack` spare slots
+      /// per row and removing any holes.
+      ///
+      void
+      repack()
+      {
+	 index num_rows = this->num_rows();
+	 vector<T> array(this->_used + num_rows*this->_slack);
+	 index pos = 0;
+	 for(index ii = 0; ii < num_rows; ++ii) {
+	    typename vector<T>::iterator first = this->_array.begin() + this->_starts[ii];
+	    std::copy(first, first + this->_sizes[ii], array.begin() + pos);
+	    this->_starts[ii] = pos;
+	    this->_caps[ii] = this->_sizes[ii] + this->_slack;
+	    pos += this->_caps[ii];
+	 }
+	 this->_array.take(array);
+      }
+
+      ///
+      /// Produce the equivalent plain csr.
+      ///
+      void
+      compact( csr<T>& dst ) const
+      {
+	 index num_rows = this->num_rows();
+	 vector<index> displs;
+	 vector<T> array;
+	 if(num_rows) {
+	    displs.resize(num_rows + 1);
+	    array.resize(this->_used);
+	    displs[0] = 0;
+	    for(index ii = 0; ii < num_rows; ++ii) {
+	       typename vector<T>::const_iterator first = this->_array.begin() + this->_starts[ii];
+	       std::copy(first, first + this->_sizes[ii], array.begin() + displs[ii]);
+	       displs[ii + 1] = displs[ii] + this->_sizes[ii];
+	    }
+	 }
+	 dst.take(displs, array);
+      }
+
+      const typename vector<T>::view
+      operator[]( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 return typename vector<T>::view(this->_array, this->_sizes[row], this->_starts[row]);
+      }
+
+      typename vector<T>::view
+      operator[]( index row )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 return typename vector<T>::view(this->_array, this->_sizes[row], this->_starts[row]);
+      }
+
+      const T&
+      operator()( index row,
+		  index col ) const
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 ASSERT(col >= 0 && col < this->_sizes[row], "Invalid column index.");
+	 return this->_array[this->_starts[row] + col];
+      }
+
+      T&
+      operator()( index row,
+		  index col )
+      {
+	 ASSERT(row >= 0 && row < this->num_rows(), "Invalid row index.");
+	 ASSERT(col >= 0 && col < this->_sizes[row], "Invalid column index.");
+	 return this->_array[this->_starts[row] + col];
+      }
+
+   protected:
+
+      ///
+      /// Move a row to the end of the array with a new capacity. If
+      /// the row is already last we can extend it in place.
+      ///
+      void
+      _grow( index row,
+	     index cap )
+      {
+	 index start = this->_starts[row];
+	 if(start + this->_caps[row] == (index)this->_array.size()) {
+	    this->_array.resize(start + cap);
+	 }
+	 else {
+	    index new_start = this->_array.size();
+	    this->_array.resize(new_start + cap);
+	    std::copy(this->_array.begin() + start,
+		      this->_array.begin() + start + this->_sizes[row],
+		      this->_array.begin() + new_start);
+	    this->_starts[row] = new_start;
+	 }
+	 this->_caps[row] = cap;
+      }
+
+   private:
+      index _slack;
+      index _used;
+      vector<index> _starts;
+      vector<index> _sizes;
+      vector<index> _caps;
+      vector<T> _array;
+   };
+}
+
+#endif
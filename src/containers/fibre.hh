@@ -19,121 +19,284 @@
 #define containers_fibre_hh
 
 #include <stddef.h>
+#include <memory>
 #include "libhpc/debug/checks.hh"
 #include "vector.hh"
 
 namespace hpc {
 
-   template< class T >
+   template< class T,
+             index N = 0 >
+   class fibre_iterator;
+
+   template< class T,
+             index N = 0 >
    class const_fibre_iterator;
 
+   ///
+   /// View of a single fibre whose size is known at compile time.
+   /// Loops over it have a constant trip count, so the compiler can
+   /// unroll and vectorise them.
+   ///
+   template< class T,
+             index N >
+   class fixed_fibre_view
+   {
+   public:
+
+      typedef T        value_type;
+      typedef T*       iterator;
+      typedef T*       const_iterator;
+      typedef index    size_type;
+
+      fixed_fibre_view( T* ptr )
+         : _ptr( ptr )
+      {
+      }
+
+      static size_type
+      size()
+      {
+         return N;
+      }
+
+      T*
+      data() const
+      {
+         return this->_ptr;
+      }
+
+      T*
+      begin() const
+      {
+         return this->_ptr;
+      }
+
+      T*
+      end() const
+      {
+         return this->_ptr + N;
+      }
+
+      T&
+      operator[]( index idx ) const
+      {
+         ASSERT( idx >= 0 && idx < N, "Index out of bounds." );
+         return this->_ptr[idx];
+      }
+
+   private:
+
+      T* _ptr;
+   };
+
+   namespace impl {
+
+      ///
+      /// Distance between fibres. A width of zero means the fibre
+      /// size is only known at runtime.
+      ///
+      template< index N >
+      struct fibre_stride
+      {
+         fibre_stride( index )
+         {
+         }
+
+         index
+         size() const
+         {
+            return N;
+         }
+      };
+
+      template<>
+      struct fibre_stride<0>
+      {
+         fibre_stride( index size )
+            : _size( size )
+         {
+         }
+
+         index
+         size() const
+         {
+            return this->_size;
+         }
+
+         index _size;
+      };
+
+      ///
+      /// What a fibre iterator dereferences to; a fixed size view for
+      /// compile time widths, otherwise a vector view.
+      ///
+      template< class T,
+                index N >
+      struct fibre_reference
+      {
+         typedef fixed_fibre_view<T,N> type;
+
+         static type
+         make( T* ptr,
+               index )
+         {
+            return type( ptr );
+         }
+      };
+
+      template< class T >
+      struct fibre_reference<T,0>
+      {
+         typedef typename vector<T>::view type;
+
+         static type
+         make( T* ptr,
+               index size )
+         {
+            return type( ptr, size );
+         }
+      };
+
+      template< class T,
+                index N >
+      struct fibre_reference<const T,N>
+      {
+         typedef fixed_fibre_view<const T,N> type;
+
+         static type
+         make( const T* ptr,
+               index )
+         {
+            return type( ptr );
+         }
+      };
+
+      template< class T >
+      struct fibre_reference<const T,0>
+      {
+         typedef const typename vector<T>::view type;
+
+         static type
+         make( const T* ptr,
+               index size )
+         {
+            return type( ptr, size );
+         }
+      };
+
+   }
+
+
    ///
    ///
    ///
-   template< class T >
+   template< class T,
+             index N >
    class fibre_iterator
       : public std::iterator< std::random_access_iterator_tag,
                               vector<T>,
                               ptrdiff_t,
                               T*,
-                              typename vector<T>::view >
+                              typename impl::fibre_reference<T,N>::type >
    {
    public:
 
       typedef ptrdiff_t difference_type;
+      typedef typename impl::fibre_reference<T,N>::type reference;
 
       fibre_iterator()
          : _ptr( 0 ),
-           _fibre_size( 0 )
+           _stride( 0 )
       {
       }
 
       fibre_iterator( const T* ptr, index fibre_size )
          : _ptr( (T*)ptr ),
-           _fibre_size( fibre_size )
+           _stride( fibre_size )
       {
       }
 
       fibre_iterator( typename vector<T>::iterator vit, index fibre_size )
          : _ptr( vit.base() ),
-           _fibre_size( fibre_size )
+           _stride( fibre_size )
       {
       }
 
       fibre_iterator( const fibre_iterator& it )
          : _ptr( it._ptr ),
-           _fibre_size( it._fibre_size )
+           _stride( it.fibre_size() )
       {
       }
 
       fibre_iterator&
       operator++()
       {
-         this->_ptr += this->_fibre_size;
+         this->_ptr += this->fibre_size();
          return *this;
       }
 
       fibre_iterator
       operator++( int )
       {
-         this->_ptr += this->_fibre_size;
-         return fibre_iterator( this->_ptr, this->_fibre_size );
+         this->_ptr += this->fibre_size();
+         return fibre_iterator( this->_ptr, this->fibre_size() );
       }
 
       fibre_iterator&
       operator--()
       {
-         this->_ptr -= this->_fibre_size;
+         this->_ptr -= this->fibre_size();
          return *this;
       }
 
       fibre_iterator
       operator--( int )
       {
-         this->_ptr -= this->_fibre_size;
-         return fibre_iterator( this->_ptr, this->_fibre_size );
+         this->_ptr -= this->fibre_size();
+         return fibre_iterator( this->_ptr, this->fibre_size() );
       }
 
       fibre_iterator&
       operator-=( difference_type op )
       {
-         this->_ptr -= op*this->_fibre_size;
+         this->_ptr -= op*this->fibre_size();
          return *this;
       }
 
       fibre_iterator
       operator+( difference_type op )
       {
-         return fibre_iterator( this->_ptr + op*this->_fibre_size, this->_fibre_size );
+         return fibre_iterator( this->_ptr + op*this->fibre_size(), this->fibre_size() );
       }
 
       fibre_iterator&
       operator+=( difference_type op )
       {
-         this->_ptr += op*this->_fibre_size;
+         this->_ptr += op*this->fibre_size();
          return *this;
       }
 
       fibre_iterator
       operator-( difference_type op )
       {
-         return fibre_iterator( this->_ptr - op*this->_fibre_size, this->_fibre_size );
+         return fibre_iterator( this->_ptr - op*this->fibre_size(), this->fibre_size() );
       }
 
       difference_type
       operator-( fibre_iterator op )
       {
-         ASSERT( this->_fibre_size == op._fibre_size );
-         ASSERT( (this->_ptr - op._ptr)%this->_fibre_size == 0 );
-         return (this->_ptr - op._ptr)/this->_fibre_size;
+         ASSERT( this->fibre_size() == op.fibre_size() );
+         ASSERT( (this->_ptr - op._ptr)%this->fibre_size() == 0 );
+         return (this->_ptr - op._ptr)/this->fibre_size();
       }
 
       difference_type
-      operator-( const_fibre_iterator<T> op )
+      operator-( const_fibre_iterator<T,N> op )
       {
-         ASSERT( this->_fibre_size == op._fibre_size );
-         ASSERT( (this->_ptr - op._ptr)%this->_fibre_size == 0 );
-         return (this->_ptr - op._ptr)/this->_fibre_size;
+         ASSERT( this->fibre_size() == op.fibre_size() );
+         ASSERT( (this->_ptr - op._ptr)%this->fibre_size() == 0 );
+         return (this->_ptr - op._ptr)/this->fibre_size();
       }
 
       bool
@@ -148,16 +311,16 @@ namespace hpc {
          return !this->operator==( op );
       }
 
-      typename vector<T>::view
+      reference
       operator*() const
       {
-         return typename vector<T>::view( this->_ptr, this->_fibre_size );
+         return impl::fibre_reference<T,N>::make( this->_ptr, this->fibre_size() );
       }
 
-      typename vector<T>::view
+      reference
       operator[]( hpc::index idx )
       {
-         return typename vector<T>::view( this->_ptr + idx*this->_fibre_size, this->_fibre_size );
+         return impl::fibre_reference<T,N>::make( this->_ptr + idx*this->fibre_size(), this->fibre_size() );
       }
 
       bool
@@ -193,142 +356,144 @@ namespace hpc {
       index
       fibre_size() const
       {
-         return this->_fibre_size;
+         return this->_stride.size();
       }
 
    private:
 
       T* _ptr;
-      index _fibre_size;
+      impl::fibre_stride<N> _stride;
 
-      friend class const_fibre_iterator<T>;
+      friend class const_fibre_iterator<T,N>;
    };
 
    ///
    ///
    ///
-   template< class T >
+   template< class T,
+             index N >
    class const_fibre_iterator
       : public std::iterator< std::random_access_iterator_tag,
                               vector<T>,
                               ptrdiff_t,
                               const T*,
-                              const typename vector<T>::view >
+                              typename impl::fibre_reference<const T,N>::type >
    {
    public:
 
       typedef ptrdiff_t difference_type;
+      typedef typename impl::fibre_reference<const T,N>::type reference;
 
       const_fibre_iterator()
          : _ptr( 0 ),
-           _fibre_size( 0 )
+           _stride( 0 )
       {
       }
 
       const_fibre_iterator( const T* ptr, index fibre_size )
          : _ptr( ptr ),
-           _fibre_size( fibre_size )
+           _stride( fibre_size )
       {
       }
 
       const_fibre_iterator( const typename vector<T>::iterator vit, index fibre_size )
          : _ptr( vit.base() ),
-           _fibre_size( fibre_size )
+           _stride( fibre_size )
       {
       }
 
       const_fibre_iterator( const typename vector<T>::const_iterator vit, index fibre_size )
          : _ptr( vit.base() ),
-           _fibre_size( fibre_size )
+           _stride( fibre_size )
       {
       }
 
       const_fibre_iterator( const const_fibre_iterator& it )
          : _ptr( it._ptr ),
-           _fibre_size( it._fibre_size )
+           _stride( it.fibre_size() )
       {
       }
 
-      const_fibre_iterator( const fibre_iterator<T>& it )
+      const_fibre_iterator( const fibre_iterator<T,N>& it )
          : _ptr( it._ptr ),
-           _fibre_size( it._fibre_size )
+           _stride( it.fibre_size() )
       {
       }
 
       const_fibre_iterator&
       operator++()
       {
-         this->_ptr += this->_fibre_size;
+         this->_ptr += this->fibre_size();
          return *this;
       }
 
       const_fibre_iterator
       operator++( int )
       {
-         this->_ptr += this->_fibre_size;
-         return const_fibre_iterator( this->_ptr, this->_fibre_size );
+         this->_ptr += this->fibre_size();
+         return const_fibre_iterator( this->_ptr, this->fibre_size() );
       }
 
       const_fibre_iterator&
       operator+=( difference_type op )
       {
-         this->_ptr += op*this->_fibre_size;
+         this->_ptr += op*this->fibre_size();
          return *this;
       }
 
       const_fibre_iterator&
       operator--()
       {
-         this->_ptr -= this->_fibre_size;
+         this->_ptr -= this->fibre_size();
          return *this;
       }
 
       const_fibre_iterator
       operator--( int )
       {
-         this->_ptr -= this->_fibre_size;
-         return const_fibre_iterator( this->_ptr, this->_fibre_size );
+         this->_ptr -= this->fibre_size();
+         return const_fibre_iterator( this->_ptr, this->fibre_size() );
       }
 
       const_fibre_iterator&
       operator-=( difference_type op )
       {
-         this->_ptr -= op*this->_fibre_size;
+         this->_ptr -= op*this->fibre_size();
          return *this;
       }
 
       const_fibre_iterator
       operator+( difference_type op )
       {
-         return const_fibre_iterator( this->_ptr + op*this->_fibre_size, this->_fibre_size );
+         return const_fibre_iterator( this->_ptr + op*this->fibre_size(), this->fibre_size() );
       }
 
       const_fibre_iterator
       operator-( difference_type op )
       {
-         return const_fibre_iterator( this->_ptr - op*this->_fibre_size, this->_fibre_size );
+         return const_fibre_iterator( this->_ptr - op*this->fibre_size(), this->fibre_size() );
       }
 
       const_fibre_iterator
       operator+( const_fibre_iterator op )
       {
-         return const_fibre_iterator( this->_ptr + op*this->_fibre_size, this->_fibre_size );
+         return const_fibre_iterator( this->_ptr + op*this->fibre_size(), this->fibre_size() );
       }
 
       difference_type
       operator-( const_fibre_iterator op )
       {
-         ASSERT( this->_fibre_size == op._fibre_size );
-         ASSERT( (this->_ptr - op._ptr)%this->_fibre_size == 0 );
-         return (this->_ptr - op._ptr)/this->_fibre_size;
+         ASSERT( this->fibre_size() == op.fibre_size() );
+         ASSERT( (this->_ptr - op._ptr)%this->fibre_size() == 0 );
+         return (this->_ptr - op._ptr)/this->fibre_size();
       }
 
       difference_type
-      operator-( fibre_iterator<T> op )
+      operator-( fibre_iterator<T,N> op )
       {
-         ASSERT( this->_fibre_size == op._fibre_size );
-         ASSERT( (this->_ptr - op._ptr)%this->_fibre_size == 0 );
-         return (this->_ptr - op._ptr)/this->_fibre_size;
+         ASSERT( this->fibre_size() == op.fibre_size() );
+         ASSERT( (this->_ptr - op._ptr)%this->fibre_size() == 0 );
+         return (this->_ptr - op._ptr)/this->fibre_size();
       }
 
       bool
@@ -343,16 +508,16 @@ namespace hpc {
          return !this->operator==( op );
       }
 
-      const typename vector<T>::view
+      reference
       operator*() const
       {
-         return typename vector<T>::view( this->_ptr, this->_fibre_size );
+         return impl::fibre_reference<const T,N>::make( this->_ptr, this->fibre_size() );
       }
 
-      typename vector<T>::view
+      reference
       operator[]( hpc::index idx ) const
       {
-         return typename vector<T>::view( this->_ptr + idx*this->_fibre_size, this->_fibre_size );
+         return impl::fibre_reference<const T,N>::make( this->_ptr + idx*this->fibre_size(), this->fibre_size() );
       }
 
       bool
@@ -388,42 +553,63 @@ namespace hpc {
       index
       fibre_size() const
       {
-         return this->_fibre_size;
+         return this->_stride.size();
       }
 
    private:
 
       const T* _ptr;
-      index _fibre_size;
+      impl::fibre_stride<N> _stride;
 
-      friend class fibre_iterator<T>;
+      friend class fibre_iterator<T,N>;
    };
 
    ///
+   /// Tag for the default fibre layout, with the components of each
+   /// fibre stored together (array of structures). Other layouts are
+   /// in fibre_layout.hh.
+   ///
+   struct aos_layout
+   {
+   };
+
    ///
    ///
-   template< class T >
+   ///
+   template< class T,
+             class Layout = aos_layout,
+             class Alloc = std::allocator<T> >
    class fibre
-      : public vector<T>
+      : public vector<T,Alloc>
    {
    public:
 
-      typedef vector<T>                     super_type;
+      typedef vector<T,Alloc>               super_type;
       typedef T                             value_type;
-      typedef typename vector<T>::size_type size_type;
+      typedef Alloc                         allocator_type;
+      typedef typename super_type::size_type size_type;
       typedef fibre_iterator<T>             iterator;
       typedef const_fibre_iterator<T>       const_iterator;
 
       fibre()
-	 : vector<T>(),
+	 : super_type(),
+	   _num_fibres( 0 ),
+	   _fibre_size( 0 )
+      {
+      }
+
+      explicit
+      fibre( const Alloc& alloc )
+	 : super_type( alloc ),
 	   _num_fibres( 0 ),
 	   _fibre_size( 0 )
       {
       }
 
       fibre( index fibre_size,
-             index size = 0 )
-         : vector<T>(),
+             index size = 0,
+             const Alloc& alloc = Alloc() )
+         : super_type( alloc ),
            _num_fibres( 0 ),
            _fibre_size( fibre_size )
       {
@@ -443,7 +629,7 @@ namespace hpc {
       }
 
       void
-      take( fibre<value_type>& src )
+      take( fibre& src )
       {
          super_type::take( src );
          _num_fibres = src._num_fibres;
@@ -468,28 +654,28 @@ namespace hpc {
       max_size() const
       {
 	 CHECK(this->check_sizes());
-	 return vector<T>::max_size()/this->_fibre_size;
+	 return super_type::max_size()/this->_fibre_size;
       }
 
       size_type
       capacity() const
       {
 	 CHECK(this->check_sizes());
-	 return vector<T>::capacity()/this->_fibre_size;
+	 return super_type::capacity()/this->_fibre_size;
       }
 
       void
       reserve( size_type size )
       {
 	 CHECK(this->check_sizes());
-	 vector<T>::reserve(size*this->_fibre_size);
+	 super_type::reserve(size*this->_fibre_size);
       }
 
       void
       resize( size_type size )
       {
 	 // CHECK(this->check_sizes());
-	 vector<T>::resize(size*this->_fibre_size);
+	 super_type::resize(size*this->_fibre_size);
 	 this->_num_fibres = size;
       }
 
@@ -497,7 +683,7 @@ namespace hpc {
       reallocate( size_type size )
       {
 	 // CHECK(this->check_sizes());
-	 vector<T>::reallocate(size*this->_fibre_size);
+	 super_type::reallocate(size*this->_fibre_size);
 	 this->_num_fibres = size;
       }
 
@@ -512,7 +698,7 @@ namespace hpc {
       void
       clear()
       {
-	 vector<T>::clear();
+	 super_type::clear();
 	 this->_num_fibres = 0;
       }
 
@@ -520,43 +706,43 @@ namespace hpc {
       deallocate()
       {
 	 this->clear();
-	 vector<T>().swap(*this);
+	 super_type( this->get_allocator() ).swap( *this );
       }
 
       const_iterator
       begin() const
       {
-         return const_iterator( vector<T>::begin(), this->_fibre_size );
+         return const_iterator( this->data(), this->_fibre_size );
       }
 
       iterator
       begin()
       {
-         return iterator( vector<T>::begin(), this->_fibre_size );
+         return iterator( this->data(), this->_fibre_size );
       }
 
       const_iterator
       end() const
       {
-         return const_iterator( vector<T>::end(), this->_fibre_size );
+         return const_iterator( this->data() + super_type::size(), this->_fibre_size );
       }
 
       iterator
       end()
       {
-         return iterator( vector<T>::end(), this->_fibre_size );
+         return iterator( this->data() + super_type::size(), this->_fibre_size );
       }
 
-      typename vector<T>::iterator
+      typename super_type::iterator
       vbegin()
       {
-         return vector<T>::begin();
+         return super_type::begin();
       }
 
-      typename vector<T>::iterator
+      typename super_type::iterator
       vend()
       {
-         return vector<T>::end();
+         return super_type::end();
       }
 
       const typename vector<T>::view
@@ -575,14 +761,14 @@ namespace hpc {
       operator[](index idx) const
       {
 	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
-	 return typename vector<T>::view(*this, this->_fibre_size, idx*this->_fibre_size);
+	 return typename vector<T>::view( this->data() + idx*this->_fibre_size, this->_fibre_size );
       }
 
       typename vector<T>::view
       operator[](index idx)
       {
 	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
-	 return typename vector<T>::view(*this, this->_fibre_size, idx*this->_fibre_size);
+	 return typename vector<T>::view( this->data() + idx*this->_fibre_size, this->_fibre_size );
       }
 
       T
@@ -590,7 +776,7 @@ namespace hpc {
 		  index fibre_idx ) const
       {
 	 ASSERT( fibre_idx < this->_fibre_size );
-	 return vector<T>::operator[]( idx*this->_fibre_size + fibre_idx );
+	 return super_type::operator[]( idx*this->_fibre_size + fibre_idx );
       }
 
       T&
@@ -598,12 +784,12 @@ namespace hpc {
 		  index fibre_idx )
       {
 	 ASSERT( fibre_idx < this->_fibre_size );
-	 return vector<T>::operator[]( idx*this->_fibre_size + fibre_idx );
+	 return super_type::operator[]( idx*this->_fibre_size + fibre_idx );
       }
 
       friend std::ostream&
       operator<<( std::ostream& strm,
-		  const fibre<T>& obj )
+		  const fibre& obj )
       {
 	 strm << "[";
 	 if(obj.size()) {
@@ -629,8 +815,8 @@ namespace hpc {
       check_sizes() const
       {
 	 ASSERT(this->_fibre_size > 0, "Fibre size must be greater than zero.");
-	 ASSERT(vector<T>::size()%this->_fibre_size == 0, "Bad number of fibres.");
-	 ASSERT(vector<T>::size()/this->_fibre_size == this->size(), "Number of fibres mismatch.");
+	 ASSERT(super_type::size()%this->_fibre_size == 0, "Bad number of fibres.");
+	 ASSERT(super_type::size()/this->_fibre_size == this->size(), "Number of fibres mismatch.");
       }
 #endif
 
@@ -640,18 +826,241 @@ namespace hpc {
       size_type _fibre_size;
    };
 
-   template< class T >
-   fibre_iterator<T>
-   operator+( ptrdiff_t op_a, const fibre_iterator<T>& op_b )
+
+   ///
+   /// A fibre whose width is fixed at compile time. The interface
+   /// matches fibre, but indexing and iteration multiply by a
+   /// constant and elements are returned as fixed_fibre_view, so
+   /// per-fibre loops (3-vectors, 6 component tensors and so on) can
+   /// be unrolled and vectorised.
+   ///
+   template< class T,
+             index N >
+   class fixed_fibre
+      : public vector<T>
+   {
+   public:
+
+      typedef vector<T>                     super_type;
+      typedef T                             value_type;
+      typedef typename vector<T>::size_type size_type;
+      typedef fibre_iterator<T,N>           iterator;
+      typedef const_fibre_iterator<T,N>     const_iterator;
+      typedef fixed_fibre_view<T,N>         reference;
+      typedef fixed_fibre_view<const T,N>   const_reference;
+
+      static const index fixed_size = N;
+
+      fixed_fibre( index size = 0 )
+         : vector<T>(),
+           _num_fibres( 0 )
+      {
+         this->resize( size );
+      }
+
+      ~fixed_fibre()
+      {
+      }
+
+      ///
+      /// Only present for interface compatibility with fibre; the
+      /// size must match N.
+      ///
+      void
+      set_fibre_size( size_type size )
+      {
+	 ASSERT( size == N, "Fixed fibre size cannot be changed." );
+	 this->deallocate();
+      }
+
+      void
+      take( fixed_fibre& src )
+      {
+         super_type::take( src );
+         _num_fibres = src._num_fibres;
+         src._num_fibres = 0;
+      }
+
+      static size_type
+      fibre_size()
+      {
+	 return N;
+      }
+
+      size_type
+      size() const
+      {
+	 return this->_num_fibres;
+      }
+
+      size_type
+      max_size() const
+      {
+	 return vector<T>::max_size()/N;
+      }
+
+      size_type
+      capacity() const
+      {
+	 return vector<T>::capacity()/N;
+      }
+
+      void
+      reserve( size_type size )
+      {
+	 vector<T>::reserve(size*N);
+      }
+
+      void
+      resize( size_type size )
+      {
+	 vector<T>::resize(size*N);
+	 this->_num_fibres = size;
+      }
+
+      void
+      reallocate( size_type size )
+      {
+	 vector<T>::reallocate(size*N);
+	 this->_num_fibres = size;
+      }
+
+      void
+      reallocate( size_type fibre_size,
+                  size_type size )
+      {
+         set_fibre_size( fibre_size );
+         reallocate( size );
+      }
+
+      void
+      clear()
+      {
+	 vector<T>::clear();
+	 this->_num_fibres = 0;
+      }
+
+      void
+      deallocate()
+      {
+	 this->clear();
+	 vector<T>().swap(*this);
+      }
+
+      const_iterator
+      begin() const
+      {
+         return const_iterator( vector<T>::begin(), N );
+      }
+
+      iterator
+      begin()
+      {
+         return iterator( vector<T>::begin(), N );
+      }
+
+      const_iterator
+      end() const
+      {
+         return const_iterator( vector<T>::end(), N );
+      }
+
+      iterator
+      end()
+      {
+         return iterator( vector<T>::end(), N );
+      }
+
+      typename vector<T>::iterator
+      vbegin()
+      {
+         return vector<T>::begin();
+      }
+
+      typename vector<T>::iterator
+      vend()
+      {
+         return vector<T>::end();
+      }
+
+      const_reference
+      front() const
+      {
+         return (*this)[0];
+      }
+
+      const_reference
+      back() const
+      {
+         return (*this)[_num_fibres - 1];
+      }
+
+      const_reference
+      operator[]( index idx ) const
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 return const_reference( vector<T>::data() + idx*N );
+      }
+
+      reference
+      operator[]( index idx )
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 return reference( vector<T>::data() + idx*N );
+      }
+
+      T
+      operator()( index idx,
+		  index fibre_idx ) const
+      {
+	 ASSERT( fibre_idx < N );
+	 return vector<T>::operator[]( idx*N + fibre_idx );
+      }
+
+      T&
+      operator()( index idx,
+		  index fibre_idx )
+      {
+	 ASSERT( fibre_idx < N );
+	 return vector<T>::operator[]( idx*N + fibre_idx );
+      }
+
+      friend std::ostream&
+      operator<<( std::ostream& strm,
+		  const fixed_fibre& obj )
+      {
+	 strm << "[";
+	 for(index ii = 0; ii < obj.size(); ++ii) {
+	    if(ii)
+	       strm << ", ";
+	    strm << "(" << obj(ii, 0);
+	    for(index jj = 1; jj < N; ++jj)
+	       strm << ", " << obj(ii, jj);
+	    strm << ")";
+	 }
+	 strm << "]";
+	 return strm;
+      }
+
+   private:
+
+      size_type _num_fibres;
+   };
+
+   template< class T,
+             index N >
+   fibre_iterator<T,N>
+   operator+( ptrdiff_t op_a, const fibre_iterator<T,N>& op_b )
    {
-      return fibre_iterator<T>( op_b.base() + op_a*op_b.fibre_size(), op_b.fibre_size() );
+      return fibre_iterator<T,N>( op_b.base() + op_a*op_b.fibre_size(), op_b.fibre_size() );
    }
 
-   template< class T >
-   const_fibre_iterator<T>
-   operator+( ptrdiff_t op_a, const const_fibre_iterator<T>& op_b )
+   template< class T,
+             index N >
+   const_fibre_iterator<T,N>
+   operator+( ptrdiff_t op_a, const const_fibre_iterator<T,N>& op_b )
    {
-      return const_fibre_iterator<T>( op_b.base() + op_a*op_b.fibre_size(), op_b.fibre_size() );
+      return const_fibre_iterator<T,N>( op_b.base() + op_a*op_b.fibre_size(), op_b.fibre_size() );
    }
 }
 
@@ -0,0 +1,752 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef containers_fibre_layout_hh
+#define containers_fibre_layout_hh
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/static_assert.hpp>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/debug/except.hh"
+#include "fibre.hh"
+
+namespace hpc {
+
+   ///
+   /// Alignment in bytes of the blocked fibre layouts.
+   ///
+   static const index fibre_alignment = 64;
+
+   ///
+   /// Structure of arrays. Each component is stored contiguously for
+   /// all fibres, and the component arrays are padded to a whole
+   /// number of cache lines so each one starts aligned.
+   ///
+   struct soa_layout
+   {
+      static index
+      block_size( index capacity )
+      {
+	 return capacity;
+      }
+
+      static index
+      round_capacity( index size,
+		      index lanes )
+      {
+	 return ((size + lanes - 1)/lanes)*lanes;
+      }
+
+      static index
+      offset( index idx,
+	      index comp,
+	      index,
+	      index block )
+      {
+	 return comp*block + idx;
+      }
+   };
+
+   ///
+   /// Array of structures of arrays. Fibres are grouped into blocks
+   /// of B, and within a block each component is stored
+   /// contiguously. Blocks are aligned when B*sizeof(T) is a multiple
+   /// of fibre_alignment; B should be a multiple of the SIMD width.
+   ///
+   template< index B >
+   struct aosoa_layout
+   {
+      BOOST_STATIC_ASSERT( B > 0 );
+
+      static index
+      block_size( index )
+      {
+	 return B;
+      }
+
+      static index
+      round_capacity( index size,
+		      index )
+      {
+	 return ((size + B - 1)/B)*B;
+      }
+
+      static index
+      offset( index idx,
+	      index comp,
+	      index fibre_size,
+	      index )
+      {
+	 return (idx/B)*fibre_size*B + comp*B + idx%B;
+      }
+   };
+
+   ///
+   /// Iterator over elements `stride` apart.
+   ///
+   template< class T >
+   class strided_iterator
+      : public boost::iterator_facade< strided_iterator<T>,
+				       T,
+				       std::random_access_iterator_tag >
+   {
+      friend class boost::iterator_core_access;
+
+   public:
+
+      strided_iterator()
+	 : _ptr( 0 ),
+	   _stride( 0 )
+      {
+      }
+
+      strided_iterator( T* ptr,
+			index stride )
+	 : _ptr( ptr ),
+	   _stride( stride )
+      {
+      }
+
+   protected:
+
+      T&
+      dereference() const
+      {
+	 return *this->_ptr;
+      }
+
+      bool
+      equal( const strided_iterator& op ) const
+      {
+	 return this->_ptr == op._ptr;
+      }
+
+      void
+      increment()
+      {
+	 this->_ptr += this->_stride;
+      }
+
+      void
+      decrement()
+      {
+	 this->_ptr -= this->_stride;
+      }
+
+      void
+      advance( ptrdiff_t op )
+      {
+	 this->_ptr += op*this->_stride;
+      }
+
+      ptrdiff_t
+      distance_to( const strided_iterator& op ) const
+      {
+	 return (op._ptr - this->_ptr)/this->_stride;
+      }
+
+   protected:
+
+      T* _ptr;
+      index _stride;
+   };
+
+   ///
+   /// View of one fibre in a blocked layout, where consecutive
+   /// components are `stride` elements apart. Supports `size`,
+   /// indexing and `begin`/`end` like the vector views of fibre;
+   /// there is no `data` as the components are not contiguous.
+   ///
+   template< class T >
+   class strided_fibre_view
+   {
+   public:
+
+      typedef T                   value_type;
+      typedef index               size_type;
+      typedef strided_iterator<T> iterator;
+      typedef strided_iterator<T> const_iterator;
+
+      strided_fibre_view( T* ptr,
+			  index size,
+			  index stride )
+	 : _ptr( ptr ),
+	   _size( size ),
+	   _stride( stride )
+      {
+      }
+
+      size_type
+      size() const
+      {
+	 return this->_size;
+      }
+
+      index
+      stride() const
+      {
+	 return this->_stride;
+      }
+
+      T&
+      operator[]( index idx ) const
+      {
+	 ASSERT(idx >= 0 && idx < this->_size, "Index out of bounds.");
+	 return this->_ptr[idx*this->_stride];
+      }
+
+      iterator
+      begin() const
+      {
+	 return iterator(this->_ptr, this->_stride);
+      }
+
+      iterator
+      end() const
+      {
+	 return iterator(this->_ptr + this->_size*this->_stride, this->_stride);
+      }
+
+   private:
+
+      T* _ptr;
+      index _size;
+      index _stride;
+   };
+
+   template< class Fibre,
+	     class View >
+   class blocked_fibre_iterator
+      : public boost::iterator_facade< blocked_fibre_iterator<Fibre,View>,
+				       View,
+				       std::random_access_iterator_tag,
+				       View >
+   {
+      friend class boost::iterator_core_access;
+
+   public:
+
+      blocked_fibre_iterator()
+	 : _fbr( 0 ),
+	   _idx( 0 )
+      {
+      }
+
+      blocked_fibre_iterator( Fibre* fbr,
+			      index idx )
+	 : _fbr( fbr ),
+	   _idx( idx )
+      {
+      }
+
+      ///
+      /// Overridden so we return a view rather than a proxy.
+      ///
+      View
+      operator[]( ptrdiff_t op ) const
+      {
+	 return (*this->_fbr)[this->_idx + op];
+      }
+
+   protected:
+
+      View
+      dereference() const
+      {
+	 return (*this->_fbr)[this->_idx];
+      }
+
+      bool
+      equal( const blocked_fibre_iterator& op ) const
+      {
+	 return this->_idx == op._idx;
+      }
+
+      void
+      increment()
+      {
+	 ++this->_idx;
+      }
+
+      void
+      decrement()
+      {
+	 --this->_idx;
+      }
+
+      void
+      advance( ptrdiff_t op )
+      {
+	 this->_idx += op;
+      }
+
+      ptrdiff_t
+      distance_to( const blocked_fibre_iterator& op ) const
+      {
+	 return op._idx - this->_idx;
+      }
+
+   protected:
+
+      Fibre* _fbr;
+      index _idx;
+   };
+
+   ///
+   /// Fibre storage in a blocked layout (soa_layout or
+   /// aosoa_layout). The interface follows fibre, except that fibres
+   /// are returned as strided views rather than vector views.
+   ///
+   /// Per-component kernels should loop over `block`, which returns
+   /// an aligned, contiguous run of `block_size()` values of one
+   /// component. Slots past `size()` are kept zeroed, so kernels can
+   /// process whole blocks without a remainder loop.
+   ///
+   /// Storage is drawn from `Alloc`, rebound to bytes, with enough
+   /// slack to align the values to `fibre_alignment`.
+   ///
+   template< class T,
+	     class Layout,
+	     class Alloc = std::allocator<T> >
+   class blocked_fibre
+   {
+   public:
+
+      BOOST_STATIC_ASSERT( boost::is_pod<T>::value );
+
+      typedef typename Alloc::template rebind<char>::other                      byte_allocator;
+
+      typedef T                                                                 value_type;
+      typedef Alloc                                                             allocator_type;
+      typedef index                                                             size_type;
+      typedef strided_fibre_view<T>                                             reference;
+      typedef strided_fibre_view<const T>                                       const_reference;
+      typedef blocked_fibre_iterator<blocked_fibre,reference>                   iterator;
+      typedef blocked_fibre_iterator<const blocked_fibre,const_reference>       const_iterator;
+
+      blocked_fibre( index fibre_size = 0,
+		     index size = 0,
+		     const Alloc& alloc = Alloc() )
+	 : _alloc( alloc ),
+	   _raw( 0 ),
+	   _data( 0 ),
+	   _fibre_size( fibre_size ),
+	   _num_fibres( 0 ),
+	   _capacity( 0 ),
+	   _block( 0 )
+      {
+	 this->resize(size);
+      }
+
+      blocked_fibre( const blocked_fibre& src )
+	 : _alloc( src._alloc ),
+	   _raw( 0 ),
+	   _data( 0 ),
+	   _fibre_size( 0 ),
+	   _num_fibres( 0 ),
+	   _capacity( 0 ),
+	   _block( 0 )
+      {
+	 *this = src;
+      }
+
+      ~blocked_fibre()
+      {
+	 this->deallocate();
+      }
+
+      blocked_fibre&
+      operator=( const blocked_fibre& src )
+      {
+	 if(this != &src) {
+	    this->set_fibre_size(src._fibre_size);
+	    this->_allocate(src._capacity);
+	    if(this->_capacity)
+	       memcpy(this->_data, src._data, this->_storage_size()*sizeof(T));
+	    this->_num_fibres = src._num_fibres;
+	 }
+	 return *this;
+      }
+
+      void
+      set_fibre_size( size_type size )
+      {
+	 this->deallocate();
+	 this->_fibre_size = size;
+      }
+
+      void
+      take( blocked_fibre& src )
+      {
+	 this->deallocate();
+	 std::swap(this->_alloc, src._alloc);
+	 std::swap(this->_raw, src._raw);
+	 std::swap(this->_data, src._data);
+	 std::swap(this->_fibre_size, src._fibre_size);
+	 std::swap(this->_num_fibres, src._num_fibres);
+	 std::swap(this->_capacity, src._capacity);
+	 std::swap(this->_block, src._block);
+      }
+
+      allocator_type
+      get_allocator() const
+      {
+	 return this->_alloc;
+      }
+
+      size_type
+      fibre_size() const
+      {
+	 return this->_fibre_size;
+      }
+
+      size_type
+      size() const
+      {
+	 return this->_num_fibres;
+      }
+
+      bool
+      empty() const
+      {
+	 return !this->_num_fibres;
+      }
+
+      size_type
+      capacity() const
+      {
+	 return this->_capacity;
+      }
+
+      void
+      reserve( size_type size )
+      {
+	 if(size > this->_capacity)
+	    this->_relayout(Layout::round_capacity(size, _lanes()));
+      }
+
+      void
+      resize( size_type size )
+      {
+	 if(size > this->_capacity)
+	    this->_relayout(Layout::round_capacity(std::max(size, 2*this->_capacity), _lanes()));
+	 else if(size < this->_num_fibres)
+	    this->_zero(size, this->_num_fibres);
+	 this->_num_fibres = size;
+      }
+
+      void
+      reallocate( size_type size )
+      {
+	 this->deallocate();
+	 if(size) {
+	    this->_allocate(Layout::round_capacity(size, _lanes()));
+	    this->_num_fibres = size;
+	 }
+      }
+
+      void
+      reallocate( size_type fibre_size,
+		  size_type size )
+      {
+	 this->set_fibre_size(fibre_size);
+	 this->reallocate(size);
+      }
+
+      void
+      clear()
+      {
+	 this->_zero(0, this->_num_fibres);
+	 this->_num_fibres = 0;
+      }
+
+      void
+      deallocate()
+      {
+	 if(this->_raw) {
+	    byte_allocator alloc(this->_alloc);
+	    alloc.deallocate(this->_raw, _raw_size(this->_capacity, this->_fibre_size));
+	    this->_raw = 0;
+	 }
+	 this->_data = 0;
+	 this->_num_fibres = 0;
+	 this->_capacity = 0;
+	 this->_block = 0;
+      }
+
+      ///
+      /// Number of fibres per block. For soa_layout the whole
+      /// capacity is one block.
+      ///
+      index
+      block_size() const
+      {
+	 return this->_block;
+      }
+
+      index
+      num_blocks() const
+      {
+	 return this->_block ? (this->_num_fibres + this->_block - 1)/this->_block : 0;
+      }
+
+      const T*
+      block( index blk,
+	     index comp ) const
+      {
+	 ASSERT(blk >= 0 && blk < this->num_blocks(), "Invalid block.");
+	 ASSERT(comp >= 0 && comp < this->_fibre_size, "Invalid component.");
+	 return this->_data + Layout::offset(blk*this->_block, comp, this->_fibre_size, this->_block);
+      }
+
+      T*
+      block( index blk,
+	     index comp )
+      {
+	 ASSERT(blk >= 0 && blk < this->num_blocks(), "Invalid block.");
+	 ASSERT(comp >= 0 && comp < this->_fibre_size, "Invalid component.");
+	 return this->_data + Layout::offset(blk*this->_block, comp, this->_fibre_size, this->_block);
+      }
+
+      const_iterator
+      begin() const
+      {
+	 return const_iterator(this, 0);
+      }
+
+      iterator
+      begin()
+      {
+	 return iterator(this, 0);
+      }
+
+      const_iterator
+      end() const
+      {
+	 return const_iterator(this, this->_num_fibres);
+      }
+
+      iterator
+      end()
+      {
+	 return iterator(this, this->_num_fibres);
+      }
+
+      const_reference
+      front() const
+      {
+	 return (*this)[0];
+      }
+
+      const_reference
+      back() const
+      {
+	 return (*this)[this->_num_fibres - 1];
+      }
+
+      const_reference
+      operator[]( index idx ) const
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 return const_reference(this->_data + Layout::offset(idx, 0, this->_fibre_size, this->_block),
+				this->_fibre_size, this->_block);
+      }
+
+      reference
+      operator[]( index idx )
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 return reference(this->_data + Layout::offset(idx, 0, this->_fibre_size, this->_block),
+			  this->_fibre_size, this->_block);
+      }
+
+      T
+      operator()( index idx,
+		  index fibre_idx ) const
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 ASSERT(fibre_idx >= 0 && fibre_idx < this->_fibre_size);
+	 return this->_data[Layout::offset(idx, fibre_idx, this->_fibre_size, this->_block)];
+      }
+
+      T&
+      operator()( index idx,
+		  index fibre_idx )
+      {
+	 ASSERT(idx >= 0 && idx < this->_num_fibres, "Index out of bounds.");
+	 ASSERT(fibre_idx >= 0 && fibre_idx < this->_fibre_size);
+	 return this->_data[Layout::offset(idx, fibre_idx, this->_fibre_size, this->_block)];
+      }
+
+      friend std::ostream&
+      operator<<( std::ostream& strm,
+		  const blocked_fibre& obj )
+      {
+	 strm << "[";
+	 for(index ii = 0; ii < obj.size(); ++ii) {
+	    if(ii)
+	       strm << ", ";
+	    strm << "(";
+	    for(index jj = 0; jj < obj._fibre_size; ++jj) {
+	       if(jj)
+		  strm << ", ";
+	       strm << obj(ii, jj);
+	    }
+	    strm << ")";
+	 }
+	 strm << "]";
+	 return strm;
+      }
+
+   protected:
+
+      static index
+      _lanes()
+      {
+	 return std::max<index>(fibre_alignment/sizeof(T), 1);
+      }
+
+      index
+      _storage_size() const
+      {
+	 return this->_capacity*this->_fibre_size;
+      }
+
+      static size_t
+      _raw_size( index capacity,
+		 index fibre_size )
+      {
+	 return capacity*fibre_size*sizeof(T) + fibre_alignment - 1;
+      }
+
+      void
+      _allocate( index capacity )
+      {
+	 this->deallocate();
+	 if(!capacity || !this->_fibre_size)
+	    return;
+	 byte_allocator alloc(this->_alloc);
+	 this->_raw = alloc.allocate(_raw_size(capacity, this->_fibre_size));
+	 EXCEPT(this->_raw, "Failed to allocate fibre storage.");
+	 this->_data = (T*)(((size_t)this->_raw + fibre_alignment - 1) & ~(size_t)(fibre_alignment - 1));
+	 this->_capacity = capacity;
+	 this->_block = Layout::block_size(capacity);
+	 memset(this->_data, 0, this->_storage_size()*sizeof(T));
+      }
+
+      ///
+      /// Move to storage with a new capacity, keeping the existing
+      /// fibres.
+      ///
+      void
+      _relayout( index capacity )
+      {
+	 blocked_fibre tmp(this->_fibre_size, 0, this->_alloc);
+	 tmp._allocate(capacity);
+	 index num_fibres = std::min(this->_num_fibres, capacity);
+	 for(index comp = 0; comp < this->_fibre_size; ++comp) {
+	    for(index ii = 0; ii < num_fibres; ++ii)
+	       tmp._data[Layout::offset(ii, comp, tmp._fibre_size, tmp._block)] =
+		  this->_data[Layout::offset(ii, comp, this->_fibre_size, this->_block)];
+	 }
+	 tmp._num_fibres = num_fibres;
+	 this->take(tmp);
+      }
+
+      void
+      _zero( index first,
+	     index last )
+      {
+	 for(index comp = 0; comp < this->_fibre_size; ++comp) {
+	    for(index ii = first; ii < last; ++ii)
+	       this->_data[Layout::offset(ii, comp, this->_fibre_size, this->_block)] = 0;
+	 }
+      }
+
+   protected:
+
+      Alloc _alloc;
+      char* _raw;
+      T* _data;
+      index _fibre_size;
+      index _num_fibres;
+      index _capacity;
+      index _block;
+   };
+
+   template< class T,
+	     class Alloc >
+   class fibre<T,soa_layout,Alloc>
+      : public blocked_fibre<T,soa_layout,Alloc>
+   {
+   public:
+
+      fibre( index fibre_size = 0,
+	     index size = 0,
+	     const Alloc& alloc = Alloc() )
+	 : blocked_fibre<T,soa_layout,Alloc>( fibre_size, size, alloc )
+      {
+      }
+   };
+
+   template< class T,
+	     index B,
+	     class Alloc >
+   class fibre<T,aosoa_layout<B>,Alloc>
+      : public blocked_fibre<T,aosoa_layout<B>,Alloc>
+   {
+   public:
+
+      fibre( index fibre_size = 0,
+	     index size = 0,
+	     const Alloc& alloc = Alloc() )
+	 : blocked_fibre<T,aosoa_layout<B>,Alloc>( fibre_size, size, alloc )
+      {
+      }
+   };
+
+   ///
+   /// Copy fibres between any two layouts. The copy is done in tiles
+   /// of fibres so both sides are walked in cache sized pieces.
+   ///
+   template< class Src,
+	     class Dst >
+   void
+   convert_layout( const Src& src,
+		   Dst& dst )
+   {
+      static const index tile = 64;
+      index fibre_size = src.fibre_size();
+      index size = src.size();
+      dst.reallocate(fibre_size, size);
+      for(index first = 0; first < size; first += tile) {
+	 index last = std::min(first + tile, size);
+	 for(index comp = 0; comp < fibre_size; ++comp) {
+	    for(index ii = first; ii < last; ++ii)
+	       dst(ii, comp) = src(ii, comp);
+	 }
+      }
+   }
+}
+
+#endif
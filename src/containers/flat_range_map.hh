@@ -0,0 +1,269 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_containers_flat_range_map_hh
+#define hpc_containers_flat_range_map_hh
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include "range.hh"
+
+namespace hpc {
+
+   ///
+   /// Map from disjoint ranges to values, held in one sorted array.
+   /// Adjacent ranges with equal values are coalesced. Where a new
+   /// range overlaps existing ones it takes over the overlapped part,
+   /// leaving the remainders of the old ranges in place, the same as
+   /// assigning through `range_map::insert`.
+   ///
+   /// Lookups binary search a separate array of range starts, which
+   /// is dense and needs no pointer chasing. Fill with `build`, which
+   /// resolves overlaps in O(n log n); `insert` is O(n) and suits
+   /// occasional updates only.
+   ///
+   template< class T,
+             class Value >
+   class flat_range_map
+   {
+   public:
+
+      typedef range<T> range_type;
+      typedef Value mapped_type;
+      typedef std::pair<range_type,Value> value_type;
+      typedef size_t size_type;
+      typedef typename std::vector<value_type>::const_iterator iterator;
+      typedef iterator const_iterator;
+
+   public:
+
+      void
+      clear()
+      {
+         _elems.clear();
+         _starts.clear();
+      }
+
+      ///
+      /// Build from pairs of range and value, such as those of a
+      /// `range_map`. Where input ranges overlap, later ones win.
+      ///
+      template< class Iterator >
+      void
+      build( Iterator start,
+             const Iterator& finish )
+      {
+         std::vector<value_type> in( start, finish );
+
+         // Sweep over range boundaries, keeping the ranges open at
+         // each point in a heap ordered by input position.
+         std::vector<event> evts;
+         evts.reserve( 2*in.size() );
+         for( size_type ii = 0; ii < in.size(); ++ii )
+         {
+            if( in[ii].first.length() )
+            {
+               evts.push_back( event( in[ii].first.start(), ii, true ) );
+               evts.push_back( event( in[ii].first.finish(), ii, false ) );
+            }
+         }
+         std::sort( evts.begin(), evts.end() );
+
+         _elems.clear();
+         std::vector<char> open( in.size(), 0 );
+         std::priority_queue<size_type> heap;
+         T prev = T();
+         for( size_type ii = 0; ii < evts.size(); )
+         {
+            T pos = evts[ii].pos;
+            if( !heap.empty() )
+               _append( range_type( prev, pos ), in[heap.top()].second );
+            for( ; ii < evts.size() && evts[ii].pos == pos; ++ii )
+            {
+               open[evts[ii].idx] = evts[ii].open;
+               if( evts[ii].open )
+                  heap.push( evts[ii].idx );
+            }
+            while( !heap.empty() && !open[heap.top()] )
+               heap.pop();
+            prev = pos;
+         }
+         _index();
+      }
+
+      void
+      insert( const range_type& rng,
+              const Value& value )
+      {
+         if( !rng.length() )
+            return;
+
+         // Replace the overlapped entries with the remainders either
+         // side of the new range.
+         size_type lo = _first_after( rng.start() );
+         size_type hi = std::lower_bound( _starts.begin(), _starts.end(), rng.finish() ) - _starts.begin();
+         hi = std::max( lo, hi );
+         std::vector<value_type> repl;
+         repl.reserve( 3 );
+         if( lo < hi && _elems[lo].first.start() < rng.start() )
+            repl.push_back( value_type( range_type( _elems[lo].first.start(), rng.start() ), _elems[lo].second ) );
+         repl.push_back( value_type( rng, value ) );
+         if( lo < hi && _elems[hi - 1].first.finish() > rng.finish() )
+            repl.push_back( value_type( range_type( rng.finish(), _elems[hi - 1].first.finish() ), _elems[hi - 1].second ) );
+         _elems.erase( _elems.begin() + lo, _elems.begin() + hi );
+         _elems.insert( _elems.begin() + lo, repl.begin(), repl.end() );
+
+         // Coalesce around the new entries.
+         size_type first = lo ? lo - 1 : 0;
+         size_type last = std::min( lo + repl.size() + 1, _elems.size() );
+         size_type out = first;
+         for( size_type ii = first + 1; ii < last; ++ii )
+         {
+            if( !_coalesce( _elems[out], _elems[ii] ) )
+               _elems[++out] = _elems[ii];
+         }
+         if( last > first )
+            _elems.erase( _elems.begin() + out + 1, _elems.begin() + last );
+         _index();
+      }
+
+      size_type
+      size() const
+      {
+         return _elems.size();
+      }
+
+      bool
+      empty() const
+      {
+         return _elems.empty();
+      }
+
+      iterator
+      begin() const
+      {
+         return _elems.begin();
+      }
+
+      iterator
+      end() const
+      {
+         return _elems.end();
+      }
+
+      ///
+      /// The entry whose range contains `key`, or `end()`.
+      ///
+      iterator
+      find( const T& key ) const
+      {
+         typename std::vector<T>::const_iterator it = std::upper_bound( _starts.begin(), _starts.end(), key );
+         if( it == _starts.begin() )
+            return end();
+         iterator res = _elems.begin() + (it - _starts.begin() - 1);
+         return (key < res->first.finish()) ? res : end();
+      }
+
+      bool
+      has( const T& key ) const
+      {
+         return find( key ) != end();
+      }
+
+      ///
+      /// The entries intersecting `rng`, as a half open span.
+      ///
+      std::pair<iterator,iterator>
+      overlapping( const range_type& rng ) const
+      {
+         size_type lo = _first_after( rng.start() );
+         size_type hi = std::lower_bound( _starts.begin(), _starts.end(), rng.finish() ) - _starts.begin();
+         return std::make_pair( _elems.begin() + lo, _elems.begin() + std::max( lo, hi ) );
+      }
+
+   protected:
+
+      struct event
+      {
+         event( const T& pos,
+                size_type idx,
+                bool open )
+            : pos( pos ),
+              idx( idx ),
+              open( open )
+         {
+         }
+
+         bool
+         operator<( const event& op ) const
+         {
+            return pos < op.pos;
+         }
+
+         T pos;
+         size_type idx;
+         bool open;
+      };
+
+      static
+      bool
+      _coalesce( value_type& dst,
+                 const value_type& src )
+      {
+         if( dst.first.finish() == src.first.start() && dst.second == src.second )
+         {
+            dst.first.set_finish( src.first.finish() );
+            return true;
+         }
+         return false;
+      }
+
+      void
+      _append( const range_type& rng,
+               const Value& value )
+      {
+         value_type elem( rng, value );
+         if( _elems.empty() || !_coalesce( _elems.back(), elem ) )
+            _elems.push_back( elem );
+      }
+
+      // First entry finishing after `key`.
+      size_type
+      _first_after( const T& key ) const
+      {
+         size_type idx = std::upper_bound( _starts.begin(), _starts.end(), key ) - _starts.begin();
+         return (idx && _elems[idx - 1].first.finish() > key) ? idx - 1 : idx;
+      }
+
+      void
+      _index()
+      {
+         _starts.resize( _elems.size() );
+         for( size_type ii = 0; ii < _elems.size(); ++ii )
+            _starts[ii] = _elems[ii].first.start();
+      }
+
+   protected:
+
+      std::vector<value_type> _elems;
+      std::vector<T> _starts;
+   };
+
+}
+
+#endif
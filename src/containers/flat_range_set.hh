@@ -0,0 +1,202 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_containers_flat_range_set_hh
+#define hpc_containers_flat_range_set_hh
+
+#include <vector>
+#include <algorithm>
+#include "range.hh"
+
+namespace hpc {
+
+   template< class T >
+   struct range_start_less
+   {
+      bool
+      operator()( const range<T>& op_a,
+                  const range<T>& op_b ) const
+      {
+         return op_a.start() < op_b.start();
+      }
+   };
+
+   ///
+   /// Set of disjoint ranges held in one sorted array. Overlapping or
+   /// touching ranges are merged, so the set describes which values
+   /// are covered rather than how they were inserted.
+   ///
+   /// Lookups binary search a separate array of range starts, which
+   /// is dense and needs no pointer chasing. Fill with `build`, which
+   /// sorts and merges in O(n log n); `insert` is O(n) and suits
+   /// occasional updates only.
+   ///
+   template< class T >
+   class flat_range_set
+   {
+   public:
+
+      typedef range<T> range_type;
+      typedef range_type value_type;
+      typedef size_t size_type;
+      typedef typename std::vector<range_type>::const_iterator iterator;
+      typedef iterator const_iterator;
+
+   public:
+
+      void
+      clear()
+      {
+         _rngs.clear();
+         _starts.clear();
+      }
+
+      template< class Iterator >
+      void
+      build( Iterator start,
+             const Iterator& finish )
+      {
+         std::vector<range_type> in( start, finish );
+         std::sort( in.begin(), in.end(), range_start_less<T>() );
+         _rngs.clear();
+         _rngs.reserve( in.size() );
+         for( typename std::vector<range_type>::const_iterator it = in.begin(); it != in.end(); ++it )
+         {
+            if( !it->length() )
+               continue;
+            if( !_rngs.empty() && it->start() <= _rngs.back().finish() )
+            {
+               if( it->finish() > _rngs.back().finish() )
+                  _rngs.back().set_finish( it->finish() );
+            }
+            else
+               _rngs.push_back( *it );
+         }
+         _index();
+      }
+
+      void
+      insert( const range_type& rng )
+      {
+         if( !rng.length() )
+            return;
+
+         // Anything overlapping or touching is absorbed.
+         size_type lo = _first_touching( rng.start() );
+         size_type hi = std::upper_bound( _starts.begin(), _starts.end(), rng.finish() ) - _starts.begin();
+         range_type merged( rng );
+         if( lo < hi )
+         {
+            merged.set( std::min( rng.start(), _rngs[lo].start() ),
+                        std::max( rng.finish(), _rngs[hi - 1].finish() ) );
+            _rngs.erase( _rngs.begin() + lo + 1, _rngs.begin() + hi );
+            _rngs[lo] = merged;
+         }
+         else
+            _rngs.insert( _rngs.begin() + lo, merged );
+         _index();
+      }
+
+      size_type
+      size() const
+      {
+         return _rngs.size();
+      }
+
+      bool
+      empty() const
+      {
+         return _rngs.empty();
+      }
+
+      iterator
+      begin() const
+      {
+         return _rngs.begin();
+      }
+
+      iterator
+      end() const
+      {
+         return _rngs.end();
+      }
+
+      ///
+      /// The range containing `value`, or `end()`.
+      ///
+      iterator
+      find( const T& value ) const
+      {
+         typename std::vector<T>::const_iterator it = std::upper_bound( _starts.begin(), _starts.end(), value );
+         if( it == _starts.begin() )
+            return end();
+         iterator res = _rngs.begin() + (it - _starts.begin() - 1);
+         return (value < res->finish()) ? res : end();
+      }
+
+      bool
+      has( const T& value ) const
+      {
+         return find( value ) != end();
+      }
+
+      ///
+      /// The ranges intersecting `rng`, as a half open span.
+      ///
+      std::pair<iterator,iterator>
+      overlapping( const range_type& rng ) const
+      {
+         size_type lo = _first_after( rng.start() );
+         size_type hi = std::lower_bound( _starts.begin(), _starts.end(), rng.finish() ) - _starts.begin();
+         return std::make_pair( _rngs.begin() + lo, _rngs.begin() + std::max( lo, hi ) );
+      }
+
+   protected:
+
+      // First range finishing after `value`.
+      size_type
+      _first_after( const T& value ) const
+      {
+         size_type idx = std::upper_bound( _starts.begin(), _starts.end(), value ) - _starts.begin();
+         return (idx && _rngs[idx - 1].finish() > value) ? idx - 1 : idx;
+      }
+
+      // First range finishing at or after `value`.
+      size_type
+      _first_touching( const T& value ) const
+      {
+         size_type idx = std::upper_bound( _starts.begin(), _starts.end(), value ) - _starts.begin();
+         return (idx && _rngs[idx - 1].finish() >= value) ? idx - 1 : idx;
+      }
+
+      void
+      _index()
+      {
+         _starts.resize( _rngs.size() );
+         for( size_type ii = 0; ii < _rngs.size(); ++ii )
+            _starts[ii] = _rngs[ii].start();
+      }
+
+   protected:
+
+      std::vector<range_type> _rngs;
+      std::vector<T> _starts;
+   };
+
+}
+
+#endif
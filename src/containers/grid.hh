@@ -19,13 +19,381 @@
 #define libhpc_containers_grid_hh
 
 #include <vector>
+#include <algorithm>
+#include <boost/array.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include "libhpc/debug/assert.hh"
 #include "libhpc/system/reallocate.hh"
+#include "libhpc/algorithm/morton.hh"
 
 namespace hpc {
 
+   ///
+   /// Row-major grid indexing, with the first coordinate varying
+   /// fastest. The default for `grid`.
+   ///
    template< class T >
+   class row_major_order
+   {
+   public:
+
+      static const bool hierarchical = false;
+
+   public:
+
+      void
+      setup( const std::vector<T>& sides )
+      {
+         reallocate( _basis, sides.size() );
+         _extent = 0;
+         if( _basis.size() ) {
+            _extent = sides[0];
+            _basis[0] = 1;
+            for( unsigned ii = 1; ii < sides.size(); ++ii ) {
+               _extent *= sides[ii];
+               _basis[ii] = _basis[ii - 1]*sides[ii - 1];
+            }
+         }
+      }
+
+      T
+      extent() const
+      {
+         return _extent;
+      }
+
+      template< class InputIterator >
+      T
+      project( InputIterator first ) const
+      {
+         T idx = 0;
+         for( unsigned ii = 0; ii < _basis.size(); ++ii, ++first )
+            idx += (*first)*_basis[ii];
+         return idx;
+      }
+
+      template< class OutputIterator >
+      void
+      lift( T index,
+            OutputIterator result ) const
+      {
+         unsigned dim = _basis.size();
+         result += dim - 1;
+         for( unsigned ii = dim; ii > 0; --ii )
+         {
+            *result = index/_basis[ii - 1];
+            index -= (*result)*_basis[ii - 1];
+
+            // I put this here instead of in the loop description because I don't
+            // want to decrement an iterator pointing to the first element. C++
+            // debug mode complains about that sort of thing.
+            if( ii > 1 )
+               --result;
+         }
+      }
+
+   protected:
+
+      T _extent;
+      std::vector<T> _basis;
+   };
+
+   ///
+   /// Base for orders following a space-filling curve over the
+   /// smallest power of two cube containing the grid. Any aligned
+   /// power of two sub-cube occupies a contiguous run of the curve,
+   /// which is what lets `grid_box_iterator` walk a box in curve
+   /// order.
+   ///
+   template< class T >
+   class curve_order
+   {
+   public:
+
+      static const bool hierarchical = true;
+
+   public:
+
+      ///
+      /// Number of bits per coordinate; the cube has side 2^bits.
+      ///
+      unsigned
+      bits() const
+      {
+         return _bits;
+      }
+
+      unsigned
+      dimension() const
+      {
+         return _dim;
+      }
+
+      ///
+      /// Index storage must span, which includes the unused parts
+      /// of the cube up to the last grid cell.
+      ///
+      T
+      extent() const
+      {
+         return _extent;
+      }
+
+   protected:
+
+      void
+      _setup_bits( const std::vector<T>& sides )
+      {
+         _dim = sides.size();
+         T max_side = sides.size() ? *std::max_element( sides.begin(), sides.end() ) : 0;
+         for( _bits = 0; ((T)1 << _bits) < max_side; ++_bits );
+         ASSERT( _bits*_dim < 8*sizeof(T), "Curve index does not fit grid index type." );
+      }
+
+   protected:
+
+      unsigned _dim;
+      unsigned _bits;
+      T _extent;
+   };
+
+   ///
+   /// Morton (Z-order) grid indexing in one to three dimensions,
+   /// built on `dilate`/`morton`. Coordinates are limited to 16 bits
+   /// in 2D and 10 bits in 3D; 1D is the identity and limited only by
+   /// the index type.
+   ///
+   /// Morton indices grow with each coordinate, so storage only
+   /// needs to span up to the index of the last cell.
+   ///
+   template< class T >
+   class morton_order
+      : public curve_order<T>
+   {
+   public:
+
+      void
+      setup( const std::vector<T>& sides )
+      {
+         ASSERT( sides.size() >= 1 && sides.size() <= 3, "Morton order supports 1 to 3 dimensions." );
+         this->_setup_bits( sides );
+         ASSERT( sides.size() == 1 || this->_bits <= ((sides.size() == 3) ? 10u : 16u ),
+                 "Grid too large for Morton ordering." );
+         std::vector<T> last( sides.size() );
+         for( unsigned ii = 0; ii < sides.size(); ++ii )
+            last[ii] = sides[ii] ? sides[ii] - 1 : 0;
+         bool empty = std::find( sides.begin(), sides.end(), (T)0 ) != sides.end();
+         this->_extent = empty ? 0 : curve_index( last.begin() ) + 1;
+      }
+
+      template< class InputIterator >
+      T
+      project( InputIterator first ) const
+      {
+         return curve_index( first );
+      }
+
+      template< class InputIterator >
+      T
+      curve_index( InputIterator first ) const
+      {
+         switch( this->_dim )
+         {
+            case 1:
+               return *first;
+            case 2:
+            {
+               uint16_t x = *first++;
+               uint16_t y = *first;
+               return morton<2>( x, y );
+            }
+            default:
+            {
+               uint16_t x = *first++;
+               uint16_t y = *first++;
+               uint16_t z = *first;
+               return morton<3>( x, y, z );
+            }
+         }
+      }
+
+      template< class OutputIterator >
+      void
+      lift( T index,
+            OutputIterator result ) const
+      {
+         switch( this->_dim )
+         {
+            case 1:
+               *result = index;
+               break;
+            case 2:
+            {
+               boost::array<uint16_t,2> crd = unmorton<2>( index );
+               std::copy( crd.begin(), crd.end(), result );
+               break;
+            }
+            default:
+            {
+               boost::array<uint16_t,3> crd = unmorton<3>( index );
+               std::copy( crd.begin(), crd.end(), result );
+               break;
+            }
+         }
+      }
+   };
+
+   ///
+   /// Hilbert curve grid indexing in any dimension, using Skilling's
+   /// transpose algorithm. Neighbouring indices are always adjacent
+   /// cells, giving better locality than Morton order at a higher
+   /// cost per index. Hilbert indices don't grow with each coordinate,
+   /// so storage spans the whole cube.
+   ///
+   template< class T >
+   class hilbert_order
+      : public curve_order<T>
+   {
+   public:
+
+      void
+      setup( const std::vector<T>& sides )
+      {
+         ASSERT( sides.size() >= 1, "Hilbert order needs at least one dimension." );
+         this->_setup_bits( sides );
+         bool empty = std::find( sides.begin(), sides.end(), (T)0 ) != sides.end();
+         this->_extent = empty ? 0 : (T)1 << (this->_bits*this->_dim);
+      }
+
+      template< class InputIterator >
+      T
+      project( InputIterator first ) const
+      {
+         return curve_index( first );
+      }
+
+      template< class InputIterator >
+      T
+      curve_index( InputIterator first ) const
+      {
+         unsigned dim = this->_dim, bits = this->_bits;
+         T crd[max_dims];
+         ASSERT( dim <= max_dims, "Too many dimensions for Hilbert order." );
+         for( unsigned ii = 0; ii < dim; ++ii, ++first )
+            crd[ii] = *first;
+         if( !bits )
+            return 0;
+
+         // Inverse undo.
+         for( T qq = (T)1 << (bits - 1); qq > 1; qq >>= 1 )
+         {
+            T pp = qq - 1;
+            for( unsigned ii = 0; ii < dim; ++ii )
+            {
+               if( crd[ii] & qq )
+                  crd[0] ^= pp;
+               else
+               {
+                  T tt = (crd[0] ^ crd[ii]) & pp;
+                  crd[0] ^= tt;
+                  crd[ii] ^= tt;
+               }
+            }
+         }
+
+         // Gray encode.
+         for( unsigned ii = 1; ii < dim; ++ii )
+            crd[ii] ^= crd[ii - 1];
+         T tt = 0;
+         for( T qq = (T)1 << (bits - 1); qq > 1; qq >>= 1 )
+         {
+            if( crd[dim - 1] & qq )
+               tt ^= qq - 1;
+         }
+         for( unsigned ii = 0; ii < dim; ++ii )
+            crd[ii] ^= tt;
+
+         // Interleave the transposed bits, first axis most
+         // significant.
+         T idx = 0;
+         for( unsigned bb = bits; bb > 0; --bb )
+         {
+            for( unsigned ii = 0; ii < dim; ++ii )
+               idx = (idx << 1) | ((crd[ii] >> (bb - 1)) & 1);
+         }
+         return idx;
+      }
+
+      template< class OutputIterator >
+      void
+      lift( T index,
+            OutputIterator result ) const
+      {
+         unsigned dim = this->_dim, bits = this->_bits;
+         T crd[max_dims];
+         ASSERT( dim <= max_dims, "Too many dimensions for Hilbert order." );
+         std::fill( crd, crd + dim, 0 );
+         for( unsigned bb = bits; bb > 0; --bb )
+         {
+            for( unsigned ii = 0; ii < dim; ++ii )
+               crd[ii] |= ((index >> ((bb - 1)*dim + (dim - 1 - ii))) & 1) << (bb - 1);
+         }
+
+         if( bits )
+         {
+            // Gray decode.
+            T tt = crd[dim - 1] >> 1;
+            for( unsigned ii = dim - 1; ii > 0; --ii )
+               crd[ii] ^= crd[ii - 1];
+            crd[0] ^= tt;
+
+            // Undo excess work.
+            for( T qq = 2; qq != ((T)1 << bits); qq <<= 1 )
+            {
+               T pp = qq - 1;
+               for( unsigned ii = dim; ii > 0; --ii )
+               {
+                  if( crd[ii - 1] & qq )
+                     crd[0] ^= pp;
+                  else
+                  {
+                     tt = (crd[0] ^ crd[ii - 1]) & pp;
+                     crd[0] ^= tt;
+                     crd[ii - 1] ^= tt;
+                  }
+               }
+            }
+         }
+         std::copy( crd, crd + dim, result );
+      }
+
+   protected:
+
+      static const unsigned max_dims = 8;
+   };
+
+   template< class T,
+             class Order >
+   class grid_box_iterator;
+
+   ///
+   /// Maps between grid coordinates and linear indices. The mapping
+   /// is set by `Order`: `row_major_order` (the default),
+   /// `morton_order` or `hilbert_order`. With a curve order, `size`
+   /// is still the number of cells but indices may reach up to
+   /// `extent`, so storage indexed by the grid needs `extent`
+   /// elements.
+   ///
+   template< class T,
+             class Order = row_major_order<T> >
    class grid
    {
+   public:
+
+      typedef Order order_type;
+      typedef grid_box_iterator<T,Order> box_iterator;
+
    public:
 
       grid()
@@ -83,33 +451,71 @@ namespace hpc {
          return this->_size;
       }
 
+      ///
+      /// One past the largest index of any cell.
+      ///
+      T
+      extent() const
+      {
+         return this->_order.extent();
+      }
+
+      const std::vector<T>&
+      sides() const
+      {
+         return this->_sides;
+      }
+
+      const order_type&
+      order() const
+      {
+         return this->_order;
+      }
+
       template< class InputIterator >
       T
-      project( InputIterator first )
+      project( InputIterator first ) const
       {
-         T idx = 0;
-         for( unsigned ii = 0; ii < this->dimension(); ++ii, ++first )
-            idx += (*first)*this->_basis[ii];
-         return idx;
+         return this->_order.project( first );
       }
 
       template< class OutputIterator >
       void
       lift( T index,
-            OutputIterator result )
+            OutputIterator result ) const
       {
-         result += this->dimension() - 1;
-         for( unsigned ii = this->dimension(); ii > 0; --ii )
-         {
-            *result = index/this->_basis[ii - 1];
-            index -= (*result)*this->_basis[ii - 1];
+         this->_order.lift( index, result );
+      }
 
-            // I put this here instead of in the loop description because I don't
-            // want to decrement an iterator pointing to the first element. C++
-            // debug mode complains about that sort of thing.
-            if( ii > 1 )
-               --result;
-         }
+      ///
+      /// Iterate over the cells of the box [lower, upper) in index
+      /// order, which for a curve order is the order along the curve.
+      ///
+      template< class InputIterator >
+      box_iterator
+      box_begin( InputIterator lower,
+                 InputIterator upper ) const
+      {
+         return box_iterator( *this, lower, upper );
+      }
+
+      box_iterator
+      box_end() const
+      {
+         return box_iterator();
+      }
+
+      box_iterator
+      begin() const
+      {
+         const std::vector<T> lower( dimension(), 0 );
+         return box_iterator( *this, lower.begin(), _sides.begin() );
+      }
+
+      box_iterator
+      end() const
+      {
+         return box_iterator();
       }
 
    protected:
@@ -117,14 +523,11 @@ namespace hpc {
       void
       _setup_basis()
       {
-         reallocate( _basis, dimension() );
-         if( this->_basis.size() ) {
+         this->_order.setup( this->_sides );
+         if( this->_sides.size() ) {
             this->_size = this->_sides[0];
-            this->_basis[0] = 1;
-            for( unsigned ii = 1; ii < this->dimension(); ++ii ) {
+            for( unsigned ii = 1; ii < this->dimension(); ++ii )
                this->_size *= this->_sides[ii];
-               this->_basis[ii] = this->_basis[ii - 1]*this->_sides[ii - 1];
-            }
          }
       }
 
@@ -132,8 +535,216 @@ namespace hpc {
 
       T _size;
       std::vector<T> _sides;
-      std::vector<T> _basis;
+      Order _order;
+   };
+
+   ///
+   /// Visits the cells of a box in a grid in index order, yielding
+   /// indices; `coord` gives the current coordinates.
+   ///
+   /// Row-major orders step through the box directly. Curve orders
+   /// descend the power of two cube hierarchy, visiting the children
+   /// of each sub-cube in curve order and skipping those outside the
+   /// box, so nothing outside the box is touched beyond its border
+   /// sub-cubes.
+   ///
+   template< class T,
+             class Order >
+   class grid_box_iterator
+      : public boost::iterator_facade< grid_box_iterator<T,Order>,
+                                       T,
+                                       std::forward_iterator_tag,
+                                       T >
+   {
+      friend class boost::iterator_core_access;
+
+   public:
+
+      typedef grid<T,Order> grid_type;
+
+   public:
+
+      grid_box_iterator()
+         : _grid( 0 ),
+           _idx( 0 ),
+           _done( true )
+      {
+      }
+
+      template< class InputIterator >
+      grid_box_iterator( const grid_type& grd,
+                         InputIterator lower,
+                         InputIterator upper )
+         : _grid( &grd ),
+           _lo( lower, lower + grd.dimension() ),
+           _hi( upper, upper + grd.dimension() ),
+           _idx( 0 ),
+           _done( false )
+      {
+         for( unsigned ii = 0; ii < _lo.size(); ++ii )
+         {
+            ASSERT( _hi[ii] <= grd.sides()[ii], "Box exceeds grid." );
+            if( _lo[ii] >= _hi[ii] )
+               _done = true;
+         }
+         if( _lo.empty() )
+            _done = true;
+         if( !_done )
+            _begin( boost::integral_constant<bool,Order::hierarchical>() );
+      }
+
+      const std::vector<T>&
+      coord() const
+      {
+         return _crd;
+      }
+
+   protected:
+
+      struct frame
+      {
+         unsigned level;
+         unsigned pos;
+         std::vector<T> origin;
+         std::vector<std::pair<T,unsigned> > children;
+      };
+
+      void
+      _begin( boost::false_type )
+      {
+         _crd = _lo;
+         _idx = _grid->project( _crd.begin() );
+      }
+
+      void
+      _begin( boost::true_type )
+      {
+         unsigned bits = _grid->order().bits();
+         _crd.resize( _lo.size() );
+         _frames.resize( bits + 1 );
+         for( unsigned ii = 0; ii <= bits; ++ii )
+         {
+            _frames[ii].origin.resize( _lo.size() );
+            _frames[ii].children.reserve( 1 << _lo.size() );
+         }
+
+         // A grid of single cells has no hierarchy to descend.
+         if( !bits )
+         {
+            std::fill( _crd.begin(), _crd.end(), 0 );
+            _idx = 0;
+            _top = -1;
+            return;
+         }
+
+         frame& root = _frames[0];
+         root.level = bits;
+         std::fill( root.origin.begin(), root.origin.end(), 0 );
+         _fill_children( root );
+         _top = 0;
+         _next( boost::true_type() );
+      }
+
+      void
+      _fill_children( frame& frm )
+      {
+         T half = (T)1 << (frm.level - 1);
+         unsigned dim = _lo.size();
+         frm.pos = 0;
+         frm.children.clear();
+         for( unsigned cc = 0; cc < (1u << dim); ++cc )
+         {
+            bool inside = true;
+            for( unsigned ii = 0; ii < dim; ++ii )
+            {
+               T org = frm.origin[ii] + ((cc >> ii) & 1)*half;
+               _crd[ii] = org;
+               if( org >= _hi[ii] || org + half <= _lo[ii] )
+                  inside = false;
+            }
+            if( inside )
+               frm.children.push_back( std::make_pair( _grid->order().curve_index( _crd.begin() ), cc ) );
+         }
+         std::sort( frm.children.begin(), frm.children.end() );
+      }
+
+      void
+      _next( boost::false_type )
+      {
+         unsigned ii = 0;
+         for( ; ii < _crd.size(); ++ii )
+         {
+            if( ++_crd[ii] < _hi[ii] )
+               break;
+            _crd[ii] = _lo[ii];
+         }
+         if( ii == _crd.size() )
+            _done = true;
+         else
+            _idx = _grid->project( _crd.begin() );
+      }
+
+      void
+      _next( boost::true_type )
+      {
+         unsigned dim = _lo.size();
+         while( _top >= 0 )
+         {
+            frame& frm = _frames[_top];
+            if( frm.pos == frm.children.size() )
+            {
+               --_top;
+               continue;
+            }
+            std::pair<T,unsigned> child = frm.children[frm.pos++];
+            T half = (T)1 << (frm.level - 1);
+            if( frm.level == 1 )
+            {
+               for( unsigned ii = 0; ii < dim; ++ii )
+                  _crd[ii] = frm.origin[ii] + ((child.second >> ii) & 1);
+               _idx = child.first;
+               return;
+            }
+            frame& sub = _frames[_top + 1];
+            sub.level = frm.level - 1;
+            for( unsigned ii = 0; ii < dim; ++ii )
+               sub.origin[ii] = frm.origin[ii] + ((child.second >> ii) & 1)*half;
+            _fill_children( sub );
+            ++_top;
+         }
+         _done = true;
+      }
+
+      void
+      increment()
+      {
+         _next( boost::integral_constant<bool,Order::hierarchical>() );
+      }
+
+      bool
+      equal( const grid_box_iterator& op ) const
+      {
+         if( _done || op._done )
+            return _done == op._done;
+         return _idx == op._idx;
+      }
+
+      T
+      dereference() const
+      {
+         return _idx;
+      }
+
+   protected:
+
+      const grid_type* _grid;
+      std::vector<T> _lo, _hi, _crd;
+      T _idx;
+      bool _done;
+      int _top;
+      std::vector<frame> _frames;
    };
+
 }
 
 #endif
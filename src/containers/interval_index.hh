@@ -0,0 +1,412 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_containers_interval_index_hh
+#define hpc_containers_interval_index_hh
+
+#include <vector>
+#include <algorithm>
+#include <boost/iterator/iterator_facade.hpp>
+#include "libhpc/debug/assert.hh"
+#include "range.hh"
+
+namespace hpc {
+
+   template< class T,
+             class Value >
+   class interval_index_iterator;
+
+   ///
+   /// Static index of possibly overlapping ranges, each carrying a
+   /// value, answering stabbing and overlap queries in O(log n + k).
+   ///
+   /// Entries are kept sorted by range start. Over them sits a
+   /// centered interval tree, flattened into arrays: each node has a
+   /// center point and the entries containing it, listed once by
+   /// ascending start and once by descending finish. A stabbing query
+   /// at x walks one root to leaf path, at each node reading the
+   /// relevant list only as far as entries contain x. An overlap
+   /// query for [a,b) is a stab at a plus the entries starting in
+   /// (a,b), which are contiguous in start order.
+   ///
+   /// Results are returned as a pair of iterators over the matching
+   /// entries, produced lazily and in no particular order.
+   ///
+   template< class T,
+             class Value >
+   class interval_index
+   {
+      friend class interval_index_iterator<T,Value>;
+
+   public:
+
+      typedef range<T> range_type;
+      typedef Value mapped_type;
+      typedef std::pair<range_type,Value> value_type;
+      typedef size_t size_type;
+      typedef typename std::vector<value_type>::const_iterator iterator;
+      typedef interval_index_iterator<T,Value> query_iterator;
+      typedef std::pair<query_iterator,query_iterator> query_range;
+
+      static const size_type none = ~size_type( 0 );
+
+   public:
+
+      void
+      clear()
+      {
+         _elems.clear();
+         _starts.clear();
+         _nodes.clear();
+         _asc.clear();
+         _desc.clear();
+      }
+
+      ///
+      /// Build from pairs of range and value. Empty ranges contain
+      /// nothing and are dropped.
+      ///
+      template< class Iterator >
+      void
+      build( Iterator start,
+             const Iterator& finish )
+      {
+         clear();
+         for( ; start != finish; ++start )
+         {
+            if( start->first.length() )
+               _elems.push_back( value_type( start->first, start->second ) );
+         }
+         std::stable_sort( _elems.begin(), _elems.end(), start_less() );
+         _starts.resize( _elems.size() );
+         for( size_type ii = 0; ii < _elems.size(); ++ii )
+            _starts[ii] = _elems[ii].first.start();
+
+         std::vector<size_type> ids( _elems.size() );
+         for( size_type ii = 0; ii < ids.size(); ++ii )
+            ids[ii] = ii;
+         _asc.reserve( _elems.size() );
+         _desc.reserve( _elems.size() );
+         _build_node( ids );
+      }
+
+      size_type
+      size() const
+      {
+         return _elems.size();
+      }
+
+      bool
+      empty() const
+      {
+         return _elems.empty();
+      }
+
+      ///
+      /// All entries, in order of range start.
+      ///
+      iterator
+      begin() const
+      {
+         return _elems.begin();
+      }
+
+      iterator
+      end() const
+      {
+         return _elems.end();
+      }
+
+      ///
+      /// Entries whose range contains `value`.
+      ///
+      query_range
+      stab( const T& value ) const
+      {
+         return query_range( query_iterator( *this, value, 0, 0 ), query_iterator() );
+      }
+
+      ///
+      /// Entries whose range intersects `rng`.
+      ///
+      query_range
+      overlapping( const range_type& rng ) const
+      {
+         if( !rng.length() )
+            return query_range( query_iterator(), query_iterator() );
+         size_type first = std::upper_bound( _starts.begin(), _starts.end(), rng.start() ) - _starts.begin();
+         size_type last = std::lower_bound( _starts.begin(), _starts.end(), rng.finish() ) - _starts.begin();
+         return query_range( query_iterator( *this, rng.start(), first, last ), query_iterator() );
+      }
+
+      ///
+      /// Stab at each of a sorted sequence of probes, calling
+      /// `func( probe, entry )` for every match, where `probe` is the
+      /// position in the sequence. A single sweep over the entries
+      /// keeps a heap of those open at the current probe, so the cost
+      /// is O((n + m) log n + k) for m probes.
+      ///
+      template< class ProbeIterator,
+                class Func >
+      void
+      stab_many( ProbeIterator probe,
+                 const ProbeIterator& probe_finish,
+                 Func func ) const
+      {
+         std::vector<size_type> open;
+         finish_greater cmp( _elems );
+         size_type next = 0;
+         T prev = T();
+         for( size_type ii = 0; probe != probe_finish; ++probe, ++ii )
+         {
+            ASSERT( !ii || !(*probe < prev), "Probes must be sorted." );
+            prev = *probe;
+            while( next < _elems.size() && !(*probe < _starts[next]) )
+            {
+               open.push_back( next++ );
+               std::push_heap( open.begin(), open.end(), cmp );
+            }
+            while( !open.empty() && !(*probe < _elems[open.front()].first.finish()) )
+            {
+               std::pop_heap( open.begin(), open.end(), cmp );
+               open.pop_back();
+            }
+            for( std::vector<size_type>::const_iterator it = open.begin(); it != open.end(); ++it )
+               func( ii, _elems[*it] );
+         }
+      }
+
+   protected:
+
+      struct node
+      {
+         node( const T& center,
+               size_type begin,
+               size_type end )
+            : center( center ),
+              begin( begin ),
+              end( end ),
+              left( none ),
+              right( none )
+         {
+         }
+
+         T center;
+         size_type begin, end;
+         size_type left, right;
+      };
+
+      struct start_less
+      {
+         bool
+         operator()( const value_type& op_a,
+                     const value_type& op_b ) const
+         {
+            return op_a.first.start() < op_b.first.start();
+         }
+      };
+
+      // Orders entry ids by descending finish; as a heap comparator
+      // this keeps the earliest finish on top.
+      struct finish_greater
+      {
+         finish_greater( const std::vector<value_type>& elems )
+            : elems( &elems )
+         {
+         }
+
+         bool
+         operator()( size_type op_a,
+                     size_type op_b ) const
+         {
+            return (*elems)[op_b].first.finish() < (*elems)[op_a].first.finish();
+         }
+
+         const std::vector<value_type>* elems;
+      };
+
+      // `ids` are in start order. The center is the median start, so
+      // the node is never empty and each child gets at most half.
+      size_type
+      _build_node( std::vector<size_type>& ids )
+      {
+         if( ids.empty() )
+            return none;
+         T center = _elems[ids[ids.size()/2]].first.start();
+         std::vector<size_type> left, right;
+         size_type begin = _asc.size();
+         for( std::vector<size_type>::const_iterator it = ids.begin(); it != ids.end(); ++it )
+         {
+            const range_type& rng = _elems[*it].first;
+            if( !(center < rng.finish()) )
+               left.push_back( *it );
+            else if( center < rng.start() )
+               right.push_back( *it );
+            else
+               _asc.push_back( *it );
+         }
+         std::vector<size_type>().swap( ids );
+         size_type end = _asc.size();
+         _desc.insert( _desc.end(), _asc.begin() + begin, _asc.end() );
+         std::sort( _desc.begin() + begin, _desc.end(), finish_greater( _elems ) );
+
+         size_type self = _nodes.size();
+         _nodes.push_back( node( center, begin, end ) );
+         size_type child = _build_node( left );
+         _nodes[self].left = child;
+         child = _build_node( right );
+         _nodes[self].right = child;
+         return self;
+      }
+
+   protected:
+
+      std::vector<value_type> _elems;
+      std::vector<T> _starts;
+      std::vector<node> _nodes;
+      std::vector<size_type> _asc;
+      std::vector<size_type> _desc;
+   };
+
+   ///
+   /// Lazily walks the results of an `interval_index` query: first the
+   /// tree nodes on the stabbing path, then any trailing run of
+   /// entries in start order.
+   ///
+   template< class T,
+             class Value >
+   class interval_index_iterator
+      : public boost::iterator_facade< interval_index_iterator<T,Value>,
+                                       const typename interval_index<T,Value>::value_type,
+                                       std::forward_iterator_tag >
+   {
+      friend class boost::iterator_core_access;
+
+   public:
+
+      typedef interval_index<T,Value> index_type;
+      typedef typename index_type::value_type value_type;
+      typedef typename index_type::size_type size_type;
+
+   public:
+
+      interval_index_iterator()
+         : _idx( 0 ),
+           _value( T() ),
+           _node( index_type::none ),
+           _pos( 0 ),
+           _tail( 0 ),
+           _tail_end( 0 )
+      {
+      }
+
+      interval_index_iterator( const index_type& idx,
+                               const T& value,
+                               size_type tail,
+                               size_type tail_end )
+         : _idx( &idx ),
+           _value( value ),
+           _node( idx._nodes.empty() ? index_type::none : 0 ),
+           _pos( 0 ),
+           _tail( tail ),
+           _tail_end( std::max( tail, tail_end ) )
+      {
+         if( _node != index_type::none )
+            _pos = _idx->_nodes[_node].begin;
+         _settle();
+      }
+
+   protected:
+
+      bool
+      _at_end() const
+      {
+         return _node == index_type::none && _tail == _tail_end;
+      }
+
+      // Move forward until on a match or at the end.
+      void
+      _settle()
+      {
+         while( _node != index_type::none )
+         {
+            const typename index_type::node& cur = _idx->_nodes[_node];
+            if( _pos < cur.end )
+            {
+               if( _value < cur.center )
+               {
+                  if( !(_value < _idx->_elems[_idx->_asc[_pos]].first.start()) )
+                     return;
+               }
+               else if( _value < _idx->_elems[_idx->_desc[_pos]].first.finish() )
+                  return;
+            }
+            if( _value < cur.center )
+               _node = cur.left;
+            else if( cur.center < _value )
+               _node = cur.right;
+            else
+               _node = index_type::none;
+            if( _node != index_type::none )
+               _pos = _idx->_nodes[_node].begin;
+         }
+      }
+
+      void
+      increment()
+      {
+         if( _node != index_type::none )
+         {
+            ++_pos;
+            _settle();
+         }
+         else
+            ++_tail;
+      }
+
+      bool
+      equal( const interval_index_iterator& op ) const
+      {
+         if( _at_end() || op._at_end() )
+            return _at_end() == op._at_end();
+         return _node == op._node && _pos == op._pos && _tail == op._tail;
+      }
+
+      const value_type&
+      dereference() const
+      {
+         if( _node != index_type::none )
+         {
+            const typename index_type::node& cur = _idx->_nodes[_node];
+            return _idx->_elems[(_value < cur.center) ? _idx->_asc[_pos] : _idx->_desc[_pos]];
+         }
+         return _idx->_elems[_tail];
+      }
+
+   protected:
+
+      const index_type* _idx;
+      T _value;
+      size_type _node;
+      size_type _pos;
+      size_type _tail;
+      size_type _tail_end;
+   };
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef containers_mapped_csr_hh
+#define containers_mapped_csr_hh
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/static_assert.hpp>
+#include "libhpc/debug.hh"
+#include "libhpc/system/mapped_file.hh"
+#include "vector.hh"
+#include "csr.hh"
+
+namespace hpc {
+
+   ///
+   /// On-disk layout of a csr. The header is followed by the
+   /// displacements and then the array, each starting on a 64 byte
+   /// boundary so the mapped arrays are suitably aligned. Values are
+   /// written in native byte order; the byte order mark and sizes in
+   /// the header are checked when mapping.
+   ///
+   struct csr_file_header
+   {
+      char magic[8];
+      uint32_t version;
+      uint32_t byte_order;
+      uint32_t index_size;
+      uint32_t value_size;
+      uint64_t num_rows;
+      uint64_t array_size;
+      uint64_t displs_offset;
+      uint64_t array_offset;
+   };
+
+   static const char csr_file_magic[8] = { 'h', 'p', 'c', 'c', 's', 'r', 0, 0 };
+   static const uint32_t csr_file_version = 1;
+   static const uint32_t csr_file_byte_order = 0x01020304;
+   static const uint64_t csr_file_alignment = 64;
+
+   inline
+   uint64_t
+   csr_file_align( uint64_t offs )
+   {
+      return (offs + csr_file_alignment - 1) & ~(csr_file_alignment - 1);
+   }
+
+   ///
+   /// True if `count` elements of `size` bytes starting at `offs` end
+   /// no later than `limit`, without overflowing.
+   ///
+   inline
+   bool
+   csr_file_region_fits( uint64_t offs,
+			 uint64_t count,
+			 uint64_t size,
+			 uint64_t limit )
+   {
+      return offs <= limit && count <= (limit - offs)/size;
+   }
+
+   ///
+   /// Write a csr to disk in the format read by mapped_csr.
+   ///
+   template< class T >
+   void
+   save_csr( const csr<T>& src,
+	     fs::path const& path )
+   {
+      BOOST_STATIC_ASSERT( boost::is_pod<T>::value );
+
+      csr_file_header hdr;
+      memset(&hdr, 0, sizeof(hdr));
+      memcpy(hdr.magic, csr_file_magic, sizeof(hdr.magic));
+      hdr.version = csr_file_version;
+      hdr.byte_order = csr_file_byte_order;
+      hdr.index_size = sizeof(index);
+      hdr.value_size = sizeof(T);
+      hdr.num_rows = src.num_rows();
+      hdr.array_size = src.array().size();
+      hdr.displs_offset = csr_file_align(sizeof(hdr));
+      hdr.array_offset = csr_file_align(hdr.displs_offset + src.displs().size()*sizeof(index));
+
+      std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      EXCEPT(file.good(), "Failed to open file for writing: ", path);
+      char pad[csr_file_alignment] = { 0 };
+      file.write((const char*)&hdr, sizeof(hdr));
+      file.write(pad, hdr.displs_offset - sizeof(hdr));
+      file.write((const char*)src.displs().data(), src.displs().size()*sizeof(index));
+      file.write(pad, hdr.array_offset - hdr.displs_offset - src.displs().size()*sizeof(index));
+      file.write((const char*)src.array().data(), src.array().size()*sizeof(T));
+      EXCEPT(file.good(), "Failed to write csr to file: ", path);
+   }
+
+   ///
+   /// Read-only csr mapped directly from a file written by save_csr.
+   /// There is no parse or copy step; rows are views into the
+   /// mapping and pages are loaded on first touch. Use `unpack` to
+   /// obtain a modifiable csr.
+   ///
+   template< class T >
+   class mapped_csr
+   {
+   public:
+
+      BOOST_STATIC_ASSERT( boost::is_pod<T>::value );
+
+      mapped_csr()
+	 : _num_rows( 0 ),
+	   _displs( 0 ),
+	   _array( 0 )
+      {
+      }
+
+      mapped_csr( fs::path const& path )
+	 : _num_rows( 0 ),
+	   _displs( 0 ),
+	   _array( 0 )
+      {
+	 this->open(path);
+      }
+
+      void
+      open( fs::path const& path )
+      {
+	 this->close();
+	 this->_file.open(path);
+
+	 const csr_file_header* hdr = (const csr_file_header*)this->_file.data();
+	 EXCEPT(this->_file.size() >= sizeof(csr_file_header) &&
+		memcmp(hdr->magic, csr_file_magic, sizeof(hdr->magic)) == 0,
+		"Not a csr file: ", path);
+	 EXCEPT(hdr->version == csr_file_version, "Unsupported csr file version: ", hdr->version);
+	 EXCEPT(hdr->byte_order == csr_file_byte_order, "Mismatched byte order in csr file: ", path);
+	 EXCEPT(hdr->index_size == sizeof(index) && hdr->value_size == sizeof(T),
+		"Mismatched index or value size in csr file: ", path);
+
+	 // Displacements must sit between the header and the array, and
+	 // the array inside the file.
+	 uint64_t num_displs = hdr->num_rows ? hdr->num_rows + 1 : 0;
+	 EXCEPT(hdr->num_rows < (uint64_t)-1 &&
+		hdr->displs_offset >= sizeof(csr_file_header) &&
+		csr_file_region_fits(hdr->displs_offset, num_displs, sizeof(index), hdr->array_offset),
+		"Corrupt csr file header: ", path);
+	 EXCEPT(csr_file_region_fits(hdr->array_offset, hdr->array_size, sizeof(T), this->_file.size()),
+		"Truncated csr file: ", path);
+
+	 const char* base = (const char*)this->_file.data();
+	 const index* displs = (const index*)(base + hdr->displs_offset);
+	 EXCEPT(!hdr->num_rows || (displs[0] == 0 && (uint64_t)displs[hdr->num_rows] == hdr->array_size),
+		"Inconsistent csr file: ", path);
+	 this->_num_rows = hdr->num_rows;
+	 this->_displs = displs;
+	 this->_array = (const T*)(base + hdr->array_offset);
+      }
+
+      void
+      close()
+      {
+	 this->_file.close();
+	 this->_num_rows = 0;
+	 this->_displs = 0;
+	 this->_array = 0;
+      }
+
+      ///
+      /// Copy into a csr, transferring the buffers with take_displs
+      /// and take_array.
+      ///
+      void
+      unpack( csr<T>& dst ) const
+      {
+	 vector<index> displs;
+	 vector<T> array;
+	 if(this->_num_rows) {
+	    displs.resize(this->_num_rows + 1);
+	    std::copy(this->_displs, this->_displs + this->_num_rows + 1, displs.begin());
+	    array.resize(this->_displs[this->_num_rows]);
+	    std::copy(this->_array, this->_array + array.size(), array.begin());
+	 }
+	 dst.take_displs(displs);
+	 dst.take_array(array);
+      }
+
+      index
+      num_rows() const
+      {
+	 return this->_num_rows;
+      }
+
+      bool
+      empty() const
+      {
+	 return !this->_num_rows;
+      }
+
+      const typename vector<index>::view
+      displs() const
+      {
+	 return typename vector<index>::view(this->_displs, this->_num_rows ? this->_num_rows + 1 : 0);
+      }
+
+      const typename vector<T>::view
+      array() const
+      {
+	 return typename vector<T>::view(this->_array, this->_num_rows ? this->_displs[this->_num_rows] : 0);
+      }
+
+      index
+      row_size( index row ) const
+      {
+	 return this->_displs[row + 1] - this->_displs[row];
+      }
+
+      const typename vector<T>::view
+      operator[]( index row ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 return typename vector<T>::view(this->_array + this->_displs[row], this->row_size(row));
+      }
+
+      const T&
+      operator()( index row,
+		  index col ) const
+      {
+	 ASSERT(row >= 0 && row < this->_num_rows, "Invalid row index.");
+	 ASSERT(col >= 0 && col < this->row_size(row), "Invalid column index.");
+	 return this->_array[this->_displs[row] + col];
+      }
+
+   private:
+      mapped_file _file;
+      index _num_rows;
+      const index* _displs;
+      const T* _array;
+   };
+}
+
+#endif
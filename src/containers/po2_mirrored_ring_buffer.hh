@@ -0,0 +1,232 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_containers_po2_mirrored_ring_buffer_hh
+#define libhpc_containers_po2_mirrored_ring_buffer_hh
+
+#include <vector>
+#include <algorithm>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/static_assert.hpp>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/system/mirrored_memory.hh"
+#include "libhpc/system/view.hh"
+
+class po2_mirrored_ring_buffer_suite;
+
+namespace hpc {
+
+   ///
+   /// Power of two ring buffer whose storage is mapped twice, back to
+   /// back (see `mirrored_memory`). Slot `ii + max_size()` is the same
+   /// memory as slot `ii`, so the contents are always one contiguous
+   /// span from `data()`, as are the vacant slots from
+   /// `vacant_data()`. There are no second chunks to handle.
+   ///
+   /// The storage must be a whole number of pages, so `resize` rounds
+   /// the capacity up to the smallest power of two that is; check
+   /// `max_size` afterwards. Values are stored in raw mapped memory,
+   /// so must be POD.
+   ///
+   template< class T >
+   class po2_mirrored_ring_buffer
+   {
+      friend class ::po2_mirrored_ring_buffer_suite;
+
+      BOOST_STATIC_ASSERT( boost::is_pod<T>::value );
+
+   public:
+
+      typedef T value_type;
+      typedef size_t size_type;
+      typedef hpc::view<std::vector<value_type> > view_type;
+
+   public:
+
+      po2_mirrored_ring_buffer()
+         : _buf( 0 ),
+           _max_size( 0 ),
+           _mask( 0 ),
+           _start( 0 ),
+           _size( 0 )
+      {
+      }
+
+      po2_mirrored_ring_buffer( size_type size )
+         : _buf( 0 ),
+           _max_size( 0 ),
+           _mask( 0 ),
+           _start( 0 ),
+           _size( 0 )
+      {
+         resize( size );
+      }
+
+      void
+      resize( size_type size )
+      {
+         size_type cap = size ? 1 : 0;
+         while( cap && (cap < size || (cap*sizeof(value_type))%mirrored_memory::page_size()) )
+            cap *= 2;
+         _mem.allocate( cap*sizeof(value_type) );
+         _buf = (value_type*)_mem.data();
+         _max_size = cap;
+         _mask = cap ? cap - 1 : 0;
+         reset();
+      }
+
+      void
+      reset()
+      {
+         _start = 0;
+         _size = 0;
+      }
+
+      size_type
+      size() const
+      {
+         return _size;
+      }
+
+      size_type
+      max_size() const
+      {
+         return _max_size;
+      }
+
+      size_type
+      vacant() const
+      {
+         return _max_size - _size;
+      }
+
+      bool
+      empty() const
+      {
+         return _size == 0;
+      }
+
+      size_t
+      norm( size_t idx ) const
+      {
+         return idx & _mask;
+      }
+
+      ///
+      /// Contiguous contents, `size()` values long.
+      ///
+      value_type*
+      data() const
+      {
+         return _buf + _start;
+      }
+
+      ///
+      /// Contiguous vacant slots, `vacant()` values long. Fill them
+      /// and then publish with `extend`.
+      ///
+      value_type*
+      vacant_data() const
+      {
+         return _buf + _start + _size;
+      }
+
+      view_type
+      chunk() const
+      {
+         return view_type( data(), _size );
+      }
+
+      view_type
+      vacant_chunk() const
+      {
+         return view_type( vacant_data(), vacant() );
+      }
+
+      template< class Iterator >
+      size_type
+      insert( Iterator start,
+              const Iterator& finish )
+      {
+         value_type* out = vacant_data();
+         value_type* last = out + vacant();
+         for( ; out != last && start != finish; ++out, ++start )
+            *out = *start;
+         size_type num = out - vacant_data();
+         _size += num;
+         return num;
+      }
+
+      void
+      insert( const value_type& value )
+      {
+         ASSERT( _size < _max_size, "Insufficient space in ring buffer." );
+         _buf[_start + _size++] = value;
+      }
+
+      void
+      extend( size_type size = 1 )
+      {
+         ASSERT( _size + size <= _max_size, "Insufficient space in ring buffer." );
+         _size += size;
+      }
+
+      size_type
+      consume( size_type size = 1 )
+      {
+         size = std::min( size, _size );
+         _start = norm( _start + size );
+         _size -= size;
+         return size;
+      }
+
+      value_type
+      pop()
+      {
+         ASSERT( _size, "Ring buffer is empty." );
+         value_type value = _buf[_start];
+         consume();
+         return value;
+      }
+
+      const value_type&
+      operator[]( size_type idx ) const
+      {
+         ASSERT( idx < _size, "Index out of range." );
+         return _buf[_start + idx];
+      }
+
+      value_type&
+      operator[]( size_type idx )
+      {
+         ASSERT( idx < _size, "Index out of range." );
+         return _buf[_start + idx];
+      }
+
+   protected:
+
+      mirrored_memory _mem;
+      value_type* _buf;
+      size_type _max_size;
+      size_type _mask;
+      size_type _start;
+      size_type _size;
+   };
+
+}
+
+#endif
@@ -0,0 +1,371 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_containers_po2_mpmc_queue_hh
+#define libhpc_containers_po2_mpmc_queue_hh
+
+#include <stdint.h>
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "libhpc/debug/assert.hh"
+#include "mymath.hh"
+
+namespace hpc {
+
+   inline
+   void
+   cpu_relax()
+   {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      __builtin_ia32_pause();
+#endif
+   }
+
+   ///
+   /// Wait policy that only ever spins.
+   ///
+   class spin_wait
+   {
+   public:
+
+      template< class Pred >
+      void
+      wait( Pred pred )
+      {
+         while( !pred() )
+            cpu_relax();
+      }
+
+      void
+      notify()
+      {
+      }
+   };
+
+   ///
+   /// Wait policy that spins for a while and then parks the thread on
+   /// a condition variable. Notifying is a fence and a load unless a
+   /// thread is actually parked.
+   ///
+   class spin_park_wait
+   {
+   public:
+
+      spin_park_wait( unsigned spins = 4000 )
+         : _spins( spins ),
+           _waiters( 0 )
+      {
+      }
+
+      void
+      set_spins( unsigned spins )
+      {
+         _spins = spins;
+      }
+
+      template< class Pred >
+      void
+      wait( Pred pred )
+      {
+         for( unsigned ii = 0; ii < _spins; ++ii )
+         {
+            if( pred() )
+               return;
+            cpu_relax();
+         }
+
+         // Register before checking again, so a notifier either sees
+         // us waiting or we see its update.
+         boost::unique_lock<boost::mutex> lock( _mutex );
+         _waiters.fetch_add( 1, boost::memory_order_seq_cst );
+         boost::atomic_thread_fence( boost::memory_order_seq_cst );
+         while( !pred() )
+            _cond.wait( lock );
+         _waiters.fetch_sub( 1, boost::memory_order_relaxed );
+      }
+
+      void
+      notify()
+      {
+         boost::atomic_thread_fence( boost::memory_order_seq_cst );
+         if( _waiters.load( boost::memory_order_relaxed ) )
+         {
+            boost::lock_guard<boost::mutex> lock( _mutex );
+            _cond.notify_all();
+         }
+      }
+
+   protected:
+
+      unsigned _spins;
+      boost::atomic<unsigned> _waiters;
+      boost::mutex _mutex;
+      boost::condition_variable _cond;
+   };
+
+   ///
+   /// Bounded lock-free multi-producer/multi-consumer queue with power
+   /// of two capacity.
+   ///
+   /// Each slot carries a sequence number saying whose turn it is. A
+   /// producer claims position p by CAS on the enqueue counter once
+   /// slot p's sequence equals p, writes the value and sets the
+   /// sequence to p + 1. A consumer claims p once the sequence equals
+   /// p + 1, reads the value and sets it to p + capacity, handing the
+   /// slot to the next lap. The enqueue and dequeue counters live on
+   /// separate cache lines.
+   ///
+   /// `try_push`/`try_pop` never block. `push`/`pop` wait using
+   /// `WaitPolicy`, by default spinning then parking.
+   ///
+   template< class T,
+             class WaitPolicy = spin_park_wait >
+   class po2_mpmc_queue
+   {
+   public:
+
+      typedef T value_type;
+      typedef size_t size_type;
+      typedef WaitPolicy wait_policy_type;
+
+      static const size_type cache_line_size = 64;
+
+   public:
+
+      po2_mpmc_queue()
+         : _size( 0 ),
+           _mask( 0 ),
+           _enqueue( 0 ),
+           _dequeue( 0 )
+      {
+      }
+
+      po2_mpmc_queue( size_type size )
+         : _size( 0 ),
+           _mask( 0 ),
+           _enqueue( 0 ),
+           _dequeue( 0 )
+      {
+         resize( size );
+      }
+
+      ///
+      /// Not thread safe; the queue must not be in use.
+      ///
+      void
+      resize( size_type size )
+      {
+         ASSERT( size == 0 || (size >= 2 && pow2i( log2i( size ) ) == size),
+                 "Must be power of 2 size, at least 2." );
+         _slots.reset( size ? new slot[size] : 0 );
+         _size = size;
+         _mask = size ? size - 1 : 0;
+         reset();
+      }
+
+      ///
+      /// Not thread safe; the queue must not be in use.
+      ///
+      void
+      reset()
+      {
+         for( size_type ii = 0; ii < _size; ++ii )
+            _slots[ii].seq.store( ii, boost::memory_order_relaxed );
+         _enqueue.store( 0, boost::memory_order_relaxed );
+         _dequeue.store( 0, boost::memory_order_relaxed );
+      }
+
+      size_type
+      max_size() const
+      {
+         return _size;
+      }
+
+      ///
+      /// Approximate number of values in the queue; includes values
+      /// still being written or read.
+      ///
+      size_type
+      size() const
+      {
+         size_type deq = _dequeue.load( boost::memory_order_acquire );
+         return std::min( _enqueue.load( boost::memory_order_acquire ) - deq, _size );
+      }
+
+      bool
+      empty() const
+      {
+         return size() == 0;
+      }
+
+      size_t
+      norm( size_t idx ) const
+      {
+         return idx & _mask;
+      }
+
+      wait_policy_type&
+      wait_policy()
+      {
+         return _wait;
+      }
+
+      bool
+      try_push( const value_type& value )
+      {
+         size_type pos = _enqueue.load( boost::memory_order_relaxed );
+         slot* cur;
+         for( ;; )
+         {
+            cur = &_slots[norm( pos )];
+            size_type seq = cur->seq.load( boost::memory_order_acquire );
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if( dif == 0 )
+            {
+               if( _enqueue.compare_exchange_weak( pos, pos + 1, boost::memory_order_relaxed ) )
+                  break;
+            }
+            else if( dif < 0 )
+               return false;
+            else
+               pos = _enqueue.load( boost::memory_order_relaxed );
+         }
+         cur->value = value;
+         cur->seq.store( pos + 1, boost::memory_order_release );
+         _wait.notify();
+         return true;
+      }
+
+      bool
+      try_pop( value_type& value )
+      {
+         size_type pos = _dequeue.load( boost::memory_order_relaxed );
+         slot* cur;
+         for( ;; )
+         {
+            cur = &_slots[norm( pos )];
+            size_type seq = cur->seq.load( boost::memory_order_acquire );
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if( dif == 0 )
+            {
+               if( _dequeue.compare_exchange_weak( pos, pos + 1, boost::memory_order_relaxed ) )
+                  break;
+            }
+            else if( dif < 0 )
+               return false;
+            else
+               pos = _dequeue.load( boost::memory_order_relaxed );
+         }
+         value = cur->value;
+         cur->seq.store( pos + _mask + 1, boost::memory_order_release );
+         _wait.notify();
+         return true;
+      }
+
+      ///
+      /// Push, waiting for space if the queue is full.
+      ///
+      void
+      push( const value_type& value )
+      {
+         while( !try_push( value ) )
+            _wait.wait( not_full( *this ) );
+      }
+
+      ///
+      /// Pop, waiting for a value if the queue is empty.
+      ///
+      void
+      pop( value_type& value )
+      {
+         while( !try_pop( value ) )
+            _wait.wait( not_empty( *this ) );
+      }
+
+      value_type
+      pop()
+      {
+         value_type value;
+         pop( value );
+         return value;
+      }
+
+   protected:
+
+      struct slot
+      {
+         boost::atomic<size_type> seq;
+         value_type value;
+      };
+
+      struct not_full
+      {
+         not_full( const po2_mpmc_queue& queue )
+            : queue( queue )
+         {
+         }
+
+         bool
+         operator()() const
+         {
+            size_type deq = queue._dequeue.load( boost::memory_order_acquire );
+            return queue._enqueue.load( boost::memory_order_acquire ) - deq < queue._size;
+         }
+
+         const po2_mpmc_queue& queue;
+      };
+
+      struct not_empty
+      {
+         not_empty( const po2_mpmc_queue& queue )
+            : queue( queue )
+         {
+         }
+
+         bool
+         operator()() const
+         {
+            size_type deq = queue._dequeue.load( boost::memory_order_acquire );
+            return queue._enqueue.load( boost::memory_order_acquire ) != deq;
+         }
+
+         const po2_mpmc_queue& queue;
+      };
+
+   protected:
+
+      // Read-only once running.
+      boost::scoped_array<slot> _slots;
+      size_type _size;
+      size_type _mask;
+      wait_policy_type _wait;
+      char _pad0[cache_line_size];
+
+      boost::atomic<size_type> _enqueue;
+      char _pad1[cache_line_size];
+
+      boost::atomic<size_type> _dequeue;
+      char _pad2[cache_line_size];
+   };
+
+}
+
+#endif
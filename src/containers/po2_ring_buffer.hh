@@ -18,8 +18,15 @@
 #ifndef libhpc_containers_po2_ring_buffer_hh
 #define libhpc_containers_po2_ring_buffer_hh
 
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_pod.hpp>
+#include <boost/static_assert.hpp>
 #include "libhpc/debug/assert.hh"
+#include "libhpc/debug/except.hh"
 #include "libhpc/memory/memory.hh"
 #include "vector.hh"
 #include "functors.hh"
@@ -75,6 +82,8 @@ namespace hpc {
       {
          _start = 0;
          _size = 0;
+         _fill_part = 0;
+         _drain_part = 0;
       }
 
       iterator
@@ -166,6 +175,71 @@ namespace hpc {
          return typename vector<value_type>::view( _buf, size );
       }
 
+      ///
+      /// Read from a file descriptor straight into the vacant space,
+      /// with a single readv covering both vacant chunks. Returns the
+      /// number of bytes read, or zero at end of file or if the
+      /// buffer is full.
+      ///
+      /// If `fd` has O_NONBLOCK set and no data is ready, returns -1
+      /// instead of blocking. Other errors throw.
+      ///
+      /// Reads needn't end on an element boundary; a trailing partial
+      /// element is held back until the rest of it arrives.
+      ///
+      ssize_t
+      fill_from( int fd )
+      {
+         BOOST_STATIC_ASSERT( boost::is_pod<value_type>::value );
+         size_t cap = _buf.size()*sizeof(value_type);
+         size_t used = _size*sizeof(value_type) + _fill_part;
+         size_t pos = (_start*sizeof(value_type) + used)%(cap ? cap : 1);
+         struct iovec iov[2];
+         int cnt = _setup_iov( iov, pos, cap - used, cap );
+         if( !cnt )
+            return 0;
+         ssize_t res = _io( ::readv, fd, iov, cnt );
+         if( res > 0 )
+         {
+            size_t total = _fill_part + res;
+            _size += total/sizeof(value_type);
+            _fill_part = total%sizeof(value_type);
+         }
+         return res;
+      }
+
+      ///
+      /// Write the buffer contents to a file descriptor with a single
+      /// writev covering both filled chunks, consuming whatever was
+      /// written. Returns the number of bytes written.
+      ///
+      /// If `fd` has O_NONBLOCK set and cannot accept data, returns -1
+      /// instead of blocking. Other errors throw.
+      ///
+      /// A partially written element stays at the front of the buffer
+      /// until the rest of it is written, so don't mix this with
+      /// `consume` or `pop` while that is the case.
+      ///
+      ssize_t
+      drain_to( int fd )
+      {
+         BOOST_STATIC_ASSERT( boost::is_pod<value_type>::value );
+         size_t cap = _buf.size()*sizeof(value_type);
+         size_t pos = _start*sizeof(value_type) + _drain_part;
+         struct iovec iov[2];
+         int cnt = _setup_iov( iov, pos, _size*sizeof(value_type) - _drain_part, cap );
+         if( !cnt )
+            return 0;
+         ssize_t res = _io( ::writev, fd, iov, cnt );
+         if( res > 0 )
+         {
+            size_t total = _drain_part + res;
+            consume( total/sizeof(value_type) );
+            _drain_part = total%sizeof(value_type);
+         }
+         return res;
+      }
+
       size_t
       norm( size_t idx ) const
       {
@@ -224,6 +298,49 @@ namespace hpc {
 
    protected:
 
+      ///
+      /// Describe `size` bytes of storage from byte `pos`, wrapping at
+      /// `cap`. Returns the number of vectors used.
+      ///
+      int
+      _setup_iov( struct iovec* iov,
+                  size_t pos,
+                  size_t size,
+                  size_t cap )
+      {
+         if( !size )
+            return 0;
+         char* base = (char*)_buf.data();
+         size_t first = std::min( size, cap - pos );
+         iov[0].iov_base = base + pos;
+         iov[0].iov_len = first;
+         iov[1].iov_base = base;
+         iov[1].iov_len = size - first;
+         return (size > first) ? 2 : 1;
+      }
+
+      template< class Op >
+      static ssize_t
+      _io( Op op,
+           int fd,
+           struct iovec* iov,
+           int cnt )
+      {
+         ssize_t res;
+         do
+         {
+            res = op( fd, iov, cnt );
+         }
+         while( res < 0 && errno == EINTR );
+         if( res < 0 )
+         {
+            EXCEPT( errno == EAGAIN || errno == EWOULDBLOCK,
+                    "Ring buffer I/O failed: ", strerror( errno ) );
+            return -1;
+         }
+         return res;
+      }
+
       void
       _setup_mask( size_t size )
       {
@@ -242,6 +359,8 @@ namespace hpc {
       size_type _start;
       size_type _size;
       size_type _mask;
+      size_type _fill_part;
+      size_type _drain_part;
    };
 
    ///
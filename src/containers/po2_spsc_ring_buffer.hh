@@ -0,0 +1,337 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_containers_po2_spsc_ring_buffer_hh
+#define libhpc_containers_po2_spsc_ring_buffer_hh
+
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include "libhpc/debug/assert.hh"
+#include "vector.hh"
+#include "mymath.hh"
+
+class po2_spsc_ring_buffer_suite;
+
+namespace hpc {
+
+   ///
+   /// Lock-free power of two ring buffer for exactly one producer
+   /// thread and one consumer thread.
+   ///
+   /// The head (consumer) and tail (producer) positions are atomic
+   /// counters that only ever increase, and are masked when indexing.
+   /// Each sits on its own cache line together with the owning
+   /// thread's cached copy of the other position, so each side only
+   /// touches the other's line when its cached view runs out. Data is
+   /// published with a release store of the tail and retired with a
+   /// release store of the head.
+   ///
+   /// Producer side: insert, vacant, first/second_vacant_chunk and
+   /// extend. Consumer side: pop, consume, first/second_chunk. size
+   /// and empty may be called from either side, but are only a
+   /// snapshot.
+   ///
+   template< class T >
+   class po2_spsc_ring_buffer
+   {
+      friend class ::po2_spsc_ring_buffer_suite;
+
+   public:
+
+      typedef T value_type;
+      typedef size_t size_type;
+
+      static const size_type cache_line_size = 64;
+
+   public:
+
+      po2_spsc_ring_buffer()
+	 : _mask( 0 ),
+	   _head( 0 ),
+	   _tail_cache( 0 ),
+	   _tail( 0 ),
+	   _head_cache( 0 )
+      {
+      }
+
+      po2_spsc_ring_buffer( size_type size )
+	 : _mask( 0 ),
+	   _head( 0 ),
+	   _tail_cache( 0 ),
+	   _tail( 0 ),
+	   _head_cache( 0 )
+      {
+	 resize( size );
+      }
+
+      ///
+      /// Not thread safe; neither side may be active.
+      ///
+      void
+      resize( size_type size )
+      {
+	 ASSERT( size == 0 || pow2i( log2i( size ) ) == size, "Must be power of 2 size." );
+	 _buf.reallocate( size );
+	 _mask = size ? size - 1 : 0;
+	 reset();
+      }
+
+      ///
+      /// Not thread safe; neither side may be active.
+      ///
+      void
+      reset()
+      {
+	 _head.store( 0, boost::memory_order_relaxed );
+	 _tail.store( 0, boost::memory_order_relaxed );
+	 _head_cache = 0;
+	 _tail_cache = 0;
+      }
+
+      size_type
+      max_size() const
+      {
+	 return _buf.size();
+      }
+
+      size_type
+      size() const
+      {
+	 size_type head = _head.load( boost::memory_order_acquire );
+	 return _tail.load( boost::memory_order_acquire ) - head;
+      }
+
+      bool
+      empty() const
+      {
+	 return size() == 0;
+      }
+
+      size_t
+      norm( size_t idx ) const
+      {
+	 return idx & _mask;
+      }
+
+      ///
+      /// Producer. Number of slots that can currently be filled.
+      ///
+      size_type
+      vacant()
+      {
+	 return _refresh_vacant( _buf.size() );
+      }
+
+      ///
+      /// Producer. Insert as many values as will fit, returning how
+      /// many were inserted. Values are copied in at most two
+      /// contiguous spans and published together.
+      ///
+      template< class Iterator >
+      size_type
+      insert( Iterator start,
+	      const Iterator& finish )
+      {
+	 size_type num = std::distance( start, finish );
+	 num = std::min( num, _refresh_vacant( num ) );
+	 size_type tail = _tail.load( boost::memory_order_relaxed );
+	 size_type pos = norm( tail );
+	 size_type first = std::min( num, _buf.size() - pos );
+	 Iterator mid = start;
+	 std::advance( mid, first );
+	 std::copy( start, mid, _buf.begin() + pos );
+	 if( num > first )
+	 {
+	    Iterator last = mid;
+	    std::advance( last, num - first );
+	    std::copy( mid, last, _buf.begin() );
+	 }
+	 _tail.store( tail + num, boost::memory_order_release );
+	 return num;
+      }
+
+      ///
+      /// Producer. Insert a single value, returning false if the
+      /// buffer is full.
+      ///
+      bool
+      insert( const value_type& value )
+      {
+	 if( !_refresh_vacant( 1 ) )
+	    return false;
+	 size_type tail = _tail.load( boost::memory_order_relaxed );
+	 _buf[norm( tail )] = value;
+	 _tail.store( tail + 1, boost::memory_order_release );
+	 return true;
+      }
+
+      ///
+      /// Producer. The vacant slots from the tail to the end of the
+      /// storage or the head, whichever comes first. Fill them
+      /// directly and then publish with `extend`.
+      ///
+      typename vector<value_type>::view
+      first_vacant_chunk()
+      {
+	 size_type vac = vacant();
+	 size_type pos = norm( _tail.load( boost::memory_order_relaxed ) );
+	 return typename vector<value_type>::view( _buf, std::min( vac, _buf.size() - pos ), pos );
+      }
+
+      ///
+      /// Producer. Vacant slots that wrap to the start of storage.
+      ///
+      typename vector<value_type>::view
+      second_vacant_chunk()
+      {
+	 size_type vac = vacant();
+	 size_type pos = norm( _tail.load( boost::memory_order_relaxed ) );
+	 size_type first = std::min( vac, _buf.size() - pos );
+	 return typename vector<value_type>::view( _buf, vac - first );
+      }
+
+      ///
+      /// Producer. Publish `size` slots filled through the vacant
+      /// chunks.
+      ///
+      void
+      extend( size_type size = 1 )
+      {
+	 ASSERT( size <= vacant(), "Insufficient space in ring buffer." );
+	 _tail.store( _tail.load( boost::memory_order_relaxed ) + size, boost::memory_order_release );
+      }
+
+      ///
+      /// Consumer. Copy up to `size` values out, returning how many
+      /// were taken.
+      ///
+      template< class Iterator >
+      size_type
+      pop( Iterator out,
+	   size_type size )
+      {
+	 size_type num = std::min( size, _refresh_filled( size ) );
+	 size_type head = _head.load( boost::memory_order_relaxed );
+	 size_type pos = norm( head );
+	 size_type first = std::min( num, _buf.size() - pos );
+	 out = std::copy( _buf.begin() + pos, _buf.begin() + pos + first, out );
+	 std::copy( _buf.begin(), _buf.begin() + (num - first), out );
+	 _head.store( head + num, boost::memory_order_release );
+	 return num;
+      }
+
+      ///
+      /// Consumer. Take a single value, returning false if the buffer
+      /// is empty.
+      ///
+      bool
+      pop( value_type& value )
+      {
+	 if( !_refresh_filled( 1 ) )
+	    return false;
+	 size_type head = _head.load( boost::memory_order_relaxed );
+	 value = _buf[norm( head )];
+	 _head.store( head + 1, boost::memory_order_release );
+	 return true;
+      }
+
+      ///
+      /// Consumer. The filled values from the head to the end of the
+      /// storage or the tail, whichever comes first. Read them in
+      /// place and then release with `consume`.
+      ///
+      const typename vector<value_type>::view
+      first_chunk()
+      {
+	 size_type num = _refresh_filled( _buf.size() );
+	 size_type pos = norm( _head.load( boost::memory_order_relaxed ) );
+	 return typename vector<value_type>::view( _buf, std::min( num, _buf.size() - pos ), pos );
+      }
+
+      ///
+      /// Consumer. Filled values that wrap to the start of storage.
+      ///
+      const typename vector<value_type>::view
+      second_chunk()
+      {
+	 size_type num = _refresh_filled( _buf.size() );
+	 size_type pos = norm( _head.load( boost::memory_order_relaxed ) );
+	 size_type first = std::min( num, _buf.size() - pos );
+	 return typename vector<value_type>::view( _buf, num - first );
+      }
+
+      ///
+      /// Consumer. Release up to `size` values, returning how many
+      /// were released.
+      ///
+      size_type
+      consume( size_type size = 1 )
+      {
+	 size = std::min( size, _refresh_filled( size ) );
+	 _head.store( _head.load( boost::memory_order_relaxed ) + size, boost::memory_order_release );
+	 return size;
+      }
+
+   protected:
+
+      ///
+      /// Producer. Vacant slots, only reloading the head when the
+      /// cached value doesn't leave room for `want`.
+      ///
+      size_type
+      _refresh_vacant( size_type want )
+      {
+	 size_type tail = _tail.load( boost::memory_order_relaxed );
+	 if( _buf.size() - (tail - _head_cache) < want )
+	    _head_cache = _head.load( boost::memory_order_acquire );
+	 return _buf.size() - (tail - _head_cache);
+      }
+
+      ///
+      /// Consumer. Filled slots, only reloading the tail when the
+      /// cached value doesn't cover `want`.
+      ///
+      size_type
+      _refresh_filled( size_type want )
+      {
+	 size_type head = _head.load( boost::memory_order_relaxed );
+	 if( _tail_cache - head < want )
+	    _tail_cache = _tail.load( boost::memory_order_acquire );
+	 return _tail_cache - head;
+      }
+
+   protected:
+
+      // Read-only once running.
+      vector<value_type> _buf;
+      size_type _mask;
+      char _pad0[cache_line_size];
+
+      // Written by the consumer.
+      boost::atomic<size_type> _head;
+      size_type _tail_cache;
+      char _pad1[cache_line_size];
+
+      // Written by the producer.
+      boost::atomic<size_type> _tail;
+      size_type _head_cache;
+      char _pad2[cache_line_size];
+   };
+
+}
+
+#endif
@@ -0,0 +1,886 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_containers_roaring_set_hh
+#define hpc_containers_roaring_set_hh
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "libhpc/debug/assert.hh"
+#include "range.hh"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ROARING_X86
+#define ROARING_POPCNT __attribute__((target("popcnt")))
+#define ROARING_AVX512 __attribute__((target("avx512f,avx512vpopcntdq")))
+#endif
+
+namespace hpc {
+   namespace impl {
+
+      inline
+      uint64_t
+      popcount_words_generic( const uint64_t* words,
+                              size_t size )
+      {
+         uint64_t cnt = 0;
+         for( size_t ii = 0; ii < size; ++ii )
+            cnt += __builtin_popcountll( words[ii] );
+         return cnt;
+      }
+
+#ifdef ROARING_X86
+
+      ROARING_POPCNT
+      inline
+      uint64_t
+      popcount_words_popcnt( const uint64_t* words,
+                             size_t size )
+      {
+         uint64_t cnt = 0;
+         for( size_t ii = 0; ii < size; ++ii )
+            cnt += __builtin_popcountll( words[ii] );
+         return cnt;
+      }
+
+      ROARING_AVX512
+      inline
+      uint64_t
+      popcount_words_avx512( const uint64_t* words,
+                             size_t size )
+      {
+         __m512i acc = _mm512_setzero_si512();
+         size_t ii = 0;
+         for( ; ii + 8 <= size; ii += 8 )
+            acc = _mm512_add_epi64( acc, _mm512_popcnt_epi64( _mm512_loadu_si512( words + ii ) ) );
+         uint64_t cnt = _mm512_reduce_add_epi64( acc );
+         for( ; ii < size; ++ii )
+            cnt += __builtin_popcountll( words[ii] );
+         return cnt;
+      }
+
+#endif
+
+   }
+
+   ///
+   /// Number of set bits in an array of words, using vector popcount
+   /// when the processor has it. Detected once on first call.
+   ///
+   inline
+   uint64_t
+   popcount_words( const uint64_t* words,
+                   size_t size )
+   {
+#ifdef ROARING_X86
+      static const int level =
+         __builtin_cpu_supports( "avx512vpopcntdq" ) ? 2 :
+         __builtin_cpu_supports( "popcnt" ) ? 1 : 0;
+      if( level == 2 )
+         return impl::popcount_words_avx512( words, size );
+      else if( level == 1 )
+         return impl::popcount_words_popcnt( words, size );
+#endif
+      return impl::popcount_words_generic( words, size );
+   }
+
+   ///
+   /// Compressed set of 32 bit unsigned integers, in the style of a
+   /// roaring bitmap. Values are split into 64K chunks by their high
+   /// 16 bits, and each chunk stores its low 16 bits in whichever of
+   /// three containers is smallest:
+   ///
+   ///   array   sorted values, for sparse chunks (at most 4096),
+   ///   bitmap  65536 bits, for dense chunks,
+   ///   run     sorted [first, last] runs, for clustered chunks.
+   ///
+   /// Set operations work chunk by chunk, using merges between
+   /// arrays and runs and word-wise operations once a bitmap is
+   /// involved, then pick the best container for the result.
+   ///
+   /// Ranges convert to and from `range<T>`, so a `range_set` or
+   /// `flat_range_set` can be loaded with `build` and recovered with
+   /// `ranges`. As ranges are half open, 0xffffffff itself cannot be
+   /// covered by one.
+   ///
+   class roaring_set
+   {
+   public:
+
+      typedef uint32_t value_type;
+      typedef size_t size_type;
+
+      static const size_type max_array_size = 4096;
+      static const size_type bitmap_words = 1024;
+
+   protected:
+
+      struct container
+      {
+         enum kind_type
+         {
+            array_kind,
+            bitmap_kind,
+            run_kind
+         };
+
+         typedef std::pair<uint16_t,uint16_t> run_type;
+
+         container()
+            : kind( array_kind ),
+              card( 0 )
+         {
+         }
+
+         kind_type kind;
+         uint32_t card;
+         std::vector<uint16_t> array;
+         std::vector<uint64_t> bits;
+         std::vector<run_type> runs;
+      };
+
+      typedef container::run_type run_type;
+
+   public:
+
+      void
+      clear()
+      {
+         _keys.clear();
+         _conts.clear();
+      }
+
+      bool
+      empty() const
+      {
+         return _keys.empty();
+      }
+
+      ///
+      /// Number of values held.
+      ///
+      uint64_t
+      cardinality() const
+      {
+         uint64_t card = 0;
+         for( size_type ii = 0; ii < _conts.size(); ++ii )
+            card += _conts[ii].card;
+         return card;
+      }
+
+      ///
+      /// Approximate bytes used by the containers.
+      ///
+      size_type
+      memory_usage() const
+      {
+         size_type size = _keys.size()*(sizeof(uint16_t) + sizeof(container));
+         for( size_type ii = 0; ii < _conts.size(); ++ii )
+         {
+            const container& cont = _conts[ii];
+            size += cont.array.size()*sizeof(uint16_t) + cont.bits.size()*sizeof(uint64_t) + cont.runs.size()*sizeof(run_type);
+         }
+         return size;
+      }
+
+      bool
+      has( value_type value ) const
+      {
+         std::vector<uint16_t>::const_iterator it = std::lower_bound( _keys.begin(), _keys.end(), _high( value ) );
+         if( it == _keys.end() || *it != _high( value ) )
+            return false;
+         return _has( _conts[it - _keys.begin()], _low( value ) );
+      }
+
+      void
+      insert( value_type value )
+      {
+         roaring_set tmp;
+         tmp._append_range( value, (uint64_t)value + 1 );
+         tmp._optimize_all();
+         *this |= tmp;
+      }
+
+      void
+      insert( const range<value_type>& rng )
+      {
+         roaring_set tmp;
+         tmp._append_range( rng.start(), rng.finish() );
+         tmp._optimize_all();
+         *this |= tmp;
+      }
+
+      ///
+      /// Replace the contents with the union of a sequence of ranges,
+      /// which may be unsorted and overlapping.
+      ///
+      template< class Iterator >
+      void
+      build( Iterator start,
+             const Iterator& finish )
+      {
+         std::vector<range<value_type> > rngs;
+         for( ; start != finish; ++start )
+         {
+            if( start->length() )
+               rngs.push_back( range<value_type>( start->start(), start->finish() ) );
+         }
+         std::sort( rngs.begin(), rngs.end(), range_start_less() );
+         clear();
+         for( size_type ii = 0; ii < rngs.size(); )
+         {
+            value_type first = rngs[ii].start(), last = rngs[ii].finish();
+            for( ++ii; ii < rngs.size() && rngs[ii].start() <= last; ++ii )
+               last = std::max( last, rngs[ii].finish() );
+            _append_range( first, last );
+         }
+         _optimize_all();
+      }
+
+      ///
+      /// Write the contents as maximal half open ranges, in order.
+      ///
+      template< class OutputIterator >
+      OutputIterator
+      ranges( OutputIterator out ) const
+      {
+         bool open = false;
+         uint64_t first = 0, last = 0;
+         std::vector<run_type> runs;
+         for( size_type ii = 0; ii < _keys.size(); ++ii )
+         {
+            _runs_of( _conts[ii], runs );
+            uint64_t base = (uint64_t)_keys[ii] << 16;
+            for( std::vector<run_type>::const_iterator it = runs.begin(); it != runs.end(); ++it )
+            {
+               uint64_t cur_first = base + it->first, cur_last = base + it->second + 1;
+               if( open && cur_first == last )
+                  last = cur_last;
+               else
+               {
+                  if( open )
+                     *out++ = _make_range( first, last );
+                  first = cur_first;
+                  last = cur_last;
+                  open = true;
+               }
+            }
+         }
+         if( open )
+            *out++ = _make_range( first, last );
+         return out;
+      }
+
+      roaring_set&
+      operator|=( const roaring_set& op )
+      {
+         _combine( op, union_op() );
+         return *this;
+      }
+
+      roaring_set&
+      operator&=( const roaring_set& op )
+      {
+         _combine( op, intersect_op() );
+         return *this;
+      }
+
+      roaring_set&
+      operator-=( const roaring_set& op )
+      {
+         _combine( op, difference_op() );
+         return *this;
+      }
+
+      bool
+      operator==( const roaring_set& op ) const
+      {
+         if( _keys != op._keys )
+            return false;
+         std::vector<run_type> runs_a, runs_b;
+         for( size_type ii = 0; ii < _conts.size(); ++ii )
+         {
+            if( _conts[ii].card != op._conts[ii].card )
+               return false;
+            _runs_of( _conts[ii], runs_a );
+            _runs_of( op._conts[ii], runs_b );
+            if( runs_a != runs_b )
+               return false;
+         }
+         return true;
+      }
+
+      bool
+      operator!=( const roaring_set& op ) const
+      {
+         return !(*this == op);
+      }
+
+   protected:
+
+      struct range_start_less
+      {
+         bool
+         operator()( const range<value_type>& op_a,
+                     const range<value_type>& op_b ) const
+         {
+            return op_a.start() < op_b.start();
+         }
+      };
+
+      static
+      uint16_t
+      _high( value_type value )
+      {
+         return value >> 16;
+      }
+
+      static
+      uint16_t
+      _low( value_type value )
+      {
+         return value & 0xffff;
+      }
+
+      static
+      range<value_type>
+      _make_range( uint64_t first,
+                   uint64_t last )
+      {
+         ASSERT( last <= 0xffffffff, "Range finish is not representable." );
+         return range<value_type>( first, last );
+      }
+
+      // Append [first, last) to chunks beyond any existing ones.
+      void
+      _append_range( uint64_t first,
+                     uint64_t last )
+      {
+         while( first < last )
+         {
+            uint16_t key = first >> 16;
+            uint64_t chunk_last = std::min( last, ((uint64_t)key + 1) << 16 );
+            if( _keys.empty() || _keys.back() != key )
+            {
+               ASSERT( _keys.empty() || _keys.back() < key, "Ranges must be appended in order." );
+               _keys.push_back( key );
+               _conts.push_back( container() );
+               _conts.back().kind = container::run_kind;
+            }
+            container& cont = _conts.back();
+            cont.runs.push_back( run_type( first & 0xffff, (chunk_last - 1) & 0xffff ) );
+            cont.card += chunk_last - first;
+            first = chunk_last;
+         }
+      }
+
+      void
+      _optimize_all()
+      {
+         for( size_type ii = 0; ii < _conts.size(); ++ii )
+            _optimize( _conts[ii] );
+      }
+
+      static
+      bool
+      _has( const container& cont,
+            uint16_t low )
+      {
+         switch( cont.kind )
+         {
+            case container::array_kind:
+               return std::binary_search( cont.array.begin(), cont.array.end(), low );
+            case container::bitmap_kind:
+               return (cont.bits[low >> 6] >> (low & 63)) & 1;
+            default:
+            {
+               std::vector<run_type>::const_iterator it =
+                  std::upper_bound( cont.runs.begin(), cont.runs.end(), run_type( low, 0xffff ) );
+               return it != cont.runs.begin() && low <= (--it)->second;
+            }
+         }
+      }
+
+      static
+      void
+      _bits_of( const container& cont,
+                std::vector<uint64_t>& bits )
+      {
+         if( cont.kind == container::bitmap_kind )
+         {
+            bits = cont.bits;
+            return;
+         }
+         bits.assign( bitmap_words, 0 );
+         if( cont.kind == container::array_kind )
+         {
+            for( std::vector<uint16_t>::const_iterator it = cont.array.begin(); it != cont.array.end(); ++it )
+               bits[*it >> 6] |= (uint64_t)1 << (*it & 63);
+         }
+         else
+         {
+            for( std::vector<run_type>::const_iterator it = cont.runs.begin(); it != cont.runs.end(); ++it )
+               _set_bits( bits, it->first, it->second );
+         }
+      }
+
+      // Set bits [first, last], inclusive.
+      static
+      void
+      _set_bits( std::vector<uint64_t>& bits,
+                 unsigned first,
+                 unsigned last )
+      {
+         unsigned fw = first >> 6, lw = last >> 6;
+         uint64_t fmask = ~(uint64_t)0 << (first & 63);
+         uint64_t lmask = ~(uint64_t)0 >> (63 - (last & 63));
+         if( fw == lw )
+            bits[fw] |= fmask & lmask;
+         else
+         {
+            bits[fw] |= fmask;
+            for( unsigned ii = fw + 1; ii < lw; ++ii )
+               bits[ii] = ~(uint64_t)0;
+            bits[lw] |= lmask;
+         }
+      }
+
+      static
+      void
+      _runs_of( const container& cont,
+                std::vector<run_type>& runs )
+      {
+         runs.clear();
+         if( cont.kind == container::run_kind )
+            runs = cont.runs;
+         else if( cont.kind == container::array_kind )
+         {
+            for( size_type ii = 0; ii < cont.array.size(); )
+            {
+               uint16_t first = cont.array[ii], last = first;
+               for( ++ii; ii < cont.array.size() && cont.array[ii] == last + 1; ++ii )
+                  ++last;
+               runs.push_back( run_type( first, last ) );
+            }
+         }
+         else
+         {
+            unsigned pos = 0;
+            while( pos < 65536 )
+            {
+               unsigned first = _next_bit( cont.bits, pos, false );
+               if( first >= 65536 )
+                  break;
+               pos = _next_bit( cont.bits, first, true );
+               runs.push_back( run_type( first, pos - 1 ) );
+            }
+         }
+      }
+
+      // Position of the next set bit (or clear bit, if `clear`) at or
+      // after `pos`, or 65536.
+      static
+      unsigned
+      _next_bit( const std::vector<uint64_t>& bits,
+                 unsigned pos,
+                 bool clear )
+      {
+         unsigned wrd = pos >> 6;
+         uint64_t cur = (clear ? ~bits[wrd] : bits[wrd]) & (~(uint64_t)0 << (pos & 63));
+         while( !cur )
+         {
+            if( ++wrd == bitmap_words )
+               return 65536;
+            cur = clear ? ~bits[wrd] : bits[wrd];
+         }
+         return (wrd << 6) + __builtin_ctzll( cur );
+      }
+
+      static
+      size_type
+      _count_runs( const std::vector<uint64_t>& bits )
+      {
+         // A run starts wherever a set bit follows a clear one.
+         size_type cnt = 0;
+         uint64_t carry = 0;
+         for( size_type ii = 0; ii < bits.size(); ++ii )
+         {
+            cnt += __builtin_popcountll( bits[ii] & ~((bits[ii] << 1) | carry) );
+            carry = bits[ii] >> 63;
+         }
+         return cnt;
+      }
+
+      // Choose the smallest container for the contents.
+      static
+      void
+      _optimize( container& cont )
+      {
+         size_type num_runs;
+         if( cont.kind == container::bitmap_kind )
+         {
+            cont.card = popcount_words( &cont.bits[0], cont.bits.size() );
+            num_runs = _count_runs( cont.bits );
+         }
+         else if( cont.kind == container::array_kind )
+         {
+            cont.card = cont.array.size();
+            num_runs = 0;
+            for( size_type ii = 0; ii < cont.array.size(); ++ii )
+               num_runs += (!ii || cont.array[ii] != cont.array[ii - 1] + 1);
+         }
+         else
+         {
+            cont.card = 0;
+            for( std::vector<run_type>::const_iterator it = cont.runs.begin(); it != cont.runs.end(); ++it )
+               cont.card += it->second - it->first + 1;
+            num_runs = cont.runs.size();
+         }
+
+         size_type run_bytes = num_runs*sizeof(run_type);
+         size_type array_bytes = (cont.card <= max_array_size) ? cont.card*sizeof(uint16_t) : ~size_type( 0 );
+         size_type bitmap_bytes = bitmap_words*sizeof(uint64_t);
+         container::kind_type kind;
+         if( run_bytes < std::min( array_bytes, bitmap_bytes ) )
+            kind = container::run_kind;
+         else if( array_bytes <= bitmap_bytes )
+            kind = container::array_kind;
+         else
+            kind = container::bitmap_kind;
+         if( kind == cont.kind )
+            return;
+
+         if( kind == container::run_kind )
+         {
+            std::vector<run_type> runs;
+            _runs_of( cont, runs );
+            cont.runs.swap( runs );
+         }
+         else if( kind == container::array_kind )
+         {
+            std::vector<run_type> runs;
+            _runs_of( cont, runs );
+            cont.array.clear();
+            cont.array.reserve( cont.card );
+            for( std::vector<run_type>::const_iterator it = runs.begin(); it != runs.end(); ++it )
+            {
+               for( unsigned ii = it->first; ii <= it->second; ++ii )
+                  cont.array.push_back( ii );
+            }
+         }
+         else
+         {
+            std::vector<uint64_t> bits;
+            _bits_of( cont, bits );
+            cont.bits.swap( bits );
+         }
+         if( kind != container::array_kind )
+            std::vector<uint16_t>().swap( cont.array );
+         if( kind != container::bitmap_kind )
+            std::vector<uint64_t>().swap( cont.bits );
+         if( kind != container::run_kind )
+            std::vector<run_type>().swap( cont.runs );
+         cont.kind = kind;
+      }
+
+      struct union_op
+      {
+         static const bool keep_left = true;
+         static const bool keep_right = true;
+
+         static
+         void
+         words( uint64_t* dst,
+                const uint64_t* src )
+         {
+            for( size_type ii = 0; ii < bitmap_words; ++ii )
+               dst[ii] |= src[ii];
+         }
+
+         static
+         void
+         arrays( const std::vector<uint16_t>& op_a,
+                 const std::vector<uint16_t>& op_b,
+                 std::vector<uint16_t>& res )
+         {
+            std::set_union( op_a.begin(), op_a.end(), op_b.begin(), op_b.end(), std::back_inserter( res ) );
+         }
+
+         static
+         void
+         runs( const std::vector<run_type>& op_a,
+               const std::vector<run_type>& op_b,
+               std::vector<run_type>& res )
+         {
+            std::vector<run_type> all;
+            all.reserve( op_a.size() + op_b.size() );
+            std::merge( op_a.begin(), op_a.end(), op_b.begin(), op_b.end(), std::back_inserter( all ) );
+            for( std::vector<run_type>::const_iterator it = all.begin(); it != all.end(); ++it )
+            {
+               if( !res.empty() && (unsigned)it->first <= (unsigned)res.back().second + 1 )
+                  res.back().second = std::max( res.back().second, it->second );
+               else
+                  res.push_back( *it );
+            }
+         }
+      };
+
+      struct intersect_op
+      {
+         static const bool keep_left = false;
+         static const bool keep_right = false;
+
+         static
+         void
+         words( uint64_t* dst,
+                const uint64_t* src )
+         {
+            for( size_type ii = 0; ii < bitmap_words; ++ii )
+               dst[ii] &= src[ii];
+         }
+
+         static
+         void
+         arrays( const std::vector<uint16_t>& op_a,
+                 const std::vector<uint16_t>& op_b,
+                 std::vector<uint16_t>& res )
+         {
+            std::set_intersection( op_a.begin(), op_a.end(), op_b.begin(), op_b.end(), std::back_inserter( res ) );
+         }
+
+         static
+         void
+         runs( const std::vector<run_type>& op_a,
+               const std::vector<run_type>& op_b,
+               std::vector<run_type>& res )
+         {
+            std::vector<run_type>::const_iterator it_a = op_a.begin(), it_b = op_b.begin();
+            while( it_a != op_a.end() && it_b != op_b.end() )
+            {
+               uint16_t first = std::max( it_a->first, it_b->first );
+               uint16_t last = std::min( it_a->second, it_b->second );
+               if( first <= last )
+                  res.push_back( run_type( first, last ) );
+               if( it_a->second < it_b->second )
+                  ++it_a;
+               else
+                  ++it_b;
+            }
+         }
+      };
+
+      struct difference_op
+      {
+         static const bool keep_left = true;
+         static const bool keep_right = false;
+
+         static
+         void
+         words( uint64_t* dst,
+                const uint64_t* src )
+         {
+            for( size_type ii = 0; ii < bitmap_words; ++ii )
+               dst[ii] &= ~src[ii];
+         }
+
+         static
+         void
+         arrays( const std::vector<uint16_t>& op_a,
+                 const std::vector<uint16_t>& op_b,
+                 std::vector<uint16_t>& res )
+         {
+            std::set_difference( op_a.begin(), op_a.end(), op_b.begin(), op_b.end(), std::back_inserter( res ) );
+         }
+
+         static
+         void
+         runs( const std::vector<run_type>& op_a,
+               const std::vector<run_type>& op_b,
+               std::vector<run_type>& res )
+         {
+            std::vector<run_type>::const_iterator it_b = op_b.begin();
+            for( std::vector<run_type>::const_iterator it_a = op_a.begin(); it_a != op_a.end(); ++it_a )
+            {
+               unsigned first = it_a->first;
+               while( it_b != op_b.end() && it_b->second < first )
+                  ++it_b;
+               std::vector<run_type>::const_iterator cur = it_b;
+               for( ; cur != op_b.end() && cur->first <= it_a->second; ++cur )
+               {
+                  if( cur->first > first )
+                     res.push_back( run_type( first, cur->first - 1 ) );
+                  first = (unsigned)cur->second + 1;
+                  if( first > it_a->second )
+                     break;
+               }
+               if( first <= it_a->second )
+                  res.push_back( run_type( first, it_a->second ) );
+            }
+         }
+      };
+
+      template< class Op >
+      static
+      void
+      _combine_containers( container& dst,
+                           const container& src )
+      {
+         container res;
+         if( dst.kind == container::array_kind && src.kind == container::array_kind )
+         {
+            res.kind = container::array_kind;
+            Op::arrays( dst.array, src.array, res.array );
+            if( res.array.size() > max_array_size )
+            {
+               // Only a union can grow an array past the limit.
+               std::vector<uint64_t> bits;
+               _bits_of( res, bits );
+               res.bits.swap( bits );
+               res.kind = container::bitmap_kind;
+               std::vector<uint16_t>().swap( res.array );
+            }
+         }
+         else if( dst.kind == container::run_kind && src.kind == container::run_kind )
+         {
+            res.kind = container::run_kind;
+            Op::runs( dst.runs, src.runs, res.runs );
+         }
+         else if( dst.kind == container::array_kind && !Op::keep_right )
+         {
+            // Intersection and difference of an array only need
+            // membership tests against the other side.
+            res.kind = container::array_kind;
+            bool want = !Op::keep_left;
+            for( std::vector<uint16_t>::const_iterator it = dst.array.begin(); it != dst.array.end(); ++it )
+            {
+               if( _has( src, *it ) == want )
+                  res.array.push_back( *it );
+            }
+         }
+         else if( src.kind == container::array_kind && !Op::keep_left && !Op::keep_right )
+         {
+            // Intersection is symmetric, so filter the array on the
+            // right instead.
+            res.kind = container::array_kind;
+            for( std::vector<uint16_t>::const_iterator it = src.array.begin(); it != src.array.end(); ++it )
+            {
+               if( _has( dst, *it ) )
+                  res.array.push_back( *it );
+            }
+         }
+         else
+         {
+            res.kind = container::bitmap_kind;
+            _bits_of( dst, res.bits );
+            std::vector<uint64_t> tmp;
+            const uint64_t* src_bits;
+            if( src.kind == container::bitmap_kind )
+               src_bits = &src.bits[0];
+            else
+            {
+               _bits_of( src, tmp );
+               src_bits = &tmp[0];
+            }
+            Op::words( &res.bits[0], src_bits );
+         }
+         _optimize( res );
+         std::swap( dst, res );
+      }
+
+      template< class Op >
+      void
+      _combine( const roaring_set& op,
+                Op )
+      {
+         std::vector<uint16_t> keys;
+         std::vector<container> conts;
+         keys.reserve( _keys.size() + op._keys.size() );
+         conts.reserve( _keys.size() + op._keys.size() );
+         size_type ii = 0, jj = 0;
+         while( ii < _keys.size() || jj < op._keys.size() )
+         {
+            if( jj == op._keys.size() || (ii < _keys.size() && _keys[ii] < op._keys[jj]) )
+            {
+               if( Op::keep_left )
+               {
+                  keys.push_back( _keys[ii] );
+                  conts.push_back( container() );
+                  std::swap( conts.back(), _conts[ii] );
+               }
+               ++ii;
+            }
+            else if( ii == _keys.size() || op._keys[jj] < _keys[ii] )
+            {
+               if( Op::keep_right )
+               {
+                  keys.push_back( op._keys[jj] );
+                  conts.push_back( op._conts[jj] );
+               }
+               ++jj;
+            }
+            else
+            {
+               _combine_containers<Op>( _conts[ii], op._conts[jj] );
+               if( _conts[ii].card )
+               {
+                  keys.push_back( _keys[ii] );
+                  conts.push_back( container() );
+                  std::swap( conts.back(), _conts[ii] );
+               }
+               ++ii;
+               ++jj;
+            }
+         }
+         _keys.swap( keys );
+         _conts.swap( conts );
+      }
+
+   protected:
+
+      std::vector<uint16_t> _keys;
+      std::vector<container> _conts;
+   };
+
+   inline
+   roaring_set
+   operator|( roaring_set op_a,
+              const roaring_set& op_b )
+   {
+      return op_a |= op_b;
+   }
+
+   inline
+   roaring_set
+   operator&( roaring_set op_a,
+              const roaring_set& op_b )
+   {
+      return op_a &= op_b;
+   }
+
+   inline
+   roaring_set
+   operator-( roaring_set op_a,
+              const roaring_set& op_b )
+   {
+      return op_a -= op_b;
+   }
+
+}
+
+#endif
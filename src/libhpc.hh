@@ -20,6 +20,7 @@
 
 #include "debug.hh"
 #include "system.hh"
+#include "memory.hh"
 #include "logging.hh"
 #include "mpi.hh"
 #include "h5.hh"
@@ -0,0 +1,94 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include "arena.hh"
+
+namespace hpc {
+   namespace memory {
+
+      arena::arena( size_t block_size )
+         : _block_size( block_size ),
+           _blocks( 0 ),
+           _ptr( 0 ),
+           _end( 0 ),
+           _used( 0 ),
+           _capacity( 0 )
+      {
+      }
+
+      arena::~arena()
+      {
+         release();
+      }
+
+      void
+      arena::reset()
+      {
+         if( _blocks && _blocks->next )
+         {
+            size_t size = _capacity;
+            release();
+            _add_block( size );
+         }
+         else if( _blocks )
+         {
+            _ptr = (char*)(((size_t)(_blocks + 1) + default_alignment - 1) & ~(default_alignment - 1));
+            _end = _ptr + _blocks->size;
+         }
+         _used = 0;
+      }
+
+      void
+      arena::release()
+      {
+         while( _blocks )
+         {
+            block* next = _blocks->next;
+            ::operator delete( _blocks );
+            _blocks = next;
+         }
+         _ptr = 0;
+         _end = 0;
+         _used = 0;
+         _capacity = 0;
+      }
+
+      char*
+      arena::_grow( size_t size,
+                    size_t align )
+      {
+         _add_block( std::max( _block_size, size + align ) );
+         return (char*)(((size_t)_ptr + align - 1) & ~(align - 1));
+      }
+
+      void
+      arena::_add_block( size_t size )
+      {
+         // The header is padded so the first allocation is aligned.
+         size = (size + default_alignment - 1) & ~(default_alignment - 1);
+         block* blk = (block*)::operator new( sizeof(block) + default_alignment + size );
+         blk->next = _blocks;
+         blk->size = size;
+         _blocks = blk;
+         _ptr = (char*)(((size_t)(blk + 1) + default_alignment - 1) & ~(default_alignment - 1));
+         _end = _ptr + size;
+         _capacity += size;
+      }
+
+   }
+}
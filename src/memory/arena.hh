@@ -0,0 +1,233 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_arena_hh
+#define libhpc_memory_arena_hh
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <boost/type_traits/alignment_of.hpp>
+
+namespace hpc {
+   namespace memory {
+
+      ///
+      /// Bump-pointer arena for short-lived allocations, such as the
+      /// temporaries of one timestep. Allocation is a pointer bump
+      /// within the current block and individual deallocation is a
+      /// no-op, apart from rolling back the most recent allocation.
+      /// `reset` recycles everything at once; if the last phase needed
+      /// more than one block they are replaced by a single block big
+      /// enough for all of it, so a repeating phase settles into one
+      /// allocation from the heap.
+      ///
+      /// Not thread safe; use one arena per thread.
+      ///
+      class arena
+      {
+      public:
+
+         static const size_t default_alignment = 16;
+
+      public:
+
+         arena( size_t block_size = 1 << 20 );
+
+         ~arena();
+
+         void*
+         allocate( size_t size,
+                   size_t align = default_alignment )
+         {
+            char* ptr = (char*)(((size_t)_ptr + align - 1) & ~(align - 1));
+            if( ptr + size > _end )
+               ptr = _grow( size, align );
+            _ptr = ptr + size;
+            _used += size;
+            return ptr;
+         }
+
+         ///
+         /// Only reclaims space if `ptr` was the last allocation.
+         ///
+         void
+         deallocate( void* ptr,
+                     size_t size )
+         {
+            if( (char*)ptr + size == _ptr )
+               _ptr = (char*)ptr;
+            _used -= size;
+         }
+
+         ///
+         /// Make all memory available again. Anything allocated from
+         /// the arena must no longer be in use.
+         ///
+         void
+         reset();
+
+         ///
+         /// Return all blocks to the heap.
+         ///
+         void
+         release();
+
+         ///
+         /// Bytes currently allocated and not deallocated.
+         ///
+         size_t
+         used() const
+         {
+            return _used;
+         }
+
+         ///
+         /// Total bytes held in blocks.
+         ///
+         size_t
+         capacity() const
+         {
+            return _capacity;
+         }
+
+      protected:
+
+         struct block
+         {
+            block* next;
+            size_t size;
+         };
+
+         char*
+         _grow( size_t size,
+                size_t align );
+
+         void
+         _add_block( size_t size );
+
+      protected:
+
+         size_t _block_size;
+         block* _blocks;
+         char* _ptr;
+         char* _end;
+         size_t _used;
+         size_t _capacity;
+      };
+
+      ///
+      /// Standard allocator drawing from an arena. A default
+      /// constructed allocator has no arena and uses the global heap,
+      /// so containers that lose their allocator (for example after
+      /// swapping with a default constructed temporary) stay correct.
+      /// The arena must outlive any container using it.
+      ///
+      template< class T >
+      class arena_allocator
+      {
+      public:
+
+         typedef T value_type;
+         typedef T* pointer;
+         typedef const T* const_pointer;
+         typedef T& reference;
+         typedef const T& const_reference;
+         typedef size_t size_type;
+         typedef ptrdiff_t difference_type;
+         typedef std::false_type propagate_on_container_copy_assignment;
+         typedef std::true_type propagate_on_container_move_assignment;
+         typedef std::true_type propagate_on_container_swap;
+
+         template< class U >
+         struct rebind
+         {
+            typedef arena_allocator<U> other;
+         };
+
+      public:
+
+         arena_allocator()
+            : _arena( 0 )
+         {
+         }
+
+         arena_allocator( memory::arena& arena )
+            : _arena( &arena )
+         {
+         }
+
+         template< class U >
+         arena_allocator( const arena_allocator<U>& src )
+            : _arena( src.arena() )
+         {
+         }
+
+         memory::arena*
+         arena() const
+         {
+            return _arena;
+         }
+
+         pointer
+         allocate( size_type size )
+         {
+            if( _arena )
+               return (pointer)_arena->allocate( size*sizeof(T), boost::alignment_of<T>::value );
+            else
+               return (pointer)::operator new( size*sizeof(T) );
+         }
+
+         void
+         deallocate( pointer ptr,
+                     size_type size )
+         {
+            if( _arena )
+               _arena->deallocate( ptr, size*sizeof(T) );
+            else
+               ::operator delete( ptr );
+         }
+
+         size_type
+         max_size() const
+         {
+            return size_t( -1 )/sizeof(T);
+         }
+
+         template< class U >
+         bool
+         operator==( const arena_allocator<U>& op ) const
+         {
+            return _arena == op.arena();
+         }
+
+         template< class U >
+         bool
+         operator!=( const arena_allocator<U>& op ) const
+         {
+            return _arena != op.arena();
+         }
+
+      protected:
+
+         memory::arena* _arena;
+      };
+
+   }
+}
+
+#endif
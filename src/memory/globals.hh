@@ -0,0 +1,91 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_globals_hh
+#define libhpc_memory_globals_hh
+
+#include <string>
+#include "group_context.hh"
+#include "state.hh"
+
+namespace hpc {
+   namespace memory {
+
+#ifndef NMEMSTATS
+
+      ///
+      /// Groups that all allocations through operator new are
+      /// charged to.
+      ///
+      extern group_context<state_t> ctx;
+
+      void
+      select( const std::string& path );
+
+      void
+      deselect( const std::string& path );
+
+#else
+
+      inline
+      void
+      select( const std::string& )
+      {
+      }
+
+      inline
+      void
+      deselect( const std::string& )
+      {
+      }
+
+#endif
+
+      ///
+      /// Selects a group for the calling thread for the lifetime of
+      /// the object.
+      ///
+      class scoped_group
+      {
+      public:
+
+         scoped_group( const std::string& path )
+#ifndef NMEMSTATS
+            : _path( path )
+#endif
+         {
+            select( path );
+         }
+
+         ~scoped_group()
+         {
+#ifndef NMEMSTATS
+            deselect( _path );
+#endif
+         }
+
+      protected:
+
+#ifndef NMEMSTATS
+         std::string _path;
+#endif
+      };
+
+   }
+}
+
+#endif
@@ -0,0 +1,373 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_group_context_hh
+#define libhpc_memory_group_context_hh
+
+#include <string>
+#include <map>
+#include <algorithm>
+#include <boost/scoped_array.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include "libhpc/debug/except.hh"
+#include "libhpc/debug/assert.hh"
+#include "libhpc/debug/omp_help.hh"
+#include "thread_slot.hh"
+#include "new.hh"
+
+namespace hpc {
+   namespace memory {
+
+      ///
+      /// Called before group data is handed out, giving data types
+      /// with deferred updates a chance to fold them in.
+      ///
+      template< class Data >
+      inline
+      void
+      sync_data( Data& data )
+      {
+      }
+
+      ///
+      /// Named groups identified by paths, such as "/solver/halo",
+      /// and the set of groups each thread currently has selected.
+      /// The root group "/" is always selected.
+      ///
+      /// Selections are per-thread and reference counted; selecting a
+      /// group twice needs two deselects to remove it. Group lookup
+      /// and creation take a lock, but finding the calling thread's
+      /// selected groups does not, and never allocates, so it can be
+      /// used from inside allocation hooks. Groups live as long as the
+      /// context, and the context's own allocations are untracked.
+      ///
+      /// Each distinct selection is interned as a group set with a
+      /// small id when it is selected. Allocation hooks record the id
+      /// with each block, so a free can be charged to the groups the
+      /// block was allocated under, whichever thread frees it and
+      /// whatever it has selected by then. Sets are never removed, and
+      /// at most `max_sets` distinct ones may be selected.
+      ///
+      template< class Data >
+      class group_context
+      {
+      public:
+
+         typedef Data data_type;
+
+         static const unsigned max_active = 16;
+         static const unsigned max_sets = 1024;
+
+         class group
+         {
+         public:
+
+            group( const std::string& path )
+               : _path( path ),
+                 _data()
+            {
+            }
+
+            const std::string&
+            path() const
+            {
+               return _path;
+            }
+
+            data_type&
+            data()
+            {
+               sync_data( _data );
+               return _data;
+            }
+
+            ///
+            /// Data without syncing, for use by updaters.
+            ///
+            data_type&
+            unsynced_data()
+            {
+               return _data;
+            }
+
+         protected:
+
+            std::string _path;
+            data_type _data;
+         };
+
+         typedef boost::indirect_iterator<group* const*> iterator;
+
+         ///
+         /// Groups of an interned set, between `set_begin` and
+         /// `set_end`.
+         ///
+         struct group_set
+         {
+            unsigned size;
+            group* groups[max_active];
+         };
+
+      public:
+
+         group_context()
+            : _ready( false )
+         {
+            untracked guard;
+            _threads.reset( new thread_state[max_thread_slots] );
+            for( unsigned ii = 0; ii < max_thread_slots; ++ii )
+            {
+               _threads[ii].epoch = 0;
+               _threads[ii].size = 0;
+               _threads[ii].set = 0;
+            }
+            _root = _get_group( "/" );
+
+            // Set zero is the root alone, which every thread starts with.
+            _sets.reset( new group_set[max_sets] );
+            _sets[0].size = 1;
+            _sets[0].groups[0] = _root;
+            _num_sets = 1;
+            _ready = true;
+         }
+
+         ~group_context()
+         {
+            untracked guard;
+            _ready = false;
+            for( typename std::map<std::string,group*>::iterator it = _groups.begin();
+                 it != _groups.end();
+                 ++it )
+            {
+               delete it->second;
+            }
+            _groups.clear();
+            _threads.reset();
+            _sets.reset();
+         }
+
+         ///
+         /// False until construction completes and again once
+         /// destruction begins.
+         ///
+         bool
+         ready() const
+         {
+            return _ready;
+         }
+
+         void
+         select( const std::string& path )
+         {
+            group* grp = _get_group( path );
+            if( grp == _root )
+               return;
+            thread_state& ts = _state();
+            for( unsigned ii = 1; ii < ts.size; ++ii )
+            {
+               if( ts.groups[ii] == grp )
+               {
+                  ++ts.counts[ii];
+                  return;
+               }
+            }
+            EXCEPT( ts.size < max_active, "Too many memory groups selected at once, selecting: ", path );
+            ts.groups[ts.size] = grp;
+            ts.counts[ts.size] = 1;
+            ++ts.size;
+            _intern( ts );
+         }
+
+         void
+         deselect( const std::string& path )
+         {
+            thread_state& ts = _state();
+            for( unsigned ii = 1; ii < ts.size; ++ii )
+            {
+               if( ts.groups[ii]->path() == path )
+               {
+                  if( !--ts.counts[ii] )
+                  {
+                     for( ++ii; ii < ts.size; ++ii )
+                     {
+                        ts.groups[ii - 1] = ts.groups[ii];
+                        ts.counts[ii - 1] = ts.counts[ii];
+                     }
+                     --ts.size;
+                     _intern( ts );
+                  }
+                  return;
+               }
+            }
+            ASSERT( path == "/", "Memory group not selected: ", path );
+         }
+
+         ///
+         /// First of the calling thread's selected groups, starting
+         /// with the root.
+         ///
+         iterator
+         begin()
+         {
+            return iterator( _state().groups );
+         }
+
+         iterator
+         end()
+         {
+            thread_state& ts = _state();
+            return iterator( ts.groups + ts.size );
+         }
+
+         ///
+         /// Id of the set of groups the calling thread has selected.
+         ///
+         unsigned
+         current_set()
+         {
+            return _state().set;
+         }
+
+         iterator
+         set_begin( unsigned set ) const
+         {
+            ASSERT( set < max_sets, "Invalid memory group set." );
+            return iterator( _sets[set].groups );
+         }
+
+         iterator
+         set_end( unsigned set ) const
+         {
+            ASSERT( set < max_sets, "Invalid memory group set." );
+            return iterator( _sets[set].groups + _sets[set].size );
+         }
+
+         group&
+         root()
+         {
+            return *_root;
+         }
+
+         group&
+         find_group( const std::string& path )
+         {
+            boost::lock_guard<boost::mutex> lock( _mutex );
+            typename std::map<std::string,group*>::iterator it = _groups.find( path );
+            EXCEPT( it != _groups.end(), "No memory group with path: ", path );
+            return *it->second;
+         }
+
+         ///
+         /// Call `func` on every group known to any thread, in path
+         /// order.
+         ///
+         template< class Func >
+         void
+         visit( Func func )
+         {
+            boost::lock_guard<boost::mutex> lock( _mutex );
+            for( typename std::map<std::string,group*>::iterator it = _groups.begin();
+                 it != _groups.end();
+                 ++it )
+            {
+               func( *it->second );
+            }
+         }
+
+      protected:
+
+         struct thread_state
+         {
+            unsigned epoch;
+            unsigned size;
+            unsigned set;
+            group* groups[max_active];
+            unsigned counts[max_active];
+         };
+
+         thread_state&
+         _state()
+         {
+            unsigned slot = thread_slot();
+            thread_state& ts = _threads[slot];
+            unsigned epoch = thread_slot_epoch( slot );
+            if( ts.epoch != epoch )
+            {
+               ts.epoch = epoch;
+               ts.size = 1;
+               ts.set = 0;
+               ts.groups[0] = _root;
+            }
+            return ts;
+         }
+
+         ///
+         /// Find or add the set matching a thread's selection. Sets
+         /// are compared by membership, not selection order. Entries
+         /// are written before their id is handed out and never change
+         /// afterwards, so hooks read them without the lock.
+         ///
+         void
+         _intern( thread_state& ts )
+         {
+            group* key[max_active];
+            std::copy( ts.groups, ts.groups + ts.size, key );
+            std::sort( key, key + ts.size );
+            boost::lock_guard<boost::mutex> lock( _mutex );
+            for( unsigned ii = 0; ii < _num_sets; ++ii )
+            {
+               if( _sets[ii].size == ts.size && std::equal( key, key + ts.size, _sets[ii].groups ) )
+               {
+                  ts.set = ii;
+                  return;
+               }
+            }
+            EXCEPT( _num_sets < max_sets, "Too many distinct memory group selections." );
+            group_set& gs = _sets[_num_sets];
+            gs.size = ts.size;
+            std::copy( key, key + ts.size, gs.groups );
+            ts.set = _num_sets++;
+         }
+
+         group*
+         _get_group( const std::string& path )
+         {
+            untracked guard;
+            boost::lock_guard<boost::mutex> lock( _mutex );
+            group*& grp = _groups[path];
+            if( !grp )
+               grp = new group( path );
+            return grp;
+         }
+
+      protected:
+
+         bool _ready;
+         group* _root;
+         std::map<std::string,group*> _groups;
+         boost::scoped_array<thread_state> _threads;
+         boost::scoped_array<group_set> _sets;
+         unsigned _num_sets;
+         boost::mutex _mutex;
+      };
+
+   }
+}
+
+#endif
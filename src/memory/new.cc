@@ -0,0 +1,260 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <cstddef>
+#include <new>
+#include <boost/static_assert.hpp>
+#include "new.hh"
+#include "globals.hh"
+
+namespace hpc {
+   namespace memory {
+
+      namespace impl {
+
+         __thread unsigned untracked_depth = 0;
+
+      }
+
+#ifndef NMEMSTATS
+
+      ///
+      /// Written in front of every block: the bytes requested and the
+      /// group set they were charged to, with a guard word in debug
+      /// builds to catch frees of blocks from elsewhere. The tag is
+      /// padded out to malloc's alignment.
+      ///
+      struct block_tag
+      {
+         uint64_t word;
+#ifndef NDEBUG
+         uint32_t guard;
+#endif
+      };
+
+      static const size_t tag_size = alignof(std::max_align_t);
+#ifndef NDEBUG
+      static const uint32_t tag_guard = 0x6d656d74;
+#endif
+      static const unsigned set_bits = 16;
+      static const unsigned untracked_set = (1 << set_bits) - 1;
+
+      BOOST_STATIC_ASSERT( sizeof(block_tag) <= tag_size );
+      BOOST_STATIC_ASSERT( group_context<state_t>::max_sets < untracked_set );
+
+      static
+      block_tag*
+      _tag( void* ptr )
+      {
+         block_tag* tag = (block_tag*)((char*)ptr - tag_size);
+#ifndef NDEBUG
+         if( tag->guard != tag_guard )
+         {
+            static const char msg[] = "hpc::memory: freeing a block not from hpc::memory::allocate\n";
+            if( ::write( 2, msg, sizeof(msg) - 1 ) ) {}
+            abort();
+         }
+#endif
+         return tag;
+      }
+
+#endif
+
+#ifndef NMEMOPS
+
+      static int _ops_fd = -1;
+
+      void
+      log_operations( int fd )
+      {
+         _ops_fd = fd;
+      }
+
+      static
+      void
+      _log_operation( char op,
+                      void* ptr,
+                      size_t size )
+      {
+         char buf[64];
+         int len = snprintf( buf, sizeof(buf), "%c %p %lu\n", op, ptr, (unsigned long)size );
+         if( len > 0 && ::write( _ops_fd, buf, len ) < 0 )
+            _ops_fd = -1;
+      }
+
+#endif
+
+      void*
+      allocate( size_t size )
+      {
+         if( !size )
+            size = 1;
+#ifndef NMEMSTATS
+         size_t charge = size;
+         size += tag_size;
+#endif
+         void* ptr;
+         while( !(ptr = malloc( size )) )
+         {
+            std::new_handler handler = std::get_new_handler();
+            if( !handler )
+               return 0;
+            handler();
+         }
+
+#ifndef NMEMSTATS
+         unsigned set = untracked_set;
+         if( ctx.ready() && !impl::untracked_depth )
+         {
+            set = ctx.current_set();
+            unsigned slot = thread_slot();
+            for( group_context<state_t>::iterator it = ctx.set_begin( set ); it != ctx.set_end( set ); ++it )
+               it->unsynced_data().add( slot, charge );
+         }
+         block_tag* tag = (block_tag*)ptr;
+         tag->word = ((uint64_t)charge << set_bits) | set;
+#ifndef NDEBUG
+         tag->guard = tag_guard;
+#endif
+         ptr = (char*)ptr + tag_size;
+         size = charge;
+#elif !defined(NMEMOPS)
+         size = malloc_usable_size( ptr );
+#endif
+#ifndef NMEMOPS
+         if( _ops_fd >= 0 )
+            _log_operation( '+', ptr, size );
+#endif
+
+         return ptr;
+      }
+
+      void
+      deallocate( void* ptr )
+      {
+         if( !ptr )
+            return;
+
+#ifndef NMEMSTATS
+         // Free against the groups the block was charged to.
+         block_tag* tag = _tag( ptr );
+         size_t size = tag->word >> set_bits;
+         unsigned set = tag->word & untracked_set;
+         if( set != untracked_set && ctx.ready() )
+         {
+            unsigned slot = thread_slot();
+            for( group_context<state_t>::iterator it = ctx.set_begin( set ); it != ctx.set_end( set ); ++it )
+               it->unsynced_data().remove( slot, size );
+         }
+#elif !defined(NMEMOPS)
+         size_t size = malloc_usable_size( ptr );
+#endif
+#ifndef NMEMOPS
+         if( _ops_fd >= 0 )
+            _log_operation( '-', ptr, size );
+#endif
+
+#ifndef NMEMSTATS
+         ptr = tag;
+#endif
+         free( ptr );
+      }
+
+      size_t
+      allocated_size( void* ptr )
+      {
+         if( !ptr )
+            return 0;
+#ifndef NMEMSTATS
+         return _tag( ptr )->word >> set_bits;
+#else
+         return malloc_usable_size( ptr );
+#endif
+      }
+
+   }
+}
+
+#if !defined(NMEMSTATS) || !defined(NMEMOPS)
+
+void*
+operator new( std::size_t size )
+{
+   void* ptr = hpc::memory::allocate( size );
+   if( !ptr )
+      throw std::bad_alloc();
+   return ptr;
+}
+
+void*
+operator new[]( std::size_t size )
+{
+   return operator new( size );
+}
+
+void*
+operator new( std::size_t size,
+              const std::nothrow_t& )
+   noexcept
+{
+   return hpc::memory::allocate( size );
+}
+
+void*
+operator new[]( std::size_t size,
+                const std::nothrow_t& )
+   noexcept
+{
+   return hpc::memory::allocate( size );
+}
+
+void
+operator delete( void* ptr )
+   noexcept
+{
+   hpc::memory::deallocate( ptr );
+}
+
+void
+operator delete[]( void* ptr )
+   noexcept
+{
+   hpc::memory::deallocate( ptr );
+}
+
+void
+operator delete( void* ptr,
+                 const std::nothrow_t& )
+   noexcept
+{
+   hpc::memory::deallocate( ptr );
+}
+
+void
+operator delete[]( void* ptr,
+                   const std::nothrow_t& )
+   noexcept
+{
+   hpc::memory::deallocate( ptr );
+}
+
+#endif
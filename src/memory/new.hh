@@ -0,0 +1,95 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_new_hh
+#define libhpc_memory_new_hh
+
+#include <stddef.h>
+
+namespace hpc {
+   namespace memory {
+
+      namespace impl {
+
+         extern __thread unsigned untracked_depth;
+
+      }
+
+      ///
+      /// Allocations made by the calling thread while an instance is
+      /// alive are not charged to any group. Used to keep the
+      /// tracker's own bookkeeping out of the statistics.
+      ///
+      class untracked
+      {
+      public:
+
+         untracked()
+         {
+            ++impl::untracked_depth;
+         }
+
+         ~untracked()
+         {
+            --impl::untracked_depth;
+         }
+      };
+
+      ///
+      /// Allocate through malloc, charging the calling thread's
+      /// selected groups. Each block is prefixed with a tag recording
+      /// the charge and the interned set of groups it went to, so
+      /// `deallocate` credits the same groups however the selection
+      /// has changed and whichever thread frees it. The charge is
+      /// exactly the requested size; the tag and malloc's own
+      /// overhead are not counted. Blocks allocated while untracked,
+      /// or before the groups exist, are tagged as such and never
+      /// charged or credited. Returns null on failure, after giving
+      /// the new handler a chance to free memory.
+      ///
+      /// Global operator new and delete are replaced with these
+      /// unless built with NMEMSTATS and NMEMOPS.
+      ///
+      void*
+      allocate( size_t size );
+
+      void
+      deallocate( void* ptr );
+
+      ///
+      /// Bytes requested, and charged, for a block returned by
+      /// `allocate`.
+      ///
+      size_t
+      allocated_size( void* ptr );
+
+#ifndef NMEMOPS
+
+      ///
+      /// Write a line per allocation ("+ address bytes") and
+      /// deallocation ("- address bytes") to `fd`. Disabled with -1,
+      /// the default.
+      ///
+      void
+      log_operations( int fd );
+
+#endif
+
+   }
+}
+
+#endif
@@ -0,0 +1,281 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include "placement.hh"
+
+// Kernel NUMA policy values, from linux/mempolicy.h. The syscalls are
+// made directly to avoid a dependency on libnuma.
+#define HPC_MPOL_DEFAULT    0
+#define HPC_MPOL_BIND       2
+#define HPC_MPOL_INTERLEAVE 3
+#define HPC_MPOL_MF_MOVE    (1 << 1)
+
+namespace hpc {
+   namespace memory {
+
+      static const unsigned max_nodes = 1024;
+      static const unsigned mask_words = max_nodes/(8*sizeof(unsigned long));
+
+      static
+      size_t
+      _page_size()
+      {
+         static size_t size = sysconf( _SC_PAGESIZE );
+         return size;
+      }
+
+      ///
+      /// Fill `mask` with the online nodes, returning how many there
+      /// are. Assumes a single node if sysfs can't tell us.
+      ///
+      static
+      unsigned
+      _online_nodes( unsigned long* mask )
+      {
+         memset( mask, 0, mask_words*sizeof(unsigned long) );
+         unsigned num = 0;
+         FILE* file = fopen( "/sys/devices/system/node/online", "r" );
+         if( file )
+         {
+            unsigned first, last;
+            int cnt;
+            while( (cnt = fscanf( file, "%u-%u", &first, &last )) > 0 )
+            {
+               if( cnt == 1 )
+                  last = first;
+               for( unsigned ii = first; ii <= last && ii < max_nodes; ++ii, ++num )
+                  mask[ii/(8*sizeof(unsigned long))] |= 1ul << (ii%(8*sizeof(unsigned long)));
+               if( fgetc( file ) != ',' )
+                  break;
+            }
+            fclose( file );
+         }
+         if( !num )
+         {
+            mask[0] = 1;
+            num = 1;
+         }
+         return num;
+      }
+
+      ///
+      /// Shrink a range to the pages it fully covers.
+      ///
+      static
+      bool
+      _page_range( void*& ptr,
+                   size_t& size )
+      {
+         size_t page = _page_size();
+         size_t first = ((size_t)ptr + page - 1) & ~(page - 1);
+         size_t last = ((size_t)ptr + size) & ~(page - 1);
+         if( last <= first )
+            return false;
+         ptr = (void*)first;
+         size = last - first;
+         return true;
+      }
+
+      static
+      bool
+      _mbind( void* ptr,
+              size_t size,
+              int mode,
+              const unsigned long* mask )
+      {
+         if( !_page_range( ptr, size ) )
+            return true;
+         return syscall( SYS_mbind, ptr, size, mode, mask, max_nodes + 1, HPC_MPOL_MF_MOVE ) == 0;
+      }
+
+      ///
+      /// Alignment used to map a buffer, which also sets the size
+      /// that is mapped.
+      ///
+      static
+      size_t
+      _mapping_alignment( size_t size,
+                          const placement& place )
+      {
+         size_t huge = place.huge_pages ? huge_page_size() : 0;
+         return (huge && size >= huge) ? huge : _page_size();
+      }
+
+      placement::placement( policy_type policy,
+                            bool huge_pages,
+                            bool parallel_touch,
+                            size_t threshold )
+         : policy( policy ),
+           node( 0 ),
+           huge_pages( huge_pages ),
+           parallel_touch( parallel_touch ),
+           threshold( threshold )
+      {
+      }
+
+      bool
+      placement::operator==( const placement& op ) const
+      {
+         return policy == op.policy && node == op.node && huge_pages == op.huge_pages &&
+            parallel_touch == op.parallel_touch && threshold == op.threshold;
+      }
+
+      size_t
+      huge_page_size()
+      {
+         static size_t size = size_t( -1 );
+         if( size == size_t( -1 ) )
+         {
+            size_t found = 0;
+            FILE* file = fopen( "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r" );
+            if( file )
+            {
+               unsigned long val;
+               if( fscanf( file, "%lu", &val ) == 1 )
+                  found = val;
+               fclose( file );
+            }
+            size = found;
+         }
+         return size;
+      }
+
+      unsigned
+      numa_nodes()
+      {
+         unsigned long mask[mask_words];
+         return _online_nodes( mask );
+      }
+
+      void*
+      placed_allocate( size_t size,
+                       const placement& place )
+      {
+         size_t align = _mapping_alignment( size, place );
+         size_t mapped = (size + align - 1) & ~(align - 1);
+
+         // Over-map by one alignment and trim either side, so huge
+         // page sized regions start on a huge page boundary.
+         size_t extra = (align > _page_size()) ? align : 0;
+         char* base = (char*)mmap( 0, mapped + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+         if( base == (char*)MAP_FAILED )
+            throw std::bad_alloc();
+         char* ptr = (char*)(((size_t)base + align - 1) & ~(align - 1));
+         if( extra )
+         {
+            if( ptr > base )
+               munmap( base, ptr - base );
+            if( base + extra > ptr )
+               munmap( ptr + mapped, base + extra - ptr );
+         }
+
+         if( align > _page_size() )
+            advise_huge_pages( ptr, mapped );
+         if( place.policy == placement::interleave )
+            interleave_pages( ptr, mapped );
+         else if( place.policy == placement::bind )
+            bind_pages( ptr, mapped, place.node );
+         if( place.parallel_touch )
+            parallel_touch( ptr, mapped );
+         return ptr;
+      }
+
+      void
+      placed_deallocate( void* ptr,
+                         size_t size,
+                         const placement& place )
+      {
+         if( !ptr )
+            return;
+         size_t align = _mapping_alignment( size, place );
+         munmap( ptr, (size + align - 1) & ~(align - 1) );
+      }
+
+      bool
+      advise_huge_pages( void* ptr,
+                         size_t size )
+      {
+#ifdef MADV_HUGEPAGE
+         if( !_page_range( ptr, size ) )
+            return true;
+         return madvise( ptr, size, MADV_HUGEPAGE ) == 0;
+#else
+         return false;
+#endif
+      }
+
+      bool
+      interleave_pages( void* ptr,
+                        size_t size )
+      {
+         unsigned long mask[mask_words];
+         _online_nodes( mask );
+         return _mbind( ptr, size, HPC_MPOL_INTERLEAVE, mask );
+      }
+
+      bool
+      bind_pages( void* ptr,
+                  size_t size,
+                  int node )
+      {
+         if( node < 0 || node >= (int)max_nodes )
+            return false;
+         unsigned long mask[mask_words];
+         memset( mask, 0, sizeof(mask) );
+         mask[node/(8*sizeof(unsigned long))] = 1ul << (node%(8*sizeof(unsigned long)));
+         return _mbind( ptr, size, HPC_MPOL_BIND, mask );
+      }
+
+      void
+      parallel_touch( void* ptr,
+                      size_t size )
+      {
+         if( !size )
+            return;
+         size_t page = _page_size();
+         volatile char* first = (volatile char*)((size_t)ptr & ~(page - 1));
+         long num = ((size_t)ptr + size - (size_t)first + page - 1)/page;
+
+         // Page zero may start before `ptr`, so touch at `ptr` itself.
+         volatile char* start = (volatile char*)ptr;
+         *start = *start;
+
+#pragma omp parallel for schedule(static)
+         for( long ii = 1; ii < num; ++ii )
+            first[ii*page] = first[ii*page];
+      }
+
+      scoped_interleave::scoped_interleave()
+      {
+         unsigned long mask[mask_words];
+         _online_nodes( mask );
+         _active = syscall( SYS_set_mempolicy, HPC_MPOL_INTERLEAVE, mask, max_nodes + 1 ) == 0;
+      }
+
+      scoped_interleave::~scoped_interleave()
+      {
+         if( _active )
+            syscall( SYS_set_mempolicy, HPC_MPOL_DEFAULT, 0, 0 );
+      }
+
+   }
+}
@@ -0,0 +1,276 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_placement_hh
+#define libhpc_memory_placement_hh
+
+#include <stddef.h>
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace hpc {
+   namespace memory {
+
+      ///
+      /// Where and how a large buffer's pages should be placed.
+      ///
+      /// `first_touch` leaves NUMA placement to the kernel, which puts
+      /// each page on the node of the thread that first writes it;
+      /// `interleave` spreads pages round-robin over all online nodes
+      /// and `bind` puts them all on `node`. With `huge_pages` the
+      /// buffer is aligned to the transparent huge page size and
+      /// advised to use them. With `parallel_touch` the pages are
+      /// written once from an OpenMP parallel loop with static
+      /// schedule, so a later static loop over the same range finds
+      /// its pages local. Buffers smaller than `threshold` bytes are
+      /// left to the heap.
+      ///
+      struct placement
+      {
+         enum policy_type
+         {
+            first_touch,
+            interleave,
+            bind
+         };
+
+         placement( policy_type policy = first_touch,
+                    bool huge_pages = true,
+                    bool parallel_touch = true,
+                    size_t threshold = 1 << 20 );
+
+         bool
+         operator==( const placement& op ) const;
+
+         bool
+         operator!=( const placement& op ) const
+         {
+            return !(*this == op);
+         }
+
+         policy_type policy;
+         int node;
+         bool huge_pages;
+         bool parallel_touch;
+         size_t threshold;
+      };
+
+      ///
+      /// Size of a transparent huge page, or zero if the kernel has
+      /// none.
+      ///
+      size_t
+      huge_page_size();
+
+      ///
+      /// Number of online NUMA nodes, at least one.
+      ///
+      unsigned
+      numa_nodes();
+
+      ///
+      /// Map fresh zeroed pages for `size` bytes and place them
+      /// according to `place`. Throws std::bad_alloc if the mapping
+      /// fails. Placement hints the kernel refuses are ignored.
+      ///
+      void*
+      placed_allocate( size_t size,
+                       const placement& place );
+
+      void
+      placed_deallocate( void* ptr,
+                         size_t size,
+                         const placement& place );
+
+      ///
+      /// Advise the kernel to back the pages fully inside a range
+      /// with huge pages. Returns false if it refused.
+      ///
+      bool
+      advise_huge_pages( void* ptr,
+                         size_t size );
+
+      ///
+      /// Set the NUMA policy of the pages fully inside a range. Pages
+      /// already touched are migrated. Returns false if the kernel
+      /// refused, for example when it lacks NUMA support.
+      ///
+      bool
+      interleave_pages( void* ptr,
+                        size_t size );
+
+      bool
+      bind_pages( void* ptr,
+                  size_t size,
+                  int node );
+
+      ///
+      /// Fault in every page of a range by rewriting one byte of it
+      /// in place, split across the OpenMP threads with static
+      /// schedule. Contents are unchanged.
+      ///
+      void
+      parallel_touch( void* ptr,
+                      size_t size );
+
+      ///
+      /// Interleave every page the calling thread allocates, from any
+      /// source, while in scope. Useful around third party code that
+      /// allocates its own large buffers. The thread returns to the
+      /// default policy afterwards.
+      ///
+      class scoped_interleave
+      {
+      public:
+
+         scoped_interleave();
+
+         ~scoped_interleave();
+
+         bool
+         active() const
+         {
+            return _active;
+         }
+
+      protected:
+
+         bool _active;
+      };
+
+      ///
+      /// Standard allocator placing large buffers according to a
+      /// `placement`. Containers resized with `hpc::reallocate` keep
+      /// their allocator, and so their placement.
+      ///
+      /// Constructing without arguments default-initialises, so
+      /// resizing a vector of trivial values does not write to the
+      /// new pages from the calling thread and undo the placement.
+      /// Fresh storage is always zeroed, but values left in storage
+      /// by a shrink are not cleared by a later grow.
+      ///
+      template< class T >
+      class placed_allocator
+      {
+      public:
+
+         typedef T value_type;
+         typedef T* pointer;
+         typedef const T* const_pointer;
+         typedef T& reference;
+         typedef const T& const_reference;
+         typedef size_t size_type;
+         typedef ptrdiff_t difference_type;
+         typedef std::false_type propagate_on_container_copy_assignment;
+         typedef std::true_type propagate_on_container_move_assignment;
+         typedef std::true_type propagate_on_container_swap;
+
+         template< class U >
+         struct rebind
+         {
+            typedef placed_allocator<U> other;
+         };
+
+      public:
+
+         placed_allocator( const memory::placement& place = memory::placement() )
+            : _place( place )
+         {
+         }
+
+         template< class U >
+         placed_allocator( const placed_allocator<U>& src )
+            : _place( src.placement() )
+         {
+         }
+
+         const memory::placement&
+         placement() const
+         {
+            return _place;
+         }
+
+         pointer
+         allocate( size_type size )
+         {
+            size_t bytes = size*sizeof(T);
+            if( bytes >= _place.threshold )
+               return (pointer)placed_allocate( bytes, _place );
+            void* ptr = ::operator new( bytes );
+            if( std::is_trivially_default_constructible<T>::value )
+               std::fill( (char*)ptr, (char*)ptr + bytes, 0 );
+            return (pointer)ptr;
+         }
+
+         void
+         deallocate( pointer ptr,
+                     size_type size )
+         {
+            size_t bytes = size*sizeof(T);
+            if( bytes >= _place.threshold )
+               placed_deallocate( ptr, bytes, _place );
+            else
+               ::operator delete( ptr );
+         }
+
+         template< class U >
+         void
+         construct( U* ptr )
+         {
+            ::new( (void*)ptr ) U;
+         }
+
+         template< class U,
+                   class... Args >
+         void
+         construct( U* ptr,
+                    Args&&... args )
+         {
+            ::new( (void*)ptr ) U( std::forward<Args>( args )... );
+         }
+
+         size_type
+         max_size() const
+         {
+            return size_t( -1 )/sizeof(T);
+         }
+
+         template< class U >
+         bool
+         operator==( const placed_allocator<U>& op ) const
+         {
+            return _place == op.placement();
+         }
+
+         template< class U >
+         bool
+         operator!=( const placed_allocator<U>& op ) const
+         {
+            return _place != op.placement();
+         }
+
+      protected:
+
+         memory::placement _place;
+      };
+
+   }
+}
+
+#endif
@@ -0,0 +1,68 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include "pool.hh"
+
+namespace hpc {
+   namespace memory {
+
+      pool::pool( size_t block_size,
+                  size_t chunk_blocks )
+         : _block_size( (std::max( block_size, sizeof(node) ) + alignment - 1) & ~(alignment - 1) ),
+           _chunk_blocks( std::max<size_t>( chunk_blocks, 1 ) ),
+           _num_used( 0 ),
+           _free( 0 ),
+           _chunks( 0 )
+      {
+      }
+
+      pool::~pool()
+      {
+         release();
+      }
+
+      void
+      pool::release()
+      {
+         while( _chunks )
+         {
+            node* next = _chunks->next;
+            ::operator delete( _chunks );
+            _chunks = next;
+         }
+         _free = 0;
+         _num_used = 0;
+      }
+
+      void
+      pool::_grow()
+      {
+         // The first block's worth of each chunk links the chunks.
+         char* chunk = (char*)::operator new( (_chunk_blocks + 1)*_block_size );
+         ((node*)chunk)->next = _chunks;
+         _chunks = (node*)chunk;
+         for( size_t ii = _chunk_blocks; ii > 0; --ii )
+         {
+            node* blk = (node*)(chunk + ii*_block_size);
+            blk->next = _free;
+            _free = blk;
+         }
+      }
+
+   }
+}
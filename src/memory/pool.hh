@@ -0,0 +1,219 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_pool_hh
+#define libhpc_memory_pool_hh
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+namespace hpc {
+   namespace memory {
+
+      ///
+      /// Pool of fixed-size blocks carved out of large chunks, with
+      /// freed blocks kept on an intrusive free list. Allocation and
+      /// deallocation are a couple of pointer moves, and objects of
+      /// the same size never fragment the heap. Chunks are only
+      /// returned by `release` or destruction.
+      ///
+      /// Not thread safe; use one pool per thread.
+      ///
+      class pool
+      {
+      public:
+
+         static const size_t alignment = 16;
+
+      public:
+
+         pool( size_t block_size,
+               size_t chunk_blocks = 1024 );
+
+         ~pool();
+
+         void*
+         allocate()
+         {
+            if( !_free )
+               _grow();
+            node* blk = _free;
+            _free = blk->next;
+            ++_num_used;
+            return blk;
+         }
+
+         void
+         deallocate( void* ptr )
+         {
+            node* blk = (node*)ptr;
+            blk->next = _free;
+            _free = blk;
+            --_num_used;
+         }
+
+         ///
+         /// Return all chunks to the heap. Nothing allocated from the
+         /// pool may still be in use.
+         ///
+         void
+         release();
+
+         size_t
+         block_size() const
+         {
+            return _block_size;
+         }
+
+         ///
+         /// Blocks currently allocated.
+         ///
+         size_t
+         size() const
+         {
+            return _num_used;
+         }
+
+      protected:
+
+         struct node
+         {
+            node* next;
+         };
+
+         void
+         _grow();
+
+      protected:
+
+         size_t _block_size;
+         size_t _chunk_blocks;
+         size_t _num_used;
+         node* _free;
+         node* _chunks;
+      };
+
+      ///
+      /// Standard allocator taking single objects from a pool, meant
+      /// for node based containers and individually allocated
+      /// objects. Requests for arrays, or for types larger than the
+      /// pool's blocks (after rebinding), go to the global heap, as do
+      /// all requests from a default constructed allocator.
+      ///
+      template< class T >
+      class pool_allocator
+      {
+      public:
+
+         typedef T value_type;
+         typedef T* pointer;
+         typedef const T* const_pointer;
+         typedef T& reference;
+         typedef const T& const_reference;
+         typedef size_t size_type;
+         typedef ptrdiff_t difference_type;
+         typedef std::false_type propagate_on_container_copy_assignment;
+         typedef std::true_type propagate_on_container_move_assignment;
+         typedef std::true_type propagate_on_container_swap;
+
+         template< class U >
+         struct rebind
+         {
+            typedef pool_allocator<U> other;
+         };
+
+      public:
+
+         pool_allocator()
+            : _pool( 0 )
+         {
+         }
+
+         pool_allocator( memory::pool& pool )
+            : _pool( &pool )
+         {
+         }
+
+         template< class U >
+         pool_allocator( const pool_allocator<U>& src )
+            : _pool( src.pool() )
+         {
+         }
+
+         memory::pool*
+         pool() const
+         {
+            return _pool;
+         }
+
+         pointer
+         allocate( size_type size )
+         {
+            if( _pooled( size ) )
+               return (pointer)_pool->allocate();
+            else
+               return (pointer)::operator new( size*sizeof(T) );
+         }
+
+         void
+         deallocate( pointer ptr,
+                     size_type size )
+         {
+            if( _pooled( size ) )
+               _pool->deallocate( ptr );
+            else
+               ::operator delete( ptr );
+         }
+
+         size_type
+         max_size() const
+         {
+            return size_t( -1 )/sizeof(T);
+         }
+
+         template< class U >
+         bool
+         operator==( const pool_allocator<U>& op ) const
+         {
+            return _pool == op.pool();
+         }
+
+         template< class U >
+         bool
+         operator!=( const pool_allocator<U>& op ) const
+         {
+            return _pool != op.pool();
+         }
+
+      protected:
+
+         bool
+         _pooled( size_type size ) const
+         {
+            return _pool && size == 1 && sizeof(T) <= _pool->block_size();
+         }
+
+      protected:
+
+         memory::pool* _pool;
+      };
+
+   }
+}
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "globals.hh"
+#include "report.hh"
+
+namespace hpc {
+   namespace memory {
+
+#ifndef NMEMSTATS
+
+      struct _report_visitor
+      {
+         _report_visitor( std::vector<group_report>& rep )
+            : rep( rep )
+         {
+         }
+
+         void
+         operator()( group_context<state_t>::group& grp )
+         {
+            state_t& state = grp.data();
+            group_report gr;
+            gr.path = grp.path();
+            gr.size = state.size;
+            gr.peak = state.peak;
+            gr.count = state.count;
+            gr.total = state.total;
+            rep.push_back( gr );
+         }
+
+         std::vector<group_report>& rep;
+      };
+
+#endif
+
+      std::vector<group_report>
+      report()
+      {
+         std::vector<group_report> rep;
+#ifndef NMEMSTATS
+         ctx.visit( _report_visitor( rep ) );
+#endif
+         return rep;
+      }
+
+      std::ostream&
+      operator<<( std::ostream& strm,
+                  group_report const& obj )
+      {
+         strm << obj.path << ": size " << obj.size << ", peak " << obj.peak
+              << ", count " << obj.count << ", total " << obj.total;
+         return strm;
+      }
+
+   }
+}
@@ -0,0 +1,51 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_report_hh
+#define libhpc_memory_report_hh
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace hpc {
+   namespace memory {
+
+      struct group_report
+      {
+         std::string path;
+         size_t size;
+         size_t peak;
+         size_t count;
+         size_t total;
+      };
+
+      ///
+      /// Snapshot of every memory group, sorted by path. Empty when
+      /// built with NMEMSTATS.
+      ///
+      std::vector<group_report>
+      report();
+
+      std::ostream&
+      operator<<( std::ostream& strm,
+                  group_report const& obj );
+
+   }
+}
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+#include <boost/thread/locks.hpp>
+#include "state.hh"
+
+namespace hpc {
+   namespace memory {
+
+      state_t::shard::shard()
+         : delta( 0 ),
+           high( 0 ),
+           allocs( 0 ),
+           frees( 0 )
+      {
+      }
+
+      state_t::state_t()
+         : size( 0 ),
+           peak( 0 ),
+           count( 0 ),
+           total( 0 )
+      {
+         // Straight from malloc, so the shards are never charged to a
+         // group themselves.
+         void* buf;
+         if( posix_memalign( &buf, cache_line_size, num_shards*sizeof(shard) ) )
+            throw std::bad_alloc();
+         _shards = (shard*)buf;
+         for( unsigned ii = 0; ii < num_shards; ++ii )
+            new( _shards + ii ) shard;
+      }
+
+      state_t::~state_t()
+      {
+         for( unsigned ii = 0; ii < num_shards; ++ii )
+            _shards[ii].~shard();
+         free( _shards );
+      }
+
+      void
+      state_t::sync()
+      {
+         boost::lock_guard<boost::mutex> lock( _mutex );
+         long delta = 0, high = 0;
+         unsigned long allocs = 0, frees = 0;
+         for( unsigned ii = 0; ii < num_shards; ++ii )
+         {
+            shard& sh = _shards[ii];
+            delta += sh.delta.exchange( 0, boost::memory_order_relaxed );
+            high += std::max( sh.high.exchange( 0, boost::memory_order_relaxed ), 0l );
+            allocs += sh.allocs.exchange( 0, boost::memory_order_relaxed );
+            frees += sh.frees.exchange( 0, boost::memory_order_relaxed );
+         }
+         peak = std::max( peak, size + high );
+         size += delta;
+         peak = std::max( peak, size );
+         count += allocs - frees;
+         total += allocs;
+      }
+
+   }
+}
@@ -0,0 +1,124 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_state_hh
+#define libhpc_memory_state_hh
+
+#include <stddef.h>
+#include <boost/atomic.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace hpc {
+   namespace memory {
+
+      ///
+      /// Allocation statistics for one group: current bytes, peak
+      /// bytes, live allocations and allocations ever made.
+      ///
+      /// Allocations are counted into a shard picked by thread slot,
+      /// using relaxed atomics on a cache line the thread usually has
+      /// to itself, and each shard tracks its running high water mark.
+      /// Shards are allocated on cache line boundaries, separately from
+      /// the state, so they stay aligned wherever the state lives.
+      /// `sync` folds the shards into the plain fields. The peak is
+      /// exact when only one thread allocates between syncs, and
+      /// otherwise an upper bound that assumes the shard highs
+      /// coincided.
+      ///
+      class state_t
+      {
+      public:
+
+         static const unsigned num_shards = 64;
+         static const size_t cache_line_size = 64;
+
+      public:
+
+         state_t();
+
+         ~state_t();
+
+         void
+         add( unsigned slot,
+              size_t size )
+         {
+            shard& sh = _shards[slot%num_shards];
+            long cur = sh.delta.fetch_add( size, boost::memory_order_relaxed ) + (long)size;
+            long high = sh.high.load( boost::memory_order_relaxed );
+            while( cur > high && !sh.high.compare_exchange_weak( high, cur, boost::memory_order_relaxed ) );
+            sh.allocs.fetch_add( 1, boost::memory_order_relaxed );
+         }
+
+         void
+         remove( unsigned slot,
+                 size_t size )
+         {
+            shard& sh = _shards[slot%num_shards];
+            sh.delta.fetch_sub( size, boost::memory_order_relaxed );
+            sh.frees.fetch_add( 1, boost::memory_order_relaxed );
+         }
+
+         void
+         sync();
+
+      public:
+
+         size_t size;
+         size_t peak;
+         size_t count;
+         size_t total;
+
+      protected:
+
+         struct shard
+         {
+            shard();
+
+            boost::atomic<long> delta;
+            boost::atomic<long> high;
+            boost::atomic<unsigned long> allocs;
+            boost::atomic<unsigned long> frees;
+            char _pad[cache_line_size - 2*sizeof(long) - 2*sizeof(unsigned long)];
+         };
+
+         BOOST_STATIC_ASSERT( sizeof(shard) == cache_line_size );
+
+      private:
+
+         state_t( const state_t& );
+
+         state_t&
+         operator=( const state_t& );
+
+      protected:
+
+         shard* _shards;
+         boost::mutex _mutex;
+      };
+
+      inline
+      void
+      sync_data( state_t& state )
+      {
+         state.sync();
+      }
+
+   }
+}
+
+#endif
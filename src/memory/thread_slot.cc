@@ -0,0 +1,93 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <pthread.h>
+#include "thread_slot.hh"
+
+namespace hpc {
+   namespace memory {
+      namespace impl {
+
+         __thread int thread_slot = -1;
+
+         // Plain pthread primitives so that slots can be handed out
+         // from inside operator new, before any constructors have run.
+         static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+         static pthread_once_t _once = PTHREAD_ONCE_INIT;
+         static pthread_key_t _key;
+         static unsigned _free[max_thread_slots];
+         static unsigned _num_free = 0;
+         static unsigned _next = 0;
+         static unsigned _epochs[max_thread_slots];
+
+         static
+         void
+         _release_thread_slot( void* )
+         {
+            if( thread_slot < 0 )
+               return;
+            pthread_mutex_lock( &_mutex );
+            if( _num_free < max_thread_slots )
+               _free[_num_free++] = thread_slot;
+            pthread_mutex_unlock( &_mutex );
+            thread_slot = -1;
+         }
+
+         static
+         void
+         _make_key()
+         {
+            pthread_key_create( &_key, _release_thread_slot );
+         }
+
+         unsigned
+         acquire_thread_slot()
+         {
+            pthread_once( &_once, _make_key );
+            pthread_mutex_lock( &_mutex );
+            unsigned slot;
+            bool owned = true;
+            if( _num_free )
+               slot = _free[--_num_free];
+            else if( _next < max_thread_slots )
+               slot = _next++;
+            else
+            {
+               slot = _next++%max_thread_slots;
+               owned = false;
+            }
+            if( owned )
+               ++_epochs[slot];
+            pthread_mutex_unlock( &_mutex );
+
+            // Only exclusively owned slots are given back on exit.
+            thread_slot = slot;
+            if( owned )
+               pthread_setspecific( _key, (void*)1 );
+            return slot;
+         }
+
+      }
+
+      unsigned
+      thread_slot_epoch( unsigned slot )
+      {
+         return impl::_epochs[slot];
+      }
+
+   }
+}
@@ -0,0 +1,60 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_memory_thread_slot_hh
+#define libhpc_memory_thread_slot_hh
+
+namespace hpc {
+   namespace memory {
+
+      static const unsigned max_thread_slots = 256;
+
+      namespace impl {
+
+         extern __thread int thread_slot;
+
+         unsigned
+         acquire_thread_slot();
+
+      }
+
+      ///
+      /// Small dense index for the calling thread, used to find its
+      /// selection state and counters without hashing or locking.
+      /// Slots are handed back when a thread exits and reused. With
+      /// more than `max_thread_slots` live threads slots start to be
+      /// shared, which keeps counts correct but merges selections.
+      ///
+      inline
+      unsigned
+      thread_slot()
+      {
+         int slot = impl::thread_slot;
+         return (slot >= 0) ? slot : impl::acquire_thread_slot();
+      }
+
+      ///
+      /// Incremented each time a slot is handed to a new thread, so
+      /// per-slot state left by an exited thread can be recognised.
+      ///
+      unsigned
+      thread_slot_epoch( unsigned slot );
+
+   }
+}
+
+#endif
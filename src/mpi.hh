@@ -31,5 +31,6 @@
 #include "mpi/indexer.hh"
 #include "mpi/async.hh"
 #include "mpi/application.hh"
+#include "mpi/memory_report.hh"
 
 #endif
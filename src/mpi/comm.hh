@@ -706,6 +706,76 @@ namespace hpc {
             return res;
          }
 
+         template< class T >
+         std::vector<T>
+         all_to_all( std::vector<T> const& out ) const
+         {
+            ASSERT( (int)out.size() == size(), "all_to_all requires one value per rank." );
+            std::vector<T> inc( size() );
+            int bsize = MPI_MAP_TYPE_SIZE( T );
+	    MPI_INSIST( MPI_Alltoall( (void*)out.data(), bsize, MPI_MAP_TYPE( T ),
+                                      inc.data(),        bsize, MPI_MAP_TYPE( T ),
+                                      _comm ) );
+            return inc;
+         }
+
+         ///
+         /// Exchange variable sized blocks with every rank. `out_cnts`
+         /// and `inc_cnts` give the number of values sent to and
+         /// received from each rank; blocks are contiguous and in
+         /// rank order.
+         ///
+         template< class T >
+         void
+         all_to_allv( T const* out,
+                      std::vector<int> const& out_cnts,
+                      T* inc,
+                      std::vector<int> const& inc_cnts ) const
+         {
+            ASSERT( (int)out_cnts.size() == size(), "all_to_allv requires one send count per rank." );
+            ASSERT( (int)inc_cnts.size() == size(), "all_to_allv requires one receive count per rank." );
+
+            // Counts are in blocks of the mapped type.
+            int bsize = MPI_MAP_TYPE_SIZE( T );
+            std::vector<int> scnts( size() ), sdispls( size() ), rcnts( size() ), rdispls( size() );
+            int sdispl = 0, rdispl = 0;
+            for( int ii = 0; ii < size(); ++ii )
+            {
+               scnts[ii] = bsize*out_cnts[ii];
+               sdispls[ii] = sdispl;
+               sdispl += scnts[ii];
+               rcnts[ii] = bsize*inc_cnts[ii];
+               rdispls[ii] = rdispl;
+               rdispl += rcnts[ii];
+            }
+	    MPI_INSIST( MPI_Alltoallv( (void*)out, scnts.data(), sdispls.data(), MPI_MAP_TYPE( T ),
+                                       inc, rcnts.data(), rdispls.data(), MPI_MAP_TYPE( T ),
+                                       _comm ) );
+         }
+
+         ///
+         /// Exchange variable sized blocks with every rank, returning
+         /// the incoming blocks concatenated in rank order. The
+         /// receive counts are exchanged first and returned in
+         /// `inc_cnts` if given.
+         ///
+         template< class T >
+         std::vector<T>
+         all_to_allv( std::vector<T> const& out,
+                      std::vector<int> const& out_cnts,
+                      std::vector<int>* inc_cnts = 0 ) const
+         {
+            std::vector<int> cnts = all_to_all( out_cnts );
+            long total = 0;
+            for( int ii = 0; ii < size(); ++ii )
+               total += cnts[ii];
+            std::vector<T> inc( total );
+            all_to_allv( out.data(), out_cnts, inc.data(), cnts );
+            if( inc_cnts )
+               inc_cnts->swap( cnts );
+            return inc;
+         }
+
 	 // template< class T >
 	 // void
 	 // all_gather( const T& value,
@@ -848,6 +918,28 @@ namespace hpc {
 	    return inc;
 	 }
 
+	 /// Scan an array of values element-wise across ranks.
+	 template< class T >
+	 void
+	 scan( view<std::vector<T> > buf,
+	       MPI_Op op = MPI_SUM,
+	       bool exclusive = true ) const
+	 {
+	    std::vector<T> inc( buf.size() );
+	    MPI_INSIST( MPI_Scan( (void*)buf.data(),
+                                  (void*)inc.data(),
+                                  buf.size(),
+                                  MPI_MAP_TYPE( T ),
+                                  op,
+                                  this->_comm ) );
+	    if( exclusive )
+	    {
+	       for( size_t ii = 0; ii < inc.size(); ++ii )
+		  inc[ii] -= buf[ii];
+	    }
+	    std::copy( inc.begin(), inc.end(), buf.begin() );
+	 }
+
 	 template<class T>
 	 void
 	 chain_send(const T& out,
@@ -0,0 +1,324 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef hpc_mpi_distributed_csr_hh
+#define hpc_mpi_distributed_csr_hh
+
+#include <vector>
+#include <algorithm>
+#include "libhpc/debug/assert.hh"
+#include "libhpc/containers/csr.hh"
+#include "comm.hh"
+#include "vct.hh"
+#include "requests.hh"
+
+namespace hpc {
+   namespace mpi {
+
+      ///
+      /// A csr with rows partitioned across a communicator. Each rank
+      /// owns a contiguous range of global rows, in rank order. Rows
+      /// owned by other ranks that are referenced locally can be
+      /// fetched as ghost rows.
+      ///
+      /// The ghost exchange schedule is computed once by
+      /// `setup_ghosts`, after which `update_ghosts` refreshes the
+      /// ghost values with a single vct scatter and no further
+      /// negotiation. The schedule assumes the sizes of the owned rows
+      /// do not change; call `setup_ghosts` again if they do.
+      ///
+      template< class T >
+      class distributed_csr
+      {
+      public:
+
+         typedef T value_type;
+
+      public:
+
+         distributed_csr( mpi::comm const& comm = mpi::comm::world )
+            : _comm( &comm ),
+              _vct( comm )
+         {
+         }
+
+         void
+         clear()
+         {
+            _local.deallocate();
+            _ghosts.deallocate();
+            hpc::deallocate( _row_displs );
+            _clear_schedule();
+         }
+
+         mpi::comm const&
+         comm() const
+         {
+            return *_comm;
+         }
+
+         ///
+         /// Set the locally owned rows. The contents of `local` are
+         /// taken. This is collective, as the global row offsets are
+         /// gathered from all ranks.
+         ///
+         void
+         set_local( csr<T>& local )
+         {
+            clear();
+            _local.take( local );
+            std::vector<index> cnts = _comm->all_gather<index>( _local.num_rows() );
+            hpc::counts_to_displs_resize( cnts, _row_displs );
+         }
+
+         csr<T> const&
+         local() const
+         {
+            return _local;
+         }
+
+         csr<T>&
+         mod_local()
+         {
+            return _local;
+         }
+
+         csr<T> const&
+         ghosts() const
+         {
+            return _ghosts;
+         }
+
+         std::vector<index> const&
+         ghost_rows() const
+         {
+            return _ghost_rows;
+         }
+
+         index
+         num_global_rows() const
+         {
+            return _row_displs.size() ? _row_displs.back() : 0;
+         }
+
+         index
+         row_begin() const
+         {
+            return _row_displs[_comm->rank()];
+         }
+
+         index
+         row_end() const
+         {
+            return _row_displs[_comm->rank() + 1];
+         }
+
+         bool
+         is_local( index row ) const
+         {
+            return row >= row_begin() && row < row_end();
+         }
+
+         int
+         owner( index row ) const
+         {
+            ASSERT( row >= 0 && row < num_global_rows(), "Invalid global row." );
+            return std::upper_bound( _row_displs.begin(), _row_displs.end(), row ) - _row_displs.begin() - 1;
+         }
+
+         bool
+         has_row( index row ) const
+         {
+            return is_local( row ) || std::binary_search( _ghost_rows.begin(), _ghost_rows.end(), row );
+         }
+
+         ///
+         /// Access a local or ghost row by global index.
+         ///
+         const typename vector<T>::view
+         operator[]( index row ) const
+         {
+            if( is_local( row ) )
+               return _local[row - row_begin()];
+            std::vector<index>::const_iterator it = std::lower_bound( _ghost_rows.begin(), _ghost_rows.end(), row );
+            ASSERT( it != _ghost_rows.end() && *it == row, "Row is neither local nor a ghost." );
+            return _ghosts[it - _ghost_rows.begin()];
+         }
+
+         ///
+         /// Compute the ghost exchange schedule from the global rows
+         /// referenced locally. References may contain duplicates and
+         /// locally owned rows. Collective. Ghost values are filled
+         /// before returning.
+         ///
+         template< class Iter >
+         void
+         setup_ghosts( Iter begin,
+                       Iter const& end )
+         {
+            _clear_schedule();
+            int size = _comm->size();
+            int rank = _comm->rank();
+
+            // Sorted unique non-local rows. Being sorted also groups
+            // them by owner.
+            for( ; begin != end; ++begin )
+            {
+               if( !is_local( *begin ) )
+                  _ghost_rows.push_back( *begin );
+            }
+            std::sort( _ghost_rows.begin(), _ghost_rows.end() );
+            _ghost_rows.erase( std::unique( _ghost_rows.begin(), _ghost_rows.end() ), _ghost_rows.end() );
+
+            // Count how many rows I need from each rank, and find out
+            // how many each rank needs from me.
+            std::vector<index> req_cnts( size );
+            for( std::vector<index>::const_iterator it = _ghost_rows.begin(); it != _ghost_rows.end(); ++it )
+               ++req_cnts[owner( *it )];
+            std::vector<index> inc_cnts = _comm->all_to_all( req_cnts );
+
+            // Neighbours are any ranks we exchange with in either
+            // direction; the vct requires this to be symmetric.
+            std::vector<unsigned> nbrs;
+            for( int ii = 0; ii < size; ++ii )
+            {
+               if( ii != rank && (req_cnts[ii] || inc_cnts[ii]) )
+                  nbrs.push_back( ii );
+            }
+            _vct.set_neighbors( nbrs );
+
+            // Row displacements per neighbour.
+            std::vector<index> recv_row_displs( nbrs.size() + 1 ), send_row_displs( nbrs.size() + 1 );
+            recv_row_displs[0] = send_row_displs[0] = 0;
+            for( unsigned ii = 0; ii < nbrs.size(); ++ii )
+            {
+               recv_row_displs[ii + 1] = recv_row_displs[ii] + req_cnts[nbrs[ii]];
+               send_row_displs[ii + 1] = send_row_displs[ii] + inc_cnts[nbrs[ii]];
+            }
+
+            // Send my requested rows to their owners.
+            _send_rows.resize( send_row_displs.back() );
+            {
+               mpi::requests reqs;
+               _vct.iscatter<index>( _ghost_rows.data(), recv_row_displs,
+                                     _send_rows.data(), send_row_displs,
+                                     MPI_MAP_TYPE( index ), reqs );
+               reqs.wait_all();
+            }
+            for( std::vector<index>::iterator it = _send_rows.begin(); it != _send_rows.end(); ++it )
+            {
+               ASSERT( is_local( *it ), "Requested a row I don't own." );
+               *it -= row_begin();
+            }
+
+            // Return the sizes of the requested rows.
+            std::vector<index> send_sizes( _send_rows.size() ), ghost_displs( _ghost_rows.size() + 1 );
+            for( unsigned ii = 0; ii < _send_rows.size(); ++ii )
+               send_sizes[ii] = _local.row_size( _send_rows[ii] );
+            {
+               mpi::requests reqs;
+               _vct.iscatter<index>( send_sizes.data(), send_row_displs,
+                                     ghost_displs.data(), recv_row_displs,
+                                     MPI_MAP_TYPE( index ), reqs );
+               reqs.wait_all();
+            }
+
+            // Element displacements for the value exchange.
+            _send_displs.resize( nbrs.size() + 1 );
+            _recv_displs.resize( nbrs.size() + 1 );
+            _send_displs[0] = 0;
+            for( unsigned ii = 0; ii < nbrs.size(); ++ii )
+            {
+               index sum = 0;
+               for( index jj = send_row_displs[ii]; jj < send_row_displs[ii + 1]; ++jj )
+                  sum += send_sizes[jj];
+               _send_displs[ii + 1] = _send_displs[ii] + sum;
+            }
+            _send_buf.resize( _send_displs.back() );
+
+            // Prepare the ghost csr.
+            if( _ghost_rows.size() )
+            {
+               vector<index> displs( _ghost_rows.size() + 1 );
+               std::copy( ghost_displs.begin(), ghost_displs.end(), displs.begin() );
+               _ghosts.take_displs( displs );
+               _ghosts.setup_array( true );
+               for( unsigned ii = 0; ii <= nbrs.size(); ++ii )
+                  _recv_displs[ii] = _ghosts.displs()[recv_row_displs[ii]];
+            }
+            else
+               std::fill( _recv_displs.begin(), _recv_displs.end(), 0 );
+
+            update_ghosts();
+         }
+
+         ///
+         /// Begin refreshing ghost values from their owners. The
+         /// exchange completes when `reqs` are waited on.
+         ///
+         void
+         iupdate_ghosts( mpi::requests& reqs,
+                         int tag = 0 )
+         {
+            T* buf = _send_buf.data();
+            for( std::vector<index>::const_iterator it = _send_rows.begin(); it != _send_rows.end(); ++it )
+               buf = std::copy( _local[*it].begin(), _local[*it].end(), buf );
+            _vct.iscatter<index>( _send_buf.data(), _send_displs,
+                                  _ghosts.mod_array().data(), _recv_displs,
+                                  MPI_MAP_TYPE( T ), reqs, 1, tag );
+         }
+
+         void
+         update_ghosts( int tag = 0 )
+         {
+            mpi::requests reqs;
+            iupdate_ghosts( reqs, tag );
+            reqs.wait_all();
+         }
+
+      protected:
+
+         void
+         _clear_schedule()
+         {
+            _ghosts.deallocate();
+            _vct.clear();
+            hpc::deallocate( _ghost_rows );
+            hpc::deallocate( _send_rows );
+            hpc::deallocate( _send_displs );
+            hpc::deallocate( _recv_displs );
+            _send_buf.deallocate();
+         }
+
+      protected:
+
+         mpi::comm const* _comm;
+         csr<T> _local;
+         csr<T> _ghosts;
+         std::vector<index> _row_displs;
+         std::vector<index> _ghost_rows;
+         std::vector<index> _send_rows;
+         std::vector<index> _send_displs;
+         std::vector<index> _recv_displs;
+         vector<T> _send_buf;
+         mpi::vct _vct;
+      };
+
+   }
+}
+
+#endif
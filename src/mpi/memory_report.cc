@@ -0,0 +1,93 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <set>
+#include <algorithm>
+#include "libhpc/system/view.hh"
+#include "memory_report.hh"
+
+namespace hpc {
+   namespace mpi {
+
+      std::vector<memory_summary>
+      memory_report( std::vector<memory::group_report> const& local,
+                     mpi::comm const& comm )
+      {
+         // Share paths as null terminated strings to find the union.
+         std::vector<char> names;
+         for( unsigned ii = 0; ii < local.size(); ++ii )
+         {
+            names.insert( names.end(), local[ii].path.begin(), local[ii].path.end() );
+            names.push_back( 0 );
+         }
+         names = comm.all_gatherv( names );
+         std::set<std::string> union_set;
+         for( std::vector<char>::iterator it = names.begin(); it != names.end(); )
+         {
+            std::vector<char>::iterator fin = std::find( it, names.end(), 0 );
+            union_set.insert( std::string( it, fin ) );
+            it = fin + 1;
+         }
+         std::vector<std::string> paths( union_set.begin(), union_set.end() );
+
+         // Line up local values with the union, four per path.
+         unsigned num = paths.size();
+         std::vector<unsigned long> sums( 4*num, 0 );
+         for( unsigned ii = 0; ii < local.size(); ++ii )
+         {
+            unsigned jj = std::lower_bound( paths.begin(), paths.end(), local[ii].path ) - paths.begin();
+            sums[4*jj + 0] = local[ii].size;
+            sums[4*jj + 1] = local[ii].peak;
+            sums[4*jj + 2] = local[ii].count;
+            sums[4*jj + 3] = local[ii].total;
+         }
+         std::vector<unsigned long> maxs( sums );
+         comm.all_reduce( view<std::vector<unsigned long> >( sums ), MPI_SUM );
+         comm.all_reduce( view<std::vector<unsigned long> >( maxs ), MPI_MAX );
+
+         std::vector<memory_summary> res( num );
+         for( unsigned ii = 0; ii < num; ++ii )
+         {
+            res[ii].path = paths[ii];
+            res[ii].size_sum = sums[4*ii + 0];
+            res[ii].size_max = maxs[4*ii + 0];
+            res[ii].peak_sum = sums[4*ii + 1];
+            res[ii].peak_max = maxs[4*ii + 1];
+            res[ii].count = sums[4*ii + 2];
+            res[ii].total = sums[4*ii + 3];
+         }
+         return res;
+      }
+
+      std::vector<memory_summary>
+      memory_report( mpi::comm const& comm )
+      {
+         return memory_report( memory::report(), comm );
+      }
+
+      std::ostream&
+      operator<<( std::ostream& strm,
+                  memory_summary const& obj )
+      {
+         strm << obj.path << ": size " << obj.size_sum << " (max " << obj.size_max
+              << "), peak " << obj.peak_sum << " (max " << obj.peak_max
+              << "), count " << obj.count << ", total " << obj.total;
+         return strm;
+      }
+
+   }
+}
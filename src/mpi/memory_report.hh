@@ -0,0 +1,68 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_mpi_memory_report_hh
+#define libhpc_mpi_memory_report_hh
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "libhpc/memory/report.hh"
+#include "comm.hh"
+
+namespace hpc {
+   namespace mpi {
+
+      ///
+      /// Memory group statistics combined over the ranks of a
+      /// communicator: the sum and the largest single-rank value of
+      /// the current and peak bytes, and summed allocation counts.
+      ///
+      struct memory_summary
+      {
+         std::string path;
+         size_t size_sum;
+         size_t size_max;
+         size_t peak_sum;
+         size_t peak_max;
+         size_t count;
+         size_t total;
+      };
+
+      ///
+      /// Reduce per-rank memory reports. Ranks may have different
+      /// groups; the result covers the union of paths, sorted, and is
+      /// the same on every rank. Collective.
+      ///
+      std::vector<memory_summary>
+      memory_report( std::vector<memory::group_report> const& local,
+                     mpi::comm const& comm = mpi::comm::world );
+
+      ///
+      /// Reduce this rank's `memory::report()`. Collective.
+      ///
+      std::vector<memory_summary>
+      memory_report( mpi::comm const& comm = mpi::comm::world );
+
+      std::ostream&
+      operator<<( std::ostream& strm,
+                  memory_summary const& obj );
+
+   }
+}
+
+#endif
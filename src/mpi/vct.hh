@@ -189,7 +189,7 @@ namespace hpc {
 
          template< class Index >
 	 void
-	 iscatter( void* out,
+	 iscatter( void const* out,
                    view<std::vector<Index> > const& out_displs,
                    void* inc,
                    view<std::vector<Index> > inc_displs,
@@ -267,21 +267,29 @@ namespace hpc {
             iscatter<T,Index>( out, out_displs, inc, inc_displs, reqs, tag );
          }
 
+         ///
+         /// Scatter, sizing the incoming arrays to suit. The incoming
+         /// vectors may use any allocator, such as a
+         /// memory::arena_allocator for per-step temporaries.
+         ///
          template< class T,
-                   class Index >
+                   class Index,
+                   class Alloc,
+                   class IndexAlloc >
          void
          scattera( view<std::vector<T> > const& out,
                    view<std::vector<Index> > const& out_displs,
-                   std::vector<T>& inc,
-                   std::vector<Index>& inc_displs,
+                   std::vector<T,Alloc>& inc,
+                   std::vector<Index,IndexAlloc>& inc_displs,
                    int tag = 0 ) const
          {
 	    if( _nbrs.size() )
 	    {
 	       inc_displs.resize( _nbrs.size() + 1 );
-	       scatter_displs<Index>( out_displs, inc_displs );
+	       view<std::vector<Index> > inc_displs_view( inc_displs.data(), inc_displs.size() );
+	       scatter_displs<Index>( out_displs, inc_displs_view );
 	       inc.resize( inc_displs.back() );
-	       scatter<T,Index>( out, out_displs, inc, inc_displs, tag );
+	       scatter<T,Index>( out, out_displs, view<std::vector<T> >( inc.data(), inc.size() ), inc_displs_view, tag );
 	    }
 	    else
 	    {
@@ -330,10 +338,10 @@ namespace hpc {
 	    ASSERT( out.size() == inc.size() );
 	    if( out.size() > 1 )
             {
-	       hpc::displs_to_counts<view_type>( (view_type&)out );
+	       hpc::displs_to_counts( ((view_type&)out).begin(), out.size() );
 	       scatter<DisplType>( view_type( out, out.size() - 1 ), view_type( inc, inc.size() - 1 ) );
-	       hpc::counts_to_displs<view_type>( (view_type&)out );
-	       hpc::counts_to_displs<view_type>( inc );
+	       hpc::counts_to_displs( ((view_type&)out).begin(), out.size() - 1 );
+	       hpc::counts_to_displs( inc.begin(), inc.size() - 1 );
 	    }
 	 }
 
@@ -27,6 +27,8 @@
 #include "system/daemon.hh"
 #include "system/path_finder.hh"
 #include "system/tmpfile.hh"
+#include "system/mapped_file.hh"
+#include "system/mirrored_memory.hh"
 #include "system/view.hh"
 #include "system/matrix.hh"
 #include "system/has.hh"
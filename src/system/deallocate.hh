@@ -31,11 +31,12 @@
 
 namespace hpc {
 
-   template< class T >
+   template< class T,
+             class Alloc >
    void
-   deallocate( std::vector<T>& tgt )
+   deallocate( std::vector<T,Alloc>& tgt )
    {
-      std::vector<T> tmp;
+      std::vector<T,Alloc> tmp( tgt.get_allocator() );
       tgt.swap( tmp );
    }
 
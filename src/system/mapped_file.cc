@@ -0,0 +1,103 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include "mapped_file.hh"
+
+namespace hpc {
+
+   mapped_file::mapped_file()
+      : _ptr( 0 ),
+        _size( 0 )
+   {
+   }
+
+   mapped_file::mapped_file( fs::path const& path )
+      : _ptr( 0 ),
+        _size( 0 )
+   {
+      open( path );
+   }
+
+   mapped_file::~mapped_file()
+   {
+      close();
+   }
+
+   void
+   mapped_file::open( fs::path const& path )
+   {
+      close();
+
+      int fd = ::open( path.c_str(), O_RDONLY );
+      EXCEPT( fd >= 0, "Failed to open file for mapping: ", path, ": ", strerror( errno ) );
+      struct stat st;
+      if( fstat( fd, &st ) != 0 )
+      {
+         ::close( fd );
+         EXCEPT( 0, "Failed to stat file for mapping: ", path, ": ", strerror( errno ) );
+      }
+
+      // Zero sized mappings are not permitted, leave empty files
+      // unmapped.
+      if( st.st_size )
+      {
+         void* ptr = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+         ::close( fd );
+         EXCEPT( ptr != MAP_FAILED, "Failed to map file: ", path, ": ", strerror( errno ) );
+         _ptr = ptr;
+         _size = st.st_size;
+      }
+      else
+         ::close( fd );
+   }
+
+   void
+   mapped_file::close()
+   {
+      if( _ptr )
+      {
+         INSIST( munmap( _ptr, _size ), == 0 );
+         _ptr = 0;
+         _size = 0;
+      }
+   }
+
+   bool
+   mapped_file::is_open() const
+   {
+      return _ptr != 0;
+   }
+
+   void const*
+   mapped_file::data() const
+   {
+      return _ptr;
+   }
+
+   size_t
+   mapped_file::size() const
+   {
+      return _size;
+   }
+
+}
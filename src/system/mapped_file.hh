@@ -0,0 +1,90 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_system_mapped_file_hh
+#define libhpc_system_mapped_file_hh
+
+#include <stddef.h>
+#include <boost/filesystem.hpp>
+#include <boost/move/move.hpp>
+#include "libhpc/debug.hh"
+#include "filesystem.hh"
+
+namespace hpc {
+
+   ///
+   /// Read-only memory mapping of an entire file. The mapping is
+   /// shared, so pages come straight from the page cache and no copy
+   /// is made.
+   ///
+   class mapped_file
+   {
+      BOOST_MOVABLE_BUT_NOT_COPYABLE( mapped_file );
+
+   public:
+
+      mapped_file();
+
+      mapped_file( fs::path const& path );
+
+      inline
+      mapped_file( BOOST_RV_REF( mapped_file ) src )
+         : _ptr( src._ptr ),
+           _size( src._size )
+      {
+         src._ptr = 0;
+         src._size = 0;
+      }
+
+      ~mapped_file();
+
+      inline
+      mapped_file&
+      operator=( BOOST_RV_REF( mapped_file ) src )
+      {
+         close();
+         _ptr = src._ptr;
+         _size = src._size;
+         src._ptr = 0;
+         src._size = 0;
+         return *this;
+      }
+
+      void
+      open( fs::path const& path );
+
+      void
+      close();
+
+      bool
+      is_open() const;
+
+      void const*
+      data() const;
+
+      size_t
+      size() const;
+
+   protected:
+
+      void* _ptr;
+      size_t _size;
+   };
+
+}
+
+#endif
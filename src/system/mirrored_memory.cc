@@ -0,0 +1,116 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include "mirrored_memory.hh"
+
+namespace hpc {
+
+   mirrored_memory::mirrored_memory()
+      : _ptr( 0 ),
+        _size( 0 )
+   {
+   }
+
+   mirrored_memory::mirrored_memory( size_t size )
+      : _ptr( 0 ),
+        _size( 0 )
+   {
+      allocate( size );
+   }
+
+   mirrored_memory::~mirrored_memory()
+   {
+      release();
+   }
+
+   void
+   mirrored_memory::allocate( size_t size )
+   {
+      release();
+      if( !size )
+         return;
+      EXCEPT( size%page_size() == 0, "Mirrored memory size must be a multiple of the page size: ", size );
+
+      int fd = memfd_create( "libhpc_mirrored_memory", MFD_CLOEXEC );
+      EXCEPT( fd >= 0, "Failed to create memory file: ", strerror( errno ) );
+      if( ftruncate( fd, size ) != 0 )
+      {
+         ::close( fd );
+         EXCEPT( 0, "Failed to size memory file: ", strerror( errno ) );
+      }
+
+      // Reserve the whole range first so nothing else can land
+      // between the two copies, then map the file over each half.
+      char* base = (char*)mmap( 0, 2*size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+      if( base == MAP_FAILED )
+      {
+         ::close( fd );
+         EXCEPT( 0, "Failed to reserve mirrored memory: ", strerror( errno ) );
+      }
+      for( unsigned ii = 0; ii < 2; ++ii )
+      {
+         void* ptr = mmap( base + ii*size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 );
+         if( ptr == MAP_FAILED )
+         {
+            int err = errno;
+            munmap( base, 2*size );
+            ::close( fd );
+            EXCEPT( 0, "Failed to map mirrored memory: ", strerror( err ) );
+         }
+      }
+
+      // The mappings keep the pages alive.
+      ::close( fd );
+      _ptr = base;
+      _size = size;
+   }
+
+   void
+   mirrored_memory::release()
+   {
+      if( _ptr )
+      {
+         INSIST( munmap( _ptr, 2*_size ), == 0 );
+         _ptr = 0;
+         _size = 0;
+      }
+   }
+
+   void*
+   mirrored_memory::data() const
+   {
+      return _ptr;
+   }
+
+   size_t
+   mirrored_memory::size() const
+   {
+      return _size;
+   }
+
+   size_t
+   mirrored_memory::page_size()
+   {
+      static size_t size = sysconf( _SC_PAGESIZE );
+      return size;
+   }
+
+}
@@ -0,0 +1,96 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef libhpc_system_mirrored_memory_hh
+#define libhpc_system_mirrored_memory_hh
+
+#include <stddef.h>
+#include <boost/move/move.hpp>
+#include "libhpc/debug.hh"
+
+namespace hpc {
+
+   ///
+   /// Anonymous memory mapped twice, back to back, so that address
+   /// `data() + ii + size()` aliases `data() + ii`. Anything that
+   /// wraps past the end of the first copy is contiguous in memory.
+   ///
+   /// The pages come from a memfd, mapped shared at both addresses
+   /// inside a single reserved range. Sizes must be a multiple of the
+   /// page size.
+   ///
+   class mirrored_memory
+   {
+      BOOST_MOVABLE_BUT_NOT_COPYABLE( mirrored_memory );
+
+   public:
+
+      mirrored_memory();
+
+      mirrored_memory( size_t size );
+
+      inline
+      mirrored_memory( BOOST_RV_REF( mirrored_memory ) src )
+         : _ptr( src._ptr ),
+           _size( src._size )
+      {
+         src._ptr = 0;
+         src._size = 0;
+      }
+
+      ~mirrored_memory();
+
+      inline
+      mirrored_memory&
+      operator=( BOOST_RV_REF( mirrored_memory ) src )
+      {
+         release();
+         _ptr = src._ptr;
+         _size = src._size;
+         src._ptr = 0;
+         src._size = 0;
+         return *this;
+      }
+
+      void
+      allocate( size_t size );
+
+      void
+      release();
+
+      void*
+      data() const;
+
+      ///
+      /// Size of one copy.
+      ///
+      size_t
+      size() const;
+
+      static
+      size_t
+      page_size();
+
+   protected:
+
+      void* _ptr;
+      size_t _size;
+   };
+
+}
+
+#endif
@@ -19,6 +19,9 @@
 #define hpc_system_reallocate_hh
 
 #include "cc_version.hh"
+#ifdef CXX_0X
+#include "libhpc/memory/placement.hh"
+#endif
 
 namespace hpc {
 
@@ -30,7 +33,22 @@ namespace hpc {
    reallocate( std::vector<T,Args...>& obj,
                typename std::vector<T,Args...>::size_type size )
    {
-      std::vector<T,Args...> tmp;
+      std::vector<T,Args...> tmp( obj.get_allocator() );
+      obj.swap( tmp );
+      obj.resize( size );
+   }
+
+   ///
+   /// Reallocate with a new placement policy. Large buffers get fresh
+   /// pages placed according to `place`; see memory::placement.
+   ///
+   template< class T >
+   void
+   reallocate( std::vector<T,memory::placed_allocator<T> >& obj,
+               typename std::vector<T,memory::placed_allocator<T> >::size_type size,
+               const memory::placement& place )
+   {
+      std::vector<T,memory::placed_allocator<T> > tmp( (memory::placed_allocator<T>( place )) );
       obj.swap( tmp );
       obj.resize( size );
    }
@@ -0,0 +1,128 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdint.h>
+#include <libhpc/unit_test/main.hh>
+#include <libhpc/algorithm/permute.hh>
+#include <libhpc/algorithm/reorder.hh>
+#include <libhpc/system/random.hh>
+
+TEST_CASE( "/libhpc/algorithm/permute/sort_permutation" )
+{
+   std::vector<int> ints( 5000 );
+   std::vector<double> reals( ints.size() );
+   for( unsigned ii = 0; ii < ints.size(); ++ii )
+   {
+      ints[ii] = hpc::generate_uniform<int>( -50, 50 );
+      reals[ii] = ints[ii];
+   }
+   std::vector<long> int_perm = hpc::sort_permutation( ints );
+   std::vector<long> real_perm = hpc::sort_permutation( reals );
+
+   // Both are stable, so they agree.
+   TEST( int_perm == real_perm );
+   for( unsigned ii = 1; ii < ints.size(); ++ii )
+   {
+      TEST( ints[int_perm[ii - 1]] <= ints[int_perm[ii]] );
+      if( ints[int_perm[ii - 1]] == ints[int_perm[ii]] )
+         TEST( int_perm[ii - 1] < int_perm[ii] );
+   }
+}
+
+TEST_CASE( "/libhpc/algorithm/permute/sort_permutation_wide" )
+{
+   // Too wide to radix sort, and bool is never radix sorted; both
+   // must still be stable.
+   std::vector<uint64_t> wide( 5000 );
+   bool flags[5000];
+   for( unsigned ii = 0; ii < wide.size(); ++ii )
+   {
+      wide[ii] = ((uint64_t)hpc::generate_uniform<unsigned>( 0, 3 ) << 60) + hpc::generate_uniform<unsigned>( 0, 3 );
+      flags[ii] = (ii%3 == 0);
+   }
+   std::vector<long> perm = hpc::sort_permutation( wide );
+   for( unsigned ii = 1; ii < wide.size(); ++ii )
+   {
+      TEST( wide[perm[ii - 1]] <= wide[perm[ii]] );
+      if( wide[perm[ii - 1]] == wide[perm[ii]] )
+         TEST( perm[ii - 1] < perm[ii] );
+   }
+
+   std::vector<long> flag_perm( wide.size() );
+   hpc::sort_permutation( flags + 0, flags + wide.size(), flag_perm.begin() );
+   for( unsigned ii = 1; ii < wide.size(); ++ii )
+   {
+      TEST( flags[flag_perm[ii - 1]] <= flags[flag_perm[ii]] );
+      if( flags[flag_perm[ii - 1]] == flags[flag_perm[ii]] )
+         TEST( flag_perm[ii - 1] < flag_perm[ii] );
+   }
+}
+
+TEST_CASE( "/libhpc/algorithm/permute/permute" )
+{
+   std::vector<unsigned> keys( 20000 );
+   std::vector<long> idxs( keys.size() );
+   std::vector<float> attr( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = hpc::generate_uniform<unsigned>( 0, 100000 );
+      idxs[ii] = ii;
+      attr[ii] = 0.5f*ii;
+   }
+   std::vector<unsigned> orig( keys );
+   std::vector<long> perm = hpc::sort_permutation( keys );
+   hpc::permute( perm, keys, idxs, attr );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      TEST( idxs[ii] == perm[ii] );
+      TEST( keys[ii] == orig[perm[ii]] );
+      TEST( attr[ii] == 0.5f*perm[ii] );
+   }
+}
+
+TEST_CASE( "/libhpc/algorithm/permute/invert_permutation" )
+{
+   std::vector<long> perm( 1000 ), inv( perm.size() ), back( perm.size() );
+   for( unsigned ii = 0; ii < perm.size(); ++ii )
+      perm[ii] = (ii*337)%perm.size();
+   hpc::invert_permutation( perm.begin(), perm.end(), inv.begin() );
+   hpc::invert_permutation( inv.begin(), inv.end(), back.begin() );
+   TEST( back == perm );
+   for( unsigned ii = 0; ii < perm.size(); ++ii )
+      TEST( inv[perm[ii]] == ii );
+}
+
+TEST_CASE( "/libhpc/algorithm/permute/in_place" )
+{
+   // Sorting in place takes the scatter form of the permutation.
+   std::vector<int> keys( 3000 );
+   std::vector<double> attr( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = hpc::generate_uniform<int>( 0, 1000 );
+      attr[ii] = keys[ii] + 0.5;
+   }
+   std::vector<long> perm = hpc::sort_permutation( keys ), inv( keys.size() );
+   hpc::invert_permutation( perm.begin(), perm.end(), inv.begin() );
+   hpc::reorder_arrays( inv.begin(), inv.end(), keys.begin(), attr.begin() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      TEST( attr[ii] == keys[ii] + 0.5 );
+      if( ii )
+         TEST( keys[ii - 1] <= keys[ii] );
+   }
+}
@@ -0,0 +1,174 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdint.h>
+#include <libhpc/unit_test/main.hh>
+#include <libhpc/algorithm/radix_sort.hh>
+#include <libhpc/algorithm/sort_by_key.hh>
+#include <libhpc/system/random.hh>
+
+template< class Key >
+bool
+check_sorted( std::vector<Key> const& orig,
+              std::vector<Key> const& keys,
+              std::vector<long> const& vals )
+{
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      if( orig[vals[ii]] != keys[ii] )
+         return false;
+      if( ii && (keys[ii - 1] > keys[ii] || (keys[ii - 1] == keys[ii] && vals[ii - 1] >= vals[ii])) )
+         return false;
+   }
+   return true;
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/unsigned" )
+{
+   for( unsigned size = 0; size < 200000; size = 3*size + 1 )
+   {
+      std::vector<uint64_t> keys( size ), orig;
+      std::vector<long> vals( size );
+      for( unsigned ii = 0; ii < size; ++ii )
+      {
+         keys[ii] = ((uint64_t)hpc::generate_uniform<unsigned>( 0, 1000000 ) << 32) + hpc::generate_uniform<unsigned>( 0, 1000 );
+         vals[ii] = ii;
+      }
+      orig = keys;
+      hpc::radix_sort_by_key( keys, vals );
+      bool ok = check_sorted( orig, keys, vals );
+      TEST( ok == true );
+   }
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/signed" )
+{
+   std::vector<int> keys( 50000 ), orig;
+   std::vector<long> vals( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = hpc::generate_uniform<int>( -100, 100 );
+      vals[ii] = ii;
+   }
+   orig = keys;
+   hpc::radix_sort_by_key( keys, vals );
+   bool ok = check_sorted( orig, keys, vals );
+   TEST( ok == true );
+   TEST( keys.front() == -100 );
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/digits" )
+{
+   for( unsigned bits = 1; bits <= 16; bits += 5 )
+   {
+      std::vector<long> keys( 1000 ), orig;
+      std::vector<long> vals( keys.size() );
+      for( unsigned ii = 0; ii < keys.size(); ++ii )
+      {
+         keys[ii] = (long)hpc::generate_uniform<int>( -1000000000, 1000000000 )*1000;
+         vals[ii] = ii;
+      }
+      orig = keys;
+      hpc::radix_sort_by_key( keys.begin(), keys.end(), vals.begin(), bits );
+      bool ok = check_sorted( orig, keys, vals );
+      TEST( ok == true );
+   }
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/sort_by_key" )
+{
+   std::vector<unsigned> keys( 5000 ), orig;
+   std::vector<long> vals( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = hpc::generate_uniform<unsigned>( 0, 50 );
+      vals[ii] = ii;
+   }
+   orig = keys;
+   hpc::sort_by_key( keys, vals );
+   bool ok = check_sorted( orig, keys, vals );
+   TEST( ok == true );
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/constant" )
+{
+   std::vector<uint64_t> keys( 3000, (uint64_t)7 << 40 );
+   std::vector<long> vals( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+      vals[ii] = ii;
+   keys[1000] = (uint64_t)5 << 40;
+   std::vector<uint64_t> orig( keys );
+   hpc::radix_sort_by_key( keys, vals );
+   bool ok = check_sorted( orig, keys, vals );
+   TEST( ok == true );
+   TEST( vals[0] == 1000 );
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/sort_by_key_wide" )
+{
+   std::vector<uint64_t> keys( 5000 ), orig;
+   std::vector<long> vals( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = ((uint64_t)hpc::generate_uniform<unsigned>( 0, 1000000 ) << 40) + hpc::generate_uniform<unsigned>( 0, 50 );
+      vals[ii] = ii;
+   }
+   orig = keys;
+   hpc::sort_by_key( keys, vals );
+   bool ok = true;
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      if( orig[vals[ii]] != keys[ii] || (ii && keys[ii - 1] > keys[ii]) )
+         ok = false;
+   }
+   TEST( ok == true );
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/sort_by_key_signed_range" )
+{
+   std::vector<int64_t> keys( 5000 ), orig;
+   std::vector<long> vals( keys.size() );
+   for( unsigned ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = (int64_t)hpc::generate_uniform<int>( 0, 100000 ) - 50000;
+      vals[ii] = ii;
+   }
+   orig = keys;
+   TEST( hpc::impl::use_radix_sort( keys.begin(), keys.end() ) == true );
+   hpc::sort_by_key( keys, vals );
+   bool ok = check_sorted( orig, keys, vals );
+   TEST( ok == true );
+}
+
+TEST_CASE( "/libhpc/algorithm/radix_sort/sort_by_key_bool" )
+{
+   bool keys[2000];
+   long vals[2000];
+   for( unsigned ii = 0; ii < 2000; ++ii )
+   {
+      keys[ii] = (ii%3 == 0);
+      vals[ii] = ii;
+   }
+   hpc::sort_by_key( keys + 0, keys + 2000, vals + 0, vals + 2000 );
+   bool ok = true;
+   for( unsigned ii = 0; ii < 2000; ++ii )
+   {
+      if( keys[ii] != (vals[ii]%3 == 0) || keys[ii] != (ii >= 1333) )
+         ok = false;
+   }
+   TEST( ok == true );
+}
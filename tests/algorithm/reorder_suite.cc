@@ -37,3 +37,32 @@ TEST_CASE( "/libhpc/algorithm/reorder" )
          TEST( data[order[ii]] == ii );
    }
 }
+
+TEST_CASE( "/libhpc/algorithm/reorder_arrays" )
+{
+   std::vector<int> data( 100 ), order( 100 );
+   std::vector<double> other( 100 );
+   std::iota( order.begin(), order.end(), 0 );
+   for( unsigned ii = 0; ii < 1000; ++ii )
+   {
+      int a = hpc::generate_uniform<int>( 0, 99 );
+      int b = hpc::generate_uniform<int>( 0, 99 );
+      std::swap( order[a], order[b] );
+   }
+   for( unsigned jj = 0; jj < 2; ++jj )
+   {
+      std::iota( data.begin(), data.end(), 0 );
+      for( unsigned ii = 0; ii < other.size(); ++ii )
+         other[ii] = 2.0*ii;
+      hpc::reorder_arrays( order.begin(), order.end(), data.begin(), other.begin() );
+      for( unsigned ii = 0; ii < order.size(); ++ii )
+      {
+         TEST( data[order[ii]] == ii );
+         TEST( other[order[ii]] == 2.0*ii );
+      }
+
+      // A single long cycle.
+      for( unsigned ii = 0; ii < order.size(); ++ii )
+         order[ii] = (ii + 1)%order.size();
+   }
+}
@@ -0,0 +1,133 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdint.h>
+#include <libhpc/unit_test/main_mpi.hh>
+#include <libhpc/algorithm/sample_sort.hh>
+
+typedef hpc::mpi::comm comm;
+
+SUITE_PREFIX( "/hpc/algorithm/sample_sort/" );
+
+namespace {
+
+   // Check global order and exactly even counts.
+   template< class Key >
+   bool
+   sorted_evenly( std::vector<Key> const& keys,
+                  long size )
+   {
+      int rank = comm::world.rank(), num_ranks = comm::world.size();
+      long expected = size/num_ranks + ((rank < size%num_ranks) ? 1 : 0);
+      std::vector<Key> all = comm::world.all_gatherv( keys );
+      return (long)keys.size() == expected && std::is_sorted( all.begin(), all.end() );
+   }
+
+}
+
+TEST_CASE( "keys" )
+{
+   int rank = comm::world.rank();
+   std::vector<uint64_t> keys( 1000 + 337*rank );
+   uint64_t sum = 0;
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = ((ii + 7919*rank)*2654435761UL)%100003;
+      sum += keys[ii];
+   }
+   long size = comm::world.all_reduce( (long)keys.size() );
+   uint64_t total = comm::world.all_reduce( sum );
+
+   hpc::sample_sort( keys );
+   bool sorted = sorted_evenly( keys, size );
+   TEST( sorted == true );
+   uint64_t new_sum = 0;
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+      new_sum += keys[ii];
+   new_sum = comm::world.all_reduce( new_sum );
+   TEST( new_sum == total );
+}
+
+TEST_CASE( "empty ranks" )
+{
+   std::vector<int> keys;
+   if( comm::world.rank() == comm::world.size() - 1 )
+   {
+      keys.push_back( 3 );
+      keys.push_back( 1 );
+   }
+   hpc::sample_sort( keys );
+   bool sorted = sorted_evenly( keys, 2 );
+   TEST( sorted == true );
+}
+
+TEST_CASE( "stable pairs" )
+{
+   int rank = comm::world.rank();
+   std::vector<int> keys( 2000 );
+   std::vector<long> values( keys.size() );
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      keys[ii] = (ii*(rank + 3))%5;
+      values[ii] = 100000*rank + ii;
+   }
+   long size = comm::world.all_reduce( (long)keys.size() );
+
+   hpc::sample_sort( keys, values, comm::world, true );
+   bool sorted = sorted_evenly( keys, size );
+   TEST( sorted == true );
+   TEST( values.size() == keys.size() );
+
+   // Values still match their keys, and equal keys are in original
+   // rank then index order.
+   std::vector<int> all_keys = comm::world.all_gatherv( keys );
+   std::vector<long> all_values = comm::world.all_gatherv( values );
+   bool match = true, stable = true;
+   for( size_t ii = 0; ii < all_keys.size(); ++ii )
+   {
+      long src_rank = all_values[ii]/100000, src_idx = all_values[ii]%100000;
+      if( all_keys[ii] != (int)((src_idx*(src_rank + 3))%5) )
+         match = false;
+      if( ii && all_keys[ii] == all_keys[ii - 1] && all_values[ii] < all_values[ii - 1] )
+         stable = false;
+   }
+   TEST( match == true );
+   TEST( stable == true );
+}
+
+TEST_CASE( "unstable pairs" )
+{
+   int rank = comm::world.rank();
+   std::vector<double> keys( 500 );
+   std::vector<int> values( keys.size() );
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      values[ii] = ii + 1000*rank;
+      keys[ii] = 0.5*values[ii];
+   }
+   long size = comm::world.all_reduce( (long)keys.size() );
+   hpc::sample_sort( keys, values );
+   bool sorted = sorted_evenly( keys, size );
+   TEST( sorted == true );
+   bool match = true;
+   for( size_t ii = 0; ii < keys.size(); ++ii )
+   {
+      if( keys[ii] != 0.5*values[ii] )
+         match = false;
+   }
+   TEST( match == true );
+}
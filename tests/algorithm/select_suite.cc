@@ -15,6 +15,7 @@
 // You should have received a copy of the GNU General Public License
 // along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <math.h>
 #include <boost/range/algorithm_ext/iota.hpp>
 #include <libhpc/unit_test/main_mpi.hh>
 #include <libhpc/algorithm/select.hh>
@@ -47,3 +48,101 @@ TEST_CASE( "7th" )
    TEST( x >= 6.0 );
    TEST( x <= 7.0 );
 }
+
+TEST_CASE( "integer duplicates" )
+{
+   std::vector<int> values( 1000 );
+   for( unsigned ii = 0; ii < values.size(); ++ii )
+      values[ii] = (ii*(comm::world.rank() + 3))%17;
+   std::vector<int> all = comm::world.all_gatherv( values );
+   std::sort( all.begin(), all.end() );
+   for( long pos = 0; pos < (long)all.size(); pos += 97 )
+   {
+      unsigned rounds;
+      int x = hpc::select( values.begin(), values.end(), pos, comm::world, &rounds, 64 );
+      TEST( x == all[pos] );
+   }
+}
+
+TEST_CASE( "equal values" )
+{
+   std::vector<long> values( 500, 5 );
+   unsigned rounds;
+   long x = hpc::select( values.begin(), values.end(), 123, comm::world, &rounds, 64 );
+   TEST( x == 5 );
+   TEST( rounds == 1 );
+}
+
+TEST_CASE( "rounds" )
+{
+   std::vector<double> values( 20000 );
+   for( unsigned ii = 0; ii < values.size(); ++ii )
+      values[ii] = sin( 1e-3*ii*(comm::world.rank() + 1) + comm::world.rank() );
+   std::vector<double> all = comm::world.all_gatherv( values );
+   std::sort( all.begin(), all.end() );
+   long pos = all.size()/3;
+   unsigned rounds;
+   double x = hpc::select( values.begin(), values.end(), pos, comm::world, &rounds, 256 );
+   TEST( x == all[pos] );
+   TEST( rounds > 0 );
+   TEST( rounds < 10 );
+}
+
+TEST_CASE( "empty rank" )
+{
+   std::vector<unsigned> values;
+   if( comm::world.rank() != 0 || comm::world.size() == 1 )
+   {
+      values.resize( 3000 );
+      for( unsigned ii = 0; ii < values.size(); ++ii )
+         values[ii] = (ii*7919)%3001;
+   }
+   std::vector<unsigned> all = comm::world.all_gatherv( values );
+   std::sort( all.begin(), all.end() );
+   unsigned x = hpc::select( values.begin(), values.end(), all.size() - 1, comm::world, 0, 128 );
+   TEST( x == all.back() );
+}
+
+TEST_CASE( "many" )
+{
+   std::vector<long> values( 5000 );
+   for( unsigned ii = 0; ii < values.size(); ++ii )
+      values[ii] = ((ii + 1000*comm::world.rank())*2654435761UL)%2000;
+   std::vector<long> all = comm::world.all_gatherv( values );
+   std::sort( all.begin(), all.end() );
+
+   // Unordered and repeated positions, including both ends.
+   std::vector<long> pos;
+   pos.push_back( all.size() - 1 );
+   for( long ii = 0; ii < (long)all.size(); ii += 313 )
+      pos.push_back( ii );
+   pos.push_back( 0 );
+   pos.push_back( all.size()/2 );
+   pos.push_back( all.size()/2 );
+
+   unsigned rounds;
+   std::vector<long> x = hpc::select_many( values.begin(), values.end(), pos, comm::world, &rounds, 64 );
+   TEST( x.size() == pos.size() );
+   for( unsigned ii = 0; ii < pos.size(); ++ii )
+      TEST( x[ii] == all[pos[ii]] );
+   TEST( rounds > 0 );
+}
+
+TEST_CASE( "many splitters" )
+{
+   std::vector<double> values( 3000 );
+   for( unsigned ii = 0; ii < values.size(); ++ii )
+      values[ii] = sin( 1e-2*ii + comm::world.rank() );
+   long size = comm::world.all_reduce( (long)values.size() );
+   std::vector<long> pos;
+   for( int ii = 1; ii < 4*comm::world.size(); ++ii )
+      pos.push_back( (size*ii)/(4*comm::world.size()) );
+   std::vector<double> x = hpc::select_many( values.begin(), values.end(), pos, comm::world );
+   for( unsigned ii = 0; ii < pos.size(); ++ii )
+   {
+      double y = hpc::select( values.begin(), values.end(), pos[ii] );
+      TEST( x[ii] == y );
+   }
+   std::vector<double> none = hpc::select_many( values.begin(), values.end(), std::vector<long>() );
+   TEST( none.size() == 0 );
+}
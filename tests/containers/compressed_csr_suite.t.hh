@@ -0,0 +1,105 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/compressed_csr.hh"
+#include "libhpc/containers/csr.hh"
+#include "libhpc/containers/vector.hh"
+
+class compressed_csr_suite : public CxxTest::TestSuite {
+public:
+
+   void test_compact_displs_narrow()
+   {
+      hpc::compact_displs displs;
+      displs.set(this->src.displs());
+      TS_ASSERT(!displs.wide());
+      TS_ASSERT_EQUALS(displs.size(), 4);
+      TS_ASSERT_EQUALS(displs.bytes(), 4*sizeof(uint32_t));
+      for(hpc::index ii = 0; ii < displs.size(); ++ii)
+	 TS_ASSERT_EQUALS(displs[ii], this->src.displs()[ii]);
+   }
+
+   void test_compact_displs_wide()
+   {
+      hpc::vector<hpc::index> big(2);
+      big[0] = 0;
+      big[1] = 5000000000L;
+      hpc::compact_displs displs;
+      displs.set(big);
+      TS_ASSERT(displs.wide());
+      TS_ASSERT_EQUALS(displs[1], 5000000000L);
+   }
+
+   void test_compact_csr()
+   {
+      hpc::compact_csr<int> comp(this->src);
+      TS_ASSERT_EQUALS(comp.num_rows(), 3);
+      TS_ASSERT_EQUALS(comp.row_size(0), 2);
+      TS_ASSERT_EQUALS(comp.row_size(1), 1);
+      TS_ASSERT_EQUALS(comp.row_size(2), 3);
+      TS_ASSERT_EQUALS(comp[2][1], 3000);
+      TS_ASSERT_EQUALS(comp(0, 1), 200);
+
+      hpc::csr<int> csr;
+      comp.unpack(csr);
+      TS_ASSERT(csr == this->src);
+   }
+
+   void test_varint_csr()
+   {
+      hpc::varint_csr<int> comp(this->src);
+      TS_ASSERT_EQUALS(comp.num_rows(), 3);
+      TS_ASSERT_EQUALS(comp.size(), 6);
+      for(hpc::index ii = 0; ii < 3; ++ii) {
+	 TS_ASSERT_EQUALS(comp.row_size(ii), this->src.row_size(ii));
+	 TS_ASSERT(std::equal(comp.begin(ii), comp.end(ii), this->src[ii].begin()));
+      }
+      TS_ASSERT(comp.bytes() < this->src.displs().size()*sizeof(hpc::index) + this->src.array().size()*sizeof(int));
+
+      hpc::csr<int> csr;
+      comp.unpack(csr);
+      TS_ASSERT(csr == this->src);
+   }
+
+   void test_varint_csr_empty_row()
+   {
+      hpc::csr<int> src;
+      src.num_rows(2);
+      src.mod_displs()[1] = 0;
+      src.mod_displs()[2] = 1;
+      src.setup_array();
+      src(1, 0) = -7;
+      hpc::varint_csr<int> comp(src);
+      TS_ASSERT_EQUALS(comp.row_size(0), 0);
+      TS_ASSERT(comp.begin(0) == comp.end(0));
+      TS_ASSERT_EQUALS(*comp.begin(1), -7);
+   }
+
+   void setUp()
+   {
+      hpc::vector<hpc::index> displs(4);
+      displs[0] = 0; displs[1] = 2; displs[2] = 3; displs[3] = 6;
+      this->src.copy_displs(displs.begin(), displs.size());
+      this->src.setup_array();
+      this->src(0, 0) = 10; this->src(0, 1) = 200;
+      this->src(1, 0) = 5;
+      this->src(2, 0) = 0; this->src(2, 1) = 3000; this->src(2, 2) = 400000;
+   }
+
+   hpc::csr<int> src;
+};
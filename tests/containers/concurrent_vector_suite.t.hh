@@ -0,0 +1,132 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include <algorithm>
+#include <cxxtest/TestSuite.h>
+#include <boost/thread.hpp>
+#include "libhpc/containers/concurrent_vector.hh"
+
+using namespace hpc;
+
+class concurrent_vector_suite : public CxxTest::TestSuite {
+public:
+
+   void test_push_back()
+   {
+      concurrent_vector<int> vec( 4 );
+      TS_ASSERT( vec.empty() );
+      for( int ii = 0; ii < 100; ++ii )
+         TS_ASSERT_EQUALS( vec.push_back( ii ), ii );
+      TS_ASSERT_EQUALS( vec.size(), 100 );
+      for( int ii = 0; ii < 100; ++ii )
+         TS_ASSERT_EQUALS( vec[ii], ii );
+
+      // Segments of 4, 8, 16, 32 and 64 cover the first 124.
+      TS_ASSERT_EQUALS( vec.capacity(), 124 );
+   }
+
+   void test_stable_addresses()
+   {
+      concurrent_vector<int> vec( 2 );
+      vec.push_back( 1 );
+      int* first = &vec[0];
+      for( int ii = 0; ii < 1000; ++ii )
+         vec.push_back( ii );
+      TS_ASSERT_EQUALS( &vec[0], first );
+      TS_ASSERT_EQUALS( *first, 1 );
+   }
+
+   void test_grow_by()
+   {
+      concurrent_vector<int> vec( 4 );
+      TS_ASSERT_EQUALS( vec.grow_by( 3, 7 ), 0 );
+      TS_ASSERT_EQUALS( vec.grow_by( 10, 8 ), 3 );
+      std::vector<int> src( 20 );
+      for( int ii = 0; ii < 20; ++ii )
+         src[ii] = 100 + ii;
+      TS_ASSERT_EQUALS( vec.grow_by( src.begin(), src.end() ), 13 );
+      TS_ASSERT_EQUALS( vec.size(), 33 );
+      TS_ASSERT_EQUALS( vec[2], 7 );
+      TS_ASSERT_EQUALS( vec[3], 8 );
+      TS_ASSERT_EQUALS( vec[12], 8 );
+      TS_ASSERT( std::equal( src.begin(), src.end(), vec.begin() + 13 ) );
+      TS_ASSERT_EQUALS( vec.end() - vec.begin(), 33 );
+   }
+
+   void test_reserve_clear()
+   {
+      concurrent_vector<int> vec( 16 );
+      vec.reserve( 100 );
+      TS_ASSERT( vec.capacity() >= 100 );
+      TS_ASSERT_EQUALS( vec.size(), 0 );
+      vec.grow_by( 50 );
+      vec.clear();
+      TS_ASSERT_EQUALS( vec.size(), 0 );
+      TS_ASSERT_EQUALS( vec.capacity(), 0 );
+   }
+
+   void test_flatten()
+   {
+      concurrent_vector<long> vec( 8 );
+      for( long ii = 0; ii < 5000; ++ii )
+         vec.push_back( ii );
+      std::vector<long> out = vec.flatten();
+      TS_ASSERT_EQUALS( out.size(), 5000 );
+      for( long ii = 0; ii < 5000; ++ii )
+         TS_ASSERT_EQUALS( out[ii], ii );
+
+      concurrent_vector<long> empty;
+      empty.flatten( out );
+      TS_ASSERT( out.empty() );
+   }
+
+   void test_threads()
+   {
+      concurrent_vector<long> vec( 4 );
+      boost::thread_group threads;
+      for( int ii = 0; ii < num_threads; ++ii )
+         threads.create_thread( boost::bind( &concurrent_vector_suite::append, &vec, ii ) );
+      threads.join_all();
+
+      TS_ASSERT_EQUALS( vec.size(), num_threads*num_values );
+      std::vector<long> out = vec.flatten();
+      std::sort( out.begin(), out.end() );
+      for( long ii = 0; ii < num_threads*num_values; ++ii )
+         TS_ASSERT_EQUALS( out[ii], ii );
+   }
+
+protected:
+
+   static const int num_threads = 4;
+   static const long num_values = 20000;
+
+   static void
+   append( concurrent_vector<long>* vec,
+           int rank )
+   {
+      for( long ii = 0; ii < num_values; ii += 2 )
+      {
+         if( ii%4 )
+            vec->push_back( rank*num_values + ii );
+         else
+            vec->grow_by( 1, rank*num_values + ii );
+         long pair[1] = { rank*num_values + ii + 1 };
+         vec->grow_by( pair, pair + 1 );
+      }
+   }
+};
@@ -0,0 +1,166 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stdlib.h>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/csr_spmv.hh"
+#include "libhpc/containers/csr.hh"
+#include "libhpc/containers/vector.hh"
+
+class csr_spmv_suite : public CxxTest::TestSuite {
+public:
+
+   void test_balanced_row()
+   {
+      hpc::vector<hpc::index> displs(5);
+      displs[0] = 0; displs[1] = 1; displs[2] = 2; displs[3] = 10; displs[4] = 12;
+      TS_ASSERT_EQUALS(hpc::balanced_row(displs, 0, 2), 0);
+      TS_ASSERT_EQUALS(hpc::balanced_row(displs, 1, 2), 3);
+      TS_ASSERT_EQUALS(hpc::balanced_row(displs, 2, 2), 4);
+      TS_ASSERT_EQUALS(hpc::balanced_row(displs, 3, 4), 3);
+   }
+
+   void test_spmv_double()
+   {
+      this->_check_spmv<double>(1e-10);
+   }
+
+   void test_spmv_float()
+   {
+      this->_check_spmv<float>(1e-3);
+   }
+
+   void test_spmv_int()
+   {
+      hpc::vector<int> x(this->num_cols), y(this->num_rows), ref(this->num_rows);
+      for(hpc::index ii = 0; ii < this->num_cols; ++ii)
+	 x[ii] = ii%7 - 3;
+      hpc::csr<int> vals;
+      this->_values(vals);
+      this->_reference(vals, x.data(), ref.data(), 1);
+      hpc::spmv(vals, this->cols, x, y);
+      for(hpc::index ii = 0; ii < this->num_rows; ++ii)
+	 TS_ASSERT_EQUALS(y[ii], ref[ii]);
+   }
+
+   void test_spmm_double()
+   {
+      this->_check_spmm<double>(1e-10, 1);
+      this->_check_spmm<double>(1e-10, 5);
+      this->_check_spmm<double>(1e-10, 19);
+   }
+
+   void test_spmm_float()
+   {
+      this->_check_spmm<float>(1e-3, 3);
+      this->_check_spmm<float>(1e-3, 37);
+   }
+
+   void setUp()
+   {
+      // Row lengths from zero up to past the widest vector, with a
+      // few long rows to exercise the balancing.
+      this->num_rows = 200;
+      this->num_cols = 150;
+      hpc::vector<hpc::index> cnts(this->num_rows);
+      for(hpc::index ii = 0; ii < this->num_rows; ++ii)
+	 cnts[ii] = (ii%10 == 0) ? 100 : (ii*7)%37;
+      this->cols.copy_counts(cnts.begin(), this->num_rows);
+      this->cols.setup_array(true);
+      srand(7);
+      for(hpc::index ii = 0; ii < this->cols.array().size(); ++ii)
+	 this->cols.mod_array()[ii] = rand()%this->num_cols;
+   }
+
+protected:
+
+   template< class T >
+   void
+   _values( hpc::csr<T>& vals )
+   {
+      vals.num_rows(this->num_rows);
+      vals.mod_displs().duplicate(this->cols.displs());
+      vals.setup_array();
+      for(hpc::index ii = 0; ii < vals.array().size(); ++ii)
+	 vals.mod_array()[ii] = (T)(ii%11) - (T)5;
+   }
+
+   template< class T >
+   void
+   _reference( const hpc::csr<T>& vals,
+	       const T* x,
+	       T* y,
+	       hpc::index width )
+   {
+      for(hpc::index row = 0; row < this->num_rows; ++row) {
+	 for(hpc::index kk = 0; kk < width; ++kk) {
+	    T sum = 0;
+	    for(hpc::index jj = 0; jj < vals.row_size(row); ++jj)
+	       sum += vals(row, jj)*x[this->cols(row, jj)*width + kk];
+	    y[row*width + kk] = sum;
+	 }
+      }
+   }
+
+   template< class T >
+   void
+   _check_spmv( double tol )
+   {
+      hpc::vector<T> x(this->num_cols), y(this->num_rows), ref(this->num_rows);
+      for(hpc::index ii = 0; ii < this->num_cols; ++ii)
+	 x[ii] = (T)1.0/(ii + 1);
+      hpc::csr<T> vals;
+      this->_values(vals);
+      this->_reference(vals, x.data(), ref.data(), 1);
+      for(int level = hpc::simd_scalar; level <= hpc::best_simd_level(); ++level) {
+	 std::fill(y.begin(), y.end(), 0);
+	 hpc::spmv(vals, this->cols, x, y, (hpc::simd_level)level);
+	 for(hpc::index ii = 0; ii < this->num_rows; ++ii)
+	    TS_ASSERT_DELTA(y[ii], ref[ii], tol);
+	 std::fill(y.begin(), y.end(), 0);
+	 hpc::spmv_parallel(vals, this->cols, x, y, (hpc::simd_level)level);
+	 for(hpc::index ii = 0; ii < this->num_rows; ++ii)
+	    TS_ASSERT_DELTA(y[ii], ref[ii], tol);
+      }
+   }
+
+   template< class T >
+   void
+   _check_spmm( double tol,
+		hpc::index width )
+   {
+      hpc::vector<T> x(this->num_cols*width), y(this->num_rows*width), ref(this->num_rows*width);
+      for(hpc::index ii = 0; ii < x.size(); ++ii)
+	 x[ii] = (T)1.0/(ii + 1);
+      hpc::csr<T> vals;
+      this->_values(vals);
+      this->_reference(vals, x.data(), ref.data(), width);
+      for(int level = hpc::simd_scalar; level <= hpc::best_simd_level(); ++level) {
+	 std::fill(y.begin(), y.end(), 0);
+	 hpc::spmm(vals, this->cols, x.data(), y.data(), width, (hpc::simd_level)level);
+	 for(hpc::index ii = 0; ii < y.size(); ++ii)
+	    TS_ASSERT_DELTA(y[ii], ref[ii], tol);
+	 std::fill(y.begin(), y.end(), 0);
+	 hpc::spmm_parallel(vals, this->cols, x.data(), y.data(), width, (hpc::simd_level)level);
+	 for(hpc::index ii = 0; ii < y.size(); ++ii)
+	    TS_ASSERT_DELTA(y[ii], ref[ii], tol);
+      }
+   }
+
+   hpc::index num_rows, num_cols;
+   hpc::csr<hpc::index> cols;
+};
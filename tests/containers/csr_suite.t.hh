@@ -22,6 +22,7 @@
 #include "libhpc/containers/vector.hh"
 #include "libhpc/containers/functors.hh"
 #include "libhpc/containers/set.hh"
+#include "libhpc/memory/arena.hh"
 
 class csr_suite : public CxxTest::TestSuite {
 public:
@@ -352,6 +353,59 @@ public:
       	 TS_ASSERT_EQUALS(indices[ii], 10*ii);
    }
 
+   void test_setup_3phase_parallel()
+   {
+      hpc::vector<int> values(10000);
+      for(hpc::index ii = 0; ii < values.size(); ++ii)
+	 values[ii] = (7919*ii)%values.size();
+
+      hpc::set<int> pred;
+      for(hpc::index ii = 0; ii < values.size(); ii += 3)
+	 pred.insert(ii);
+
+      hpc::map<int, int> mapping;
+      for(hpc::index ii = 0; ii < values.size(); ++ii)
+	 mapping.insert(ii, ii%37);
+
+      hpc::csr<int> serial, parallel;
+      serial.setup_3phase(37, values.begin(), values.end(), hpc::map_get(mapping), hpc::set_has(pred));
+      parallel.setup_3phase_parallel(37, values.begin(), values.end(), hpc::map_get(mapping), hpc::set_has(pred));
+      TS_ASSERT(parallel == serial);
+
+      parallel.setup_3phase_parallel(0, values.begin(), values.end(), hpc::map_get(mapping), hpc::set_has(pred));
+      this->check_empty(parallel);
+   }
+
+   void test_arena_allocator()
+   {
+      hpc::vector<int> values(1000);
+      for(hpc::index ii = 0; ii < values.size(); ++ii)
+	 values[ii] = (7919*ii)%values.size();
+
+      hpc::map<int, int> mapping;
+      for(hpc::index ii = 0; ii < values.size(); ++ii)
+	 mapping.insert(ii, ii%37);
+
+      hpc::memory::arena arena(1 << 12);
+      typedef hpc::csr<int, hpc::memory::arena_allocator<int> > arena_csr;
+      arena_csr csr(0, hpc::memory::arena_allocator<int>(arena));
+      hpc::csr<int> ref;
+      for(int step = 0; step < 3; ++step) {
+	 csr.setup_3phase_parallel(37, values.begin(), values.end(), hpc::map_get(mapping), hpc::always<int>());
+	 ref.setup_3phase(37, values.begin(), values.end(), hpc::map_get(mapping), hpc::always<int>());
+	 TS_ASSERT(arena.used() >= 1038*sizeof(int));
+	 TS_ASSERT_EQUALS(csr.get_allocator().arena(), &arena);
+	 TS_ASSERT(std::equal(ref.displs().begin(), ref.displs().end(), csr.displs().begin()));
+	 TS_ASSERT(std::equal(ref.array().begin(), ref.array().end(), csr.array().begin()));
+
+	 arena_csr copy((const arena_csr&)csr);
+	 TS_ASSERT(copy == csr);
+	 copy.deallocate();
+	 csr.deallocate();
+	 arena.reset();
+      }
+   }
+
    void check_displs(const hpc::vector<hpc::index>::view& displs)
    {
       TS_ASSERT_EQUALS(displs.size(), 4);
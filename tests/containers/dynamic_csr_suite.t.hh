@@ -0,0 +1,118 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/dynamic_csr.hh"
+#include "libhpc/containers/csr.hh"
+#include "libhpc/containers/vector.hh"
+
+class dynamic_csr_suite : public CxxTest::TestSuite {
+public:
+
+   void test_set()
+   {
+      hpc::dynamic_csr<int> dyn(this->src, 2);
+      TS_ASSERT_EQUALS(dyn.num_rows(), 3);
+      TS_ASSERT_EQUALS(dyn.size(), 6);
+      TS_ASSERT_EQUALS(dyn.capacity(), 12);
+      TS_ASSERT_EQUALS(dyn.row_capacity(1), 3);
+      TS_ASSERT_EQUALS(dyn(2, 2), 32);
+
+      hpc::csr<int> csr;
+      dyn.compact(csr);
+      TS_ASSERT(csr == this->src);
+   }
+
+   void test_push_back()
+   {
+      hpc::dynamic_csr<int> dyn(this->src, 1);
+      dyn.push_back(0, 12);
+      TS_ASSERT_EQUALS(dyn.capacity(), 9);
+      dyn.push_back(0, 13);
+      TS_ASSERT_EQUALS(dyn.row_capacity(0), 6);
+      for(int ii = 0; ii < 10; ++ii)
+	 dyn.push_back(1, 21 + ii);
+      TS_ASSERT_EQUALS(dyn.size(), 18);
+      TS_ASSERT_EQUALS(dyn.row_size(0), 4);
+      TS_ASSERT_EQUALS(dyn.row_size(1), 11);
+      for(int ii = 0; ii < 4; ++ii)
+	 TS_ASSERT_EQUALS(dyn(0, ii), 10 + ii);
+      for(int ii = 0; ii < 11; ++ii)
+	 TS_ASSERT_EQUALS(dyn[1][ii], 20 + ii);
+      TS_ASSERT_EQUALS(dyn(2, 0), 30);
+
+      hpc::csr<int> csr;
+      dyn.compact(csr);
+      TS_ASSERT_EQUALS(csr.num_rows(), 3);
+      TS_ASSERT_EQUALS(csr.array().size(), 18);
+      TS_ASSERT_EQUALS(csr(1, 10), 30);
+      TS_ASSERT_EQUALS(csr(2, 2), 32);
+   }
+
+   void test_erase()
+   {
+      hpc::dynamic_csr<int> dyn(this->src);
+      dyn.erase(2, 1);
+      TS_ASSERT_EQUALS(dyn.row_size(2), 2);
+      TS_ASSERT_EQUALS(dyn(2, 0), 30);
+      TS_ASSERT_EQUALS(dyn(2, 1), 32);
+      dyn.clear_row(0);
+      TS_ASSERT_EQUALS(dyn.row_size(0), 0);
+      TS_ASSERT_EQUALS(dyn.size(), 3);
+   }
+
+   void test_set_row_and_add_row()
+   {
+      hpc::dynamic_csr<int> dyn(this->src, 0);
+      int vals[] = { 1, 2, 3, 4 };
+      dyn.set_row(1, vals, vals + 4);
+      TS_ASSERT_EQUALS(dyn.row_size(1), 4);
+      TS_ASSERT_EQUALS(dyn(1, 3), 4);
+      TS_ASSERT_EQUALS(dyn.size(), 9);
+
+      dyn.set_slack(2);
+      hpc::index row = dyn.add_row();
+      TS_ASSERT_EQUALS(row, 3);
+      dyn.push_back(row, 40);
+      TS_ASSERT_EQUALS(dyn(3, 0), 40);
+   }
+
+   void test_repack()
+   {
+      hpc::dynamic_csr<int> dyn(this->src, 0);
+      for(int ii = 0; ii < 5; ++ii)
+	 dyn.push_back(0, 12 + ii);
+      TS_ASSERT(dyn.capacity() > dyn.size());
+      dyn.repack();
+      TS_ASSERT_EQUALS(dyn.capacity(), dyn.size());
+      TS_ASSERT_EQUALS(dyn(0, 6), 16);
+      TS_ASSERT_EQUALS(dyn(2, 0), 30);
+   }
+
+   void setUp()
+   {
+      hpc::vector<hpc::index> displs(4);
+      displs[0] = 0; displs[1] = 2; displs[2] = 3; displs[3] = 6;
+      this->src.copy_displs(displs.begin(), displs.size());
+      this->src.setup_array();
+      this->src(0, 0) = 10; this->src(0, 1) = 11;
+      this->src(1, 0) = 20;
+      this->src(2, 0) = 30; this->src(2, 1) = 31; this->src(2, 2) = 32;
+   }
+
+   hpc::csr<int> src;
+};
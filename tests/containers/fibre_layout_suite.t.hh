@@ -0,0 +1,197 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include <vector>
+#include "libhpc/containers/fibre_layout.hh"
+#include "libhpc/memory/arena.hh"
+
+using namespace hpc;
+
+class fibre_layout_suite : public CxxTest::TestSuite {
+public:
+
+   void test_soa()
+   {
+      fibre<double,soa_layout> fbr(3, 10);
+      TS_ASSERT_EQUALS(fbr.fibre_size(), 3);
+      TS_ASSERT_EQUALS(fbr.size(), 10);
+      TS_ASSERT_EQUALS(fbr.capacity(), 16);
+      TS_ASSERT_EQUALS(fbr.num_blocks(), 1);
+      TS_ASSERT_EQUALS(fbr.block_size(), 16);
+      this->_fill(fbr);
+
+      // Components are contiguous and aligned.
+      for(hpc::index comp = 0; comp < 3; ++comp) {
+	 const double* ptr = fbr.block(0, comp);
+	 TS_ASSERT_EQUALS((size_t)ptr%fibre_alignment, 0);
+	 for(hpc::index ii = 0; ii < 10; ++ii)
+	    TS_ASSERT_EQUALS(ptr[ii], 10*ii + comp);
+	 for(hpc::index ii = 10; ii < 16; ++ii)
+	    TS_ASSERT_EQUALS(ptr[ii], 0);
+      }
+      this->_check(fbr, 10);
+   }
+
+   void test_aosoa()
+   {
+      fibre<float,aosoa_layout<16> > fbr(6, 40);
+      TS_ASSERT_EQUALS(fbr.capacity(), 48);
+      TS_ASSERT_EQUALS(fbr.num_blocks(), 3);
+      TS_ASSERT_EQUALS(fbr.block_size(), 16);
+      this->_fill(fbr);
+      for(hpc::index blk = 0; blk < 3; ++blk) {
+	 for(hpc::index comp = 0; comp < 6; ++comp) {
+	    const float* ptr = fbr.block(blk, comp);
+	    TS_ASSERT_EQUALS((size_t)ptr%fibre_alignment, 0);
+	    TS_ASSERT_EQUALS(ptr[1], fbr(16*blk + 1, comp));
+	 }
+      }
+      TS_ASSERT_EQUALS(fbr.block(2, 0)[8], 0);
+      this->_check(fbr, 40);
+   }
+
+   void test_view_range()
+   {
+      fibre<int,aosoa_layout<8> > fbr(4, 12);
+      this->_fill(fbr);
+      std::vector<int> comps(fbr[9].begin(), fbr[9].end());
+      TS_ASSERT_EQUALS(comps.size(), 4);
+      for(hpc::index comp = 0; comp < 4; ++comp)
+	 TS_ASSERT_EQUALS(comps[comp], fbr(9, comp));
+      std::fill(fbr[3].begin(), fbr[3].end(), -1);
+      TS_ASSERT_EQUALS(fbr(3, 2), -1);
+      TS_ASSERT_EQUALS(fbr(4, 2), 42);
+      TS_ASSERT_EQUALS(fbr[3].end() - fbr[3].begin(), 4);
+   }
+
+   void test_arena_allocator()
+   {
+      memory::arena arena;
+      fibre<double,soa_layout,memory::arena_allocator<double> > fbr(3, 10, memory::arena_allocator<double>(arena));
+      TS_ASSERT(arena.used() >= 48*sizeof(double));
+      TS_ASSERT_EQUALS(fbr.get_allocator().arena(), &arena);
+      this->_fill(fbr);
+
+      // Still laid out as structure of arrays.
+      TS_ASSERT_EQUALS(fbr.block(0, 1) - fbr.block(0, 0), 16);
+      TS_ASSERT_EQUALS((size_t)fbr.block(0, 0)%fibre_alignment, 0);
+      this->_check(fbr, 10);
+
+      fbr.resize(40);
+      TS_ASSERT_EQUALS(fbr.block(0, 1) - fbr.block(0, 0), fbr.capacity());
+      this->_check(fbr, 10);
+
+      fibre<int,aosoa_layout<8>,memory::arena_allocator<int> > blk(2, 12, memory::arena_allocator<int>(arena));
+      this->_fill(blk);
+      TS_ASSERT_EQUALS(blk.block(1, 0)[2], blk(10, 0));
+      TS_ASSERT_EQUALS((size_t)blk.block(0, 0)%fibre_alignment, 0);
+   }
+
+   void test_resize()
+   {
+      fibre<int,soa_layout> fbr(2, 5);
+      this->_fill(fbr);
+      fbr.resize(50);
+      TS_ASSERT_EQUALS(fbr.size(), 50);
+      TS_ASSERT(fbr.capacity() >= 50);
+      this->_check(fbr, 5);
+      TS_ASSERT_EQUALS(fbr(20, 1), 0);
+
+      // Shrinking zeroes the dropped fibres.
+      fbr.resize(3);
+      fbr.resize(5);
+      TS_ASSERT_EQUALS(fbr(3, 0), 0);
+      TS_ASSERT_EQUALS(fbr(4, 1), 0);
+      TS_ASSERT_EQUALS(fbr(2, 1), 21);
+
+      fibre<int,soa_layout> copy(fbr);
+      TS_ASSERT_EQUALS(copy.size(), 5);
+      TS_ASSERT_EQUALS(copy(2, 1), 21);
+
+      fbr.deallocate();
+      TS_ASSERT_EQUALS(fbr.size(), 0);
+      TS_ASSERT_EQUALS(fbr.capacity(), 0);
+   }
+
+   void test_iterator()
+   {
+      fibre<int,aosoa_layout<8> > fbr(3, 20);
+      int count = 0;
+      for(fibre<int,aosoa_layout<8> >::iterator it = fbr.begin(); it != fbr.end(); ++it) {
+	 TS_ASSERT_EQUALS((*it).size(), 3);
+	 (*it)[0] = count;
+	 (*it)[2] = 2*count;
+	 ++count;
+      }
+      TS_ASSERT_EQUALS(count, 20);
+      TS_ASSERT_EQUALS(fbr.end() - fbr.begin(), 20);
+      TS_ASSERT_EQUALS(fbr.begin()[11][2], 22);
+
+      count = 0;
+      const fibre<int,aosoa_layout<8> >& cfbr = fbr;
+      for(fibre<int,aosoa_layout<8> >::const_iterator it = cfbr.begin(); it != cfbr.end(); ++it) {
+	 TS_ASSERT_EQUALS((*it)[0], count);
+	 TS_ASSERT_EQUALS((*it)[2], 2*count);
+	 ++count;
+      }
+   }
+
+   void test_convert()
+   {
+      fibre<double> aos(3, 37);
+      this->_fill(aos);
+
+      fibre<double,soa_layout> soa;
+      convert_layout(aos, soa);
+      this->_check(soa, 37);
+
+      fibre<double,aosoa_layout<8> > aosoa;
+      convert_layout(soa, aosoa);
+      this->_check(aosoa, 37);
+
+      fibre<double> back;
+      convert_layout(aosoa, back);
+      TS_ASSERT_EQUALS(back.fibre_size(), 3);
+      this->_check(back, 37);
+   }
+
+protected:
+
+   template< class Fibre >
+   void
+   _fill( Fibre& fbr )
+   {
+      for(hpc::index ii = 0; ii < fbr.size(); ++ii) {
+	 for(hpc::index jj = 0; jj < fbr.fibre_size(); ++jj)
+	    fbr(ii, jj) = 10*ii + jj;
+      }
+   }
+
+   template< class Fibre >
+   void
+   _check( const Fibre& fbr,
+	   hpc::index size )
+   {
+      for(hpc::index ii = 0; ii < size; ++ii) {
+	 for(hpc::index jj = 0; jj < fbr.fibre_size(); ++jj) {
+	    TS_ASSERT_EQUALS(fbr(ii, jj), 10*ii + jj);
+	    TS_ASSERT_EQUALS(fbr[ii][jj], 10*ii + jj);
+	 }
+      }
+   }
+};
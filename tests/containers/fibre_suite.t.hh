@@ -17,6 +17,7 @@
 
 #include <cxxtest/TestSuite.h>
 #include "libhpc/containers/fibre.hh"
+#include "libhpc/memory/arena.hh"
 
 using namespace hpc;
 
@@ -182,6 +183,79 @@ public:
       TS_ASSERT_EQUALS( count, 10 );
    }
 
+   void test_fixed_fibre()
+   {
+      fixed_fibre<int,3> fbr( 10 );
+      TS_ASSERT_EQUALS( fbr.fibre_size(), 3 );
+      TS_ASSERT_EQUALS( fbr.size(), 10 );
+      TS_ASSERT_EQUALS( ((hpc::vector<int>&)fbr).size(), 30 );
+      TS_ASSERT_EQUALS( ((hpc::vector<int>&)fbr).capacity(), fbr.capacity()*3 );
+
+      fixed_fibre_view<int,3> view = fbr[3];
+      TS_ASSERT_EQUALS( view.size(), 3 );
+      view[0] = 10;
+      view[1] = 20;
+      view[2] = 30;
+      TS_ASSERT_EQUALS( ((vector<int>&)fbr)[9], 10 );
+      TS_ASSERT_EQUALS( ((vector<int>&)fbr)[10], 20 );
+      TS_ASSERT_EQUALS( ((vector<int>&)fbr)[11], 30 );
+      TS_ASSERT_EQUALS( fbr( 3, 1 ), 20 );
+      TS_ASSERT_EQUALS( ((const fixed_fibre<int,3>&)fbr)[3][2], 30 );
+
+#ifndef NDEBUG
+      TS_ASSERT_THROWS_ANYTHING( fbr[10] );
+      TS_ASSERT_THROWS_ANYTHING( fbr.set_fibre_size( 2 ) );
+#endif
+
+      fbr.deallocate();
+      TS_ASSERT_EQUALS( fbr.size(), 0 );
+      TS_ASSERT_EQUALS( fbr.capacity(), 0 );
+   }
+
+   void test_fixed_iterator()
+   {
+      fixed_fibre<int,3> fbr( 10 );
+
+      int count = 0;
+      for( fixed_fibre<int,3>::iterator it = fbr.begin(); it != fbr.end(); ++it ) {
+         fixed_fibre_view<int,3> view = *it;
+         for( index ii = 0; ii < view.size(); ++ii )
+            view[ii] = (10*ii + 1)*count;
+         ++count;
+      }
+      TS_ASSERT_EQUALS( count, 10 );
+      TS_ASSERT_EQUALS( fbr.end() - fbr.begin(), 10 );
+      TS_ASSERT_EQUALS( fbr.begin()[4][1], 44 );
+      TS_ASSERT_EQUALS( (*(fbr.begin() + 5))[2], 105 );
+
+      count = 0;
+      const fixed_fibre<int,3>& cfbr = fbr;
+      for( fixed_fibre<int,3>::const_iterator it = cfbr.begin(); it != cfbr.end(); ++it ) {
+         fixed_fibre_view<const int,3> view = *it;
+         TS_ASSERT_EQUALS( view[0], count );
+         TS_ASSERT_EQUALS( view[1], 11*count );
+         TS_ASSERT_EQUALS( view[2], 21*count );
+         ++count;
+      }
+      TS_ASSERT_EQUALS( count, 10 );
+   }
+
+   void test_arena_allocator()
+   {
+      memory::arena arena;
+      fibre<int,aos_layout,memory::arena_allocator<int> > fbr( 3, 10, memory::arena_allocator<int>( arena ) );
+      TS_ASSERT_EQUALS( arena.used(), 30*sizeof(int) );
+      for( index ii = 0; ii < 10; ++ii )
+         for( index jj = 0; jj < 3; ++jj )
+            fbr( ii, jj ) = 10*ii + jj;
+      TS_ASSERT_EQUALS( fbr[4][2], 42 );
+      TS_ASSERT_EQUALS( fbr.end() - fbr.begin(), 10 );
+      TS_ASSERT_EQUALS( (*(fbr.begin() + 7))[1], 71 );
+      fbr.deallocate();
+      TS_ASSERT_EQUALS( arena.used(), 0 );
+      TS_ASSERT_EQUALS( fbr.get_allocator().arena(), &arena );
+   }
+
    void check_empty(fibre<int>& fbr) {
       TS_ASSERT(fbr.empty());
    }
@@ -0,0 +1,147 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/flat_range_map.hh"
+
+using namespace hpc;
+
+class flat_range_map_suite : public CxxTest::TestSuite {
+public:
+
+   typedef flat_range_map<int,int> map_type;
+   typedef map_type::value_type value_type;
+
+   void test_default_ctor()
+   {
+      map_type map;
+      TS_ASSERT_EQUALS( map.size(), 0 );
+      TS_ASSERT( map.empty() );
+      TS_ASSERT( map.find( 0 ) == map.end() );
+   }
+
+   void test_build_disjoint()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 10, 20 ), 2 ) );
+      in.push_back( value_type( range<int>( 0, 5 ), 1 ) );
+      map_type map;
+      map.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( map.size(), 2 );
+      TS_ASSERT_EQUALS( map.find( 3 )->second, 1 );
+      TS_ASSERT_EQUALS( map.find( 10 )->second, 2 );
+      TS_ASSERT( map.find( 5 ) == map.end() );
+      TS_ASSERT( map.find( 20 ) == map.end() );
+   }
+
+   void test_build_overlaps()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 0, 20 ), 1 ) );
+      in.push_back( value_type( range<int>( 5, 10 ), 2 ) );
+      in.push_back( value_type( range<int>( 8, 30 ), 3 ) );
+      in.push_back( value_type( range<int>( 30, 35 ), 3 ) );
+      map_type map;
+      map.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( map.size(), 3 );
+      map_type::iterator it = map.begin();
+      TS_ASSERT_EQUALS( it->first, range<int>( 0, 5 ) );
+      TS_ASSERT_EQUALS( it->second, 1 );
+      ++it;
+      TS_ASSERT_EQUALS( it->first, range<int>( 5, 8 ) );
+      TS_ASSERT_EQUALS( it->second, 2 );
+      ++it;
+      TS_ASSERT_EQUALS( it->first, range<int>( 8, 35 ) );
+      TS_ASSERT_EQUALS( it->second, 3 );
+   }
+
+   void test_build_coalesces()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 0, 5 ), 1 ) );
+      in.push_back( value_type( range<int>( 5, 10 ), 1 ) );
+      in.push_back( value_type( range<int>( 10, 15 ), 2 ) );
+      map_type map;
+      map.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( map.size(), 2 );
+      TS_ASSERT_EQUALS( map.begin()->first, range<int>( 0, 10 ) );
+   }
+
+   void test_overlapping()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 0, 5 ), 1 ) );
+      in.push_back( value_type( range<int>( 10, 15 ), 2 ) );
+      in.push_back( value_type( range<int>( 20, 25 ), 3 ) );
+      map_type map;
+      map.build( in.begin(), in.end() );
+      std::pair<map_type::iterator,map_type::iterator> res = map.overlapping( range<int>( 3, 12 ) );
+      TS_ASSERT( res.first == map.begin() && res.second == map.begin() + 2 );
+      res = map.overlapping( range<int>( 15, 20 ) );
+      TS_ASSERT( res.first == res.second );
+   }
+
+   void test_insert_split()
+   {
+      map_type map;
+      map.insert( range<int>( 0, 20 ), 1 );
+      map.insert( range<int>( 5, 10 ), 2 );
+      TS_ASSERT_EQUALS( map.size(), 3 );
+      map_type::iterator it = map.begin();
+      TS_ASSERT_EQUALS( it->first, range<int>( 0, 5 ) );
+      TS_ASSERT_EQUALS( (++it)->first, range<int>( 5, 10 ) );
+      TS_ASSERT_EQUALS( it->second, 2 );
+      TS_ASSERT_EQUALS( (++it)->first, range<int>( 10, 20 ) );
+      TS_ASSERT_EQUALS( it->second, 1 );
+   }
+
+   void test_insert_coalesces()
+   {
+      map_type map;
+      map.insert( range<int>( 0, 20 ), 1 );
+      map.insert( range<int>( 5, 10 ), 2 );
+      map.insert( range<int>( 4, 12 ), 1 );
+      TS_ASSERT_EQUALS( map.size(), 1 );
+      TS_ASSERT_EQUALS( map.begin()->first, range<int>( 0, 20 ) );
+      map.insert( range<int>( 30, 40 ), 1 );
+      map.insert( range<int>( 20, 30 ), 1 );
+      TS_ASSERT_EQUALS( map.size(), 1 );
+      TS_ASSERT_EQUALS( map.begin()->first, range<int>( 0, 40 ) );
+   }
+
+   void test_matches_sequential_insert()
+   {
+      std::vector<value_type> in;
+      srand( 1 );
+      for( int ii = 0; ii < 200; ++ii )
+      {
+         int start = rand()%1000;
+         in.push_back( value_type( range<int>( start, start + rand()%50 ), rand()%4 ) );
+      }
+      map_type built, inserted;
+      built.build( in.begin(), in.end() );
+      for( unsigned ii = 0; ii < in.size(); ++ii )
+         inserted.insert( in[ii].first, in[ii].second );
+      TS_ASSERT_EQUALS( built.size(), inserted.size() );
+      for( int ii = -1; ii < 1100; ++ii )
+      {
+         TS_ASSERT_EQUALS( built.has( ii ), inserted.has( ii ) );
+         if( built.has( ii ) )
+            TS_ASSERT_EQUALS( built.find( ii )->second, inserted.find( ii )->second );
+      }
+   }
+};
@@ -0,0 +1,99 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/flat_range_set.hh"
+
+using namespace hpc;
+
+class flat_range_set_suite : public CxxTest::TestSuite {
+public:
+
+   void test_default_ctor()
+   {
+      flat_range_set<int> set;
+      TS_ASSERT_EQUALS( set.size(), 0 );
+      TS_ASSERT( set.empty() );
+      TS_ASSERT( set.find( 0 ) == set.end() );
+   }
+
+   void test_build_merges()
+   {
+      std::vector<range<int> > rngs;
+      rngs.push_back( range<int>( 20, 30 ) );
+      rngs.push_back( range<int>( 0, 5 ) );
+      rngs.push_back( range<int>( 3, 10 ) );
+      rngs.push_back( range<int>( 10, 12 ) );
+      rngs.push_back( range<int>( 25, 28 ) );
+      rngs.push_back( range<int>( 40, 40 ) );
+      flat_range_set<int> set;
+      set.build( rngs.begin(), rngs.end() );
+      TS_ASSERT_EQUALS( set.size(), 2 );
+      TS_ASSERT_EQUALS( set.begin()[0], range<int>( 0, 12 ) );
+      TS_ASSERT_EQUALS( set.begin()[1], range<int>( 20, 30 ) );
+   }
+
+   void test_find()
+   {
+      std::vector<range<int> > rngs;
+      rngs.push_back( range<int>( 0, 5 ) );
+      rngs.push_back( range<int>( 10, 15 ) );
+      flat_range_set<int> set;
+      set.build( rngs.begin(), rngs.end() );
+      TS_ASSERT( set.find( -1 ) == set.end() );
+      TS_ASSERT( set.find( 0 ) == set.begin() );
+      TS_ASSERT( set.find( 4 ) == set.begin() );
+      TS_ASSERT( set.find( 5 ) == set.end() );
+      TS_ASSERT( set.find( 12 ) == set.begin() + 1 );
+      TS_ASSERT( set.find( 15 ) == set.end() );
+      TS_ASSERT( set.has( 14 ) );
+      TS_ASSERT( !set.has( 7 ) );
+   }
+
+   void test_overlapping()
+   {
+      std::vector<range<int> > rngs;
+      rngs.push_back( range<int>( 0, 5 ) );
+      rngs.push_back( range<int>( 10, 15 ) );
+      rngs.push_back( range<int>( 20, 25 ) );
+      flat_range_set<int> set;
+      set.build( rngs.begin(), rngs.end() );
+      std::pair<flat_range_set<int>::iterator,flat_range_set<int>::iterator> res;
+      res = set.overlapping( range<int>( 4, 11 ) );
+      TS_ASSERT( res.first == set.begin() && res.second == set.begin() + 2 );
+      res = set.overlapping( range<int>( 5, 10 ) );
+      TS_ASSERT( res.first == res.second );
+      res = set.overlapping( range<int>( 12, 30 ) );
+      TS_ASSERT( res.first == set.begin() + 1 && res.second == set.end() );
+   }
+
+   void test_insert()
+   {
+      flat_range_set<int> set;
+      set.insert( range<int>( 10, 15 ) );
+      set.insert( range<int>( 0, 5 ) );
+      set.insert( range<int>( 30, 35 ) );
+      TS_ASSERT_EQUALS( set.size(), 3 );
+      set.insert( range<int>( 5, 10 ) );
+      TS_ASSERT_EQUALS( set.size(), 2 );
+      TS_ASSERT_EQUALS( set.begin()[0], range<int>( 0, 15 ) );
+      set.insert( range<int>( 14, 40 ) );
+      TS_ASSERT_EQUALS( set.size(), 1 );
+      TS_ASSERT_EQUALS( set.begin()[0], range<int>( 0, 40 ) );
+      TS_ASSERT( set.has( 39 ) );
+   }
+};
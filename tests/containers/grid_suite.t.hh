@@ -0,0 +1,174 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <set>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/grid.hh"
+
+using namespace hpc;
+
+class grid_suite : public CxxTest::TestSuite {
+public:
+
+   void test_row_major()
+   {
+      unsigned sides[3] = { 3, 4, 5 };
+      grid<unsigned> grd( 3, sides );
+      TS_ASSERT_EQUALS( grd.size(), 60 );
+      TS_ASSERT_EQUALS( grd.extent(), 60 );
+      unsigned crd[3] = { 2, 1, 3 };
+      TS_ASSERT_EQUALS( grd.project( crd ), 2 + 3*(1 + 4*3) );
+      std::vector<unsigned> res( 3 );
+      grd.lift( 2 + 3*(1 + 4*3), res.begin() );
+      TS_ASSERT( std::equal( res.begin(), res.end(), crd ) );
+   }
+
+   void test_morton()
+   {
+      unsigned sides[2] = { 5, 3 };
+      grid<unsigned,morton_order<unsigned> > grd( 2, sides );
+      TS_ASSERT_EQUALS( grd.size(), 15 );
+      TS_ASSERT_EQUALS( grd.order().bits(), 3 );
+      unsigned crd[2] = { 3, 2 };
+      TS_ASSERT_EQUALS( grd.project( crd ), morton<2>( 3, 2 ) );
+      TS_ASSERT_EQUALS( grd.extent(), morton<2>( 4, 2 ) + 1 );
+      std::vector<unsigned> res( 2 );
+      grd.lift( morton<2>( 3, 2 ), res.begin() );
+      TS_ASSERT( std::equal( res.begin(), res.end(), crd ) );
+      _check_roundtrip( grd );
+   }
+
+   void test_morton_1d()
+   {
+      // 1D Morton is the identity, so isn't held to 16 bits.
+      unsigned sides[1] = { 1 << 20 };
+      grid<unsigned,morton_order<unsigned> > grd( 1, sides );
+      TS_ASSERT_EQUALS( grd.order().bits(), 20 );
+      TS_ASSERT_EQUALS( grd.extent(), 1 << 20 );
+      unsigned crd[1] = { 700000 };
+      TS_ASSERT_EQUALS( grd.project( crd ), 700000 );
+   }
+
+   void test_morton_3d()
+   {
+      unsigned sides[3] = { 6, 7, 3 };
+      grid<unsigned,morton_order<unsigned> > grd( 3, sides );
+      _check_roundtrip( grd );
+      _check_box( grd );
+   }
+
+   void test_hilbert()
+   {
+      unsigned sides[2] = { 4, 4 };
+      grid<unsigned,hilbert_order<unsigned> > grd( 2, sides );
+      TS_ASSERT_EQUALS( grd.extent(), 16 );
+      _check_roundtrip( grd );
+
+      // Successive cells along a Hilbert curve are always adjacent.
+      for( unsigned ii = 1; ii < grd.extent(); ++ii )
+      {
+         std::vector<unsigned> prev( 2 ), cur( 2 );
+         grd.lift( ii - 1, prev.begin() );
+         grd.lift( ii, cur.begin() );
+         unsigned dist = 0;
+         for( unsigned jj = 0; jj < 2; ++jj )
+            dist += (prev[jj] > cur[jj]) ? prev[jj] - cur[jj] : cur[jj] - prev[jj];
+         TS_ASSERT_EQUALS( dist, 1 );
+      }
+   }
+
+   void test_hilbert_3d()
+   {
+      unsigned sides[3] = { 5, 8, 3 };
+      grid<unsigned,hilbert_order<unsigned> > grd( 3, sides );
+      _check_roundtrip( grd );
+      _check_box( grd );
+   }
+
+   void test_row_major_box()
+   {
+      unsigned sides[3] = { 4, 5, 6 };
+      grid<unsigned> grd( 3, sides );
+      _check_box( grd );
+   }
+
+   void test_full_iteration()
+   {
+      unsigned sides[2] = { 7, 5 };
+      grid<unsigned,morton_order<unsigned> > grd( 2, sides );
+      unsigned cnt = 0;
+      for( grid<unsigned,morton_order<unsigned> >::box_iterator it = grd.begin(); it != grd.end(); ++it )
+         ++cnt;
+      TS_ASSERT_EQUALS( cnt, grd.size() );
+   }
+
+protected:
+
+   template< class Grid >
+   void
+   _check_roundtrip( const Grid& grd )
+   {
+      unsigned dim = grd.dimension();
+      std::set<unsigned> seen;
+      std::vector<unsigned> crd( dim, 0 ), res( dim );
+      for( unsigned ii = 0; ii < grd.size(); ++ii )
+      {
+         unsigned idx = grd.project( crd.begin() );
+         TS_ASSERT( idx < grd.extent() );
+         TS_ASSERT( seen.insert( idx ).second );
+         grd.lift( idx, res.begin() );
+         TS_ASSERT( res == crd );
+         for( unsigned jj = 0; jj < dim; ++jj )
+         {
+            if( ++crd[jj] < grd.sides()[jj] )
+               break;
+            crd[jj] = 0;
+         }
+      }
+   }
+
+   template< class Grid >
+   void
+   _check_box( const Grid& grd )
+   {
+      unsigned dim = grd.dimension();
+      std::vector<unsigned> lo( dim ), hi( dim );
+      for( unsigned ii = 0; ii < dim; ++ii )
+      {
+         lo[ii] = 1;
+         hi[ii] = grd.sides()[ii] - 1;
+      }
+      unsigned num = 1;
+      for( unsigned ii = 0; ii < dim; ++ii )
+         num *= hi[ii] - lo[ii];
+
+      unsigned cnt = 0;
+      bool first = true;
+      unsigned prev = 0;
+      for( typename Grid::box_iterator it = grd.box_begin( lo.begin(), hi.begin() ); it != grd.box_end(); ++it, ++cnt )
+      {
+         const std::vector<unsigned>& crd = it.coord();
+         for( unsigned ii = 0; ii < dim; ++ii )
+            TS_ASSERT( crd[ii] >= lo[ii] && crd[ii] < hi[ii] );
+         TS_ASSERT_EQUALS( *it, grd.project( crd.begin() ) );
+         TS_ASSERT( first || *it > prev );
+         prev = *it;
+         first = false;
+      }
+      TS_ASSERT_EQUALS( cnt, num );
+   }
+};
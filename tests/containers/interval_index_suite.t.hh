@@ -0,0 +1,177 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <set>
+#include <cstdlib>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/interval_index.hh"
+
+using namespace hpc;
+
+class interval_index_suite : public CxxTest::TestSuite {
+public:
+
+   typedef interval_index<int,int> index_type;
+   typedef index_type::value_type value_type;
+
+   struct collect
+   {
+      collect( std::vector<std::multiset<int> >& res )
+         : res( res )
+      {
+      }
+
+      void
+      operator()( size_t probe,
+                  const value_type& elem )
+      {
+         res[probe].insert( elem.second );
+      }
+
+      std::vector<std::multiset<int> >& res;
+   };
+
+   void test_default_ctor()
+   {
+      index_type idx;
+      TS_ASSERT_EQUALS( idx.size(), 0 );
+      TS_ASSERT( idx.empty() );
+      index_type::query_range res = idx.stab( 0 );
+      TS_ASSERT( res.first == res.second );
+   }
+
+   void test_stab()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 0, 20 ), 0 ) );
+      in.push_back( value_type( range<int>( 0, 5 ), 1 ) );
+      in.push_back( value_type( range<int>( 5, 10 ), 2 ) );
+      in.push_back( value_type( range<int>( 8, 18 ), 3 ) );
+      in.push_back( value_type( range<int>( 20, 25 ), 4 ) );
+      in.push_back( value_type( range<int>( 3, 3 ), 5 ) );
+      index_type idx;
+      idx.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( idx.size(), 5 );
+      TS_ASSERT_EQUALS( _stab( idx, 3 ), _set( 0, 1 ) );
+      TS_ASSERT_EQUALS( _stab( idx, 5 ), _set( 0, 2 ) );
+      TS_ASSERT_EQUALS( _stab( idx, 9 ), _set( 0, 2, 3 ) );
+      TS_ASSERT_EQUALS( _stab( idx, 20 ), _set( 4 ) );
+      TS_ASSERT_EQUALS( _stab( idx, 25 ), _set() );
+      TS_ASSERT_EQUALS( _stab( idx, -1 ), _set() );
+   }
+
+   void test_overlapping()
+   {
+      std::vector<value_type> in;
+      in.push_back( value_type( range<int>( 0, 20 ), 0 ) );
+      in.push_back( value_type( range<int>( 0, 5 ), 1 ) );
+      in.push_back( value_type( range<int>( 5, 10 ), 2 ) );
+      in.push_back( value_type( range<int>( 8, 18 ), 3 ) );
+      in.push_back( value_type( range<int>( 20, 25 ), 4 ) );
+      index_type idx;
+      idx.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( _overlap( idx, range<int>( 4, 6 ) ), _set( 0, 1, 2 ) );
+      TS_ASSERT_EQUALS( _overlap( idx, range<int>( 18, 21 ) ), _set( 0, 4 ) );
+      TS_ASSERT_EQUALS( _overlap( idx, range<int>( 25, 30 ) ), _set() );
+      TS_ASSERT_EQUALS( _overlap( idx, range<int>( 6, 6 ) ), _set() );
+   }
+
+   void test_random()
+   {
+      std::vector<value_type> in;
+      srand( 3 );
+      for( int ii = 0; ii < 500; ++ii )
+      {
+         int start = rand()%1000;
+         in.push_back( value_type( range<int>( start, start + rand()%100 ), ii ) );
+      }
+      index_type idx;
+      idx.build( in.begin(), in.end() );
+      for( int ii = -10; ii < 1110; ii += 7 )
+      {
+         std::multiset<int> stab, over;
+         range<int> rng( ii, ii + rand()%30 );
+         for( unsigned jj = 0; jj < in.size(); ++jj )
+         {
+            const range<int>& cur = in[jj].first;
+            if( cur.has( ii ) )
+               stab.insert( jj );
+            if( cur.length() && rng.length() && cur.start() < rng.finish() && rng.start() < cur.finish() )
+               over.insert( jj );
+         }
+         TS_ASSERT_EQUALS( _stab( idx, ii ), stab );
+         TS_ASSERT_EQUALS( _overlap( idx, rng ), over );
+      }
+   }
+
+   void test_stab_many()
+   {
+      std::vector<value_type> in;
+      srand( 4 );
+      for( int ii = 0; ii < 300; ++ii )
+      {
+         int start = rand()%1000;
+         in.push_back( value_type( range<int>( start, start + rand()%100 ), ii ) );
+      }
+      index_type idx;
+      idx.build( in.begin(), in.end() );
+      std::vector<int> probes;
+      for( int ii = 0; ii < 200; ++ii )
+         probes.push_back( rand()%1200 - 50 );
+      std::sort( probes.begin(), probes.end() );
+      std::vector<std::multiset<int> > res( probes.size() );
+      idx.stab_many( probes.begin(), probes.end(), collect( res ) );
+      for( unsigned ii = 0; ii < probes.size(); ++ii )
+         TS_ASSERT_EQUALS( res[ii], _stab( idx, probes[ii] ) );
+   }
+
+protected:
+
+   std::multiset<int>
+   _stab( const index_type& idx,
+          int value )
+   {
+      index_type::query_range res = idx.stab( value );
+      std::multiset<int> vals;
+      for( ; res.first != res.second; ++res.first )
+         vals.insert( res.first->second );
+      return vals;
+   }
+
+   std::multiset<int>
+   _overlap( const index_type& idx,
+             const range<int>& rng )
+   {
+      index_type::query_range res = idx.overlapping( rng );
+      std::multiset<int> vals;
+      for( ; res.first != res.second; ++res.first )
+         vals.insert( res.first->second );
+      return vals;
+   }
+
+   std::multiset<int>
+   _set( int a = -1,
+         int b = -1,
+         int c = -1 )
+   {
+      std::multiset<int> res;
+      if( a >= 0 ) res.insert( a );
+      if( b >= 0 ) res.insert( b );
+      if( c >= 0 ) res.insert( c );
+      return res;
+   }
+};
@@ -0,0 +1,118 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <stddef.h>
+#include <fstream>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/mapped_csr.hh"
+#include "libhpc/containers/csr.hh"
+#include "libhpc/containers/vector.hh"
+#include "libhpc/system/tmpfile.hh"
+
+class mapped_csr_suite : public CxxTest::TestSuite {
+public:
+
+   void test_round_trip()
+   {
+      hpc::tmpfile tmp;
+      hpc::save_csr(this->src, tmp.filename());
+
+      hpc::mapped_csr<int> map(tmp.filename());
+      TS_ASSERT_EQUALS(map.num_rows(), 3);
+      TS_ASSERT_EQUALS(map.displs().size(), 4);
+      TS_ASSERT_EQUALS(map.array().size(), 6);
+      TS_ASSERT_EQUALS(map.row_size(0), 2);
+      TS_ASSERT_EQUALS(map.row_size(1), 1);
+      TS_ASSERT_EQUALS(map.row_size(2), 3);
+      TS_ASSERT_EQUALS(map[0][1], 11);
+      TS_ASSERT_EQUALS(map[2][2], 32);
+      TS_ASSERT_EQUALS(map(1, 0), 20);
+      TS_ASSERT_EQUALS((size_t)map.array().data()%hpc::csr_file_alignment, 0);
+
+      hpc::csr<int> csr;
+      map.unpack(csr);
+      TS_ASSERT(csr == this->src);
+   }
+
+   void test_empty()
+   {
+      hpc::tmpfile tmp;
+      hpc::csr<int> empty;
+      hpc::save_csr(empty, tmp.filename());
+      hpc::mapped_csr<int> map(tmp.filename());
+      TS_ASSERT(map.empty());
+      hpc::csr<int> csr;
+      map.unpack(csr);
+      TS_ASSERT(csr.empty());
+   }
+
+   void test_mismatched_type()
+   {
+      hpc::tmpfile tmp;
+      hpc::save_csr(this->src, tmp.filename());
+      hpc::mapped_csr<double> map;
+      TS_ASSERT_THROWS_ANYTHING(map.open(tmp.filename()));
+   }
+
+   void test_corrupt_header()
+   {
+      hpc::tmpfile tmp;
+      hpc::mapped_csr<int> map;
+
+      // Displacements overlapping the array.
+      hpc::save_csr(this->src, tmp.filename());
+      this->patch(tmp.filename(), offsetof(hpc::csr_file_header, num_rows), 100);
+      TS_ASSERT_THROWS_ANYTHING(map.open(tmp.filename()));
+
+      // Array size that wraps when scaled.
+      hpc::save_csr(this->src, tmp.filename());
+      this->patch(tmp.filename(), offsetof(hpc::csr_file_header, array_size), (uint64_t)1 << 62);
+      TS_ASSERT_THROWS_ANYTHING(map.open(tmp.filename()));
+
+      // Array past the end of the file.
+      hpc::save_csr(this->src, tmp.filename());
+      this->patch(tmp.filename(), offsetof(hpc::csr_file_header, array_offset), 1 << 20);
+      TS_ASSERT_THROWS_ANYTHING(map.open(tmp.filename()));
+
+      // Displacements disagreeing with the array size.
+      hpc::save_csr(this->src, tmp.filename());
+      this->patch(tmp.filename(), offsetof(hpc::csr_file_header, array_size), 5);
+      TS_ASSERT_THROWS_ANYTHING(map.open(tmp.filename()));
+   }
+
+   void patch( hpc::fs::path const& path,
+	       size_t offs,
+	       uint64_t value )
+   {
+      std::fstream file(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(offs);
+      file.write((const char*)&value, sizeof(value));
+   }
+
+   void setUp()
+   {
+      hpc::vector<hpc::index> displs(4);
+      displs[0] = 0; displs[1] = 2; displs[2] = 3; displs[3] = 6;
+      this->src.copy_displs(displs.begin(), displs.size());
+      this->src.setup_array();
+      this->src(0, 0) = 10; this->src(0, 1) = 11;
+      this->src(1, 0) = 20;
+      this->src(2, 0) = 30; this->src(2, 1) = 31; this->src(2, 2) = 32;
+   }
+
+   hpc::csr<int> src;
+};
@@ -0,0 +1,102 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/po2_mirrored_ring_buffer.hh"
+
+using namespace hpc;
+
+class po2_mirrored_ring_buffer_suite : public CxxTest::TestSuite {
+public:
+
+   void test_default_ctor()
+   {
+      po2_mirrored_ring_buffer<int> rb;
+      TS_ASSERT_EQUALS( rb.max_size(), 0 );
+      TS_ASSERT( rb.empty() );
+   }
+
+   void test_resize_rounds_to_pages()
+   {
+      po2_mirrored_ring_buffer<int> rb( 8 );
+      size_t page = mirrored_memory::page_size();
+      TS_ASSERT_EQUALS( rb.max_size()*sizeof(int), page );
+      rb.resize( page );
+      TS_ASSERT_EQUALS( rb.max_size(), page );
+      rb.resize( page + 1 );
+      TS_ASSERT_EQUALS( rb.max_size(), 2*page );
+   }
+
+   void test_mirrored()
+   {
+      po2_mirrored_ring_buffer<int> rb( 8 );
+      int* buf = rb._buf;
+      buf[3] = 42;
+      TS_ASSERT_EQUALS( buf[3 + rb.max_size()], 42 );
+      buf[rb.max_size() + 5] = 7;
+      TS_ASSERT_EQUALS( buf[5], 7 );
+   }
+
+   void test_wrapped_contiguous()
+   {
+      po2_mirrored_ring_buffer<int> rb( 8 );
+      size_t cap = rb.max_size();
+      for( size_t ii = 0; ii < cap - 2; ++ii )
+         rb.insert( 0 );
+      rb.consume( cap - 2 );
+      for( int ii = 0; ii < 6; ++ii )
+         rb.insert( ii );
+      TS_ASSERT_EQUALS( rb._start, cap - 2 );
+      TS_ASSERT_EQUALS( rb.size(), 6 );
+      int* ptr = rb.data();
+      for( int ii = 0; ii < 6; ++ii )
+      {
+         TS_ASSERT_EQUALS( ptr[ii], ii );
+         TS_ASSERT_EQUALS( rb[ii], ii );
+      }
+      TS_ASSERT_EQUALS( rb._buf[0], 2 );
+      TS_ASSERT_EQUALS( rb.chunk().size(), 6 );
+   }
+
+   void test_insert_many_full()
+   {
+      po2_mirrored_ring_buffer<int> rb( 8 );
+      size_t cap = rb.max_size();
+      std::vector<int> src( cap + 3, 1 );
+      TS_ASSERT_EQUALS( rb.insert( src.begin(), src.end() ), cap );
+      TS_ASSERT_EQUALS( rb.vacant(), 0 );
+      TS_ASSERT_EQUALS( rb.vacant_chunk().size(), 0 );
+   }
+
+   void test_vacant_extend()
+   {
+      po2_mirrored_ring_buffer<int> rb( 8 );
+      size_t cap = rb.max_size();
+      for( size_t ii = 0; ii < cap; ++ii )
+         rb.insert( 0 );
+      rb.consume( cap - 1 );
+      TS_ASSERT_EQUALS( rb.vacant(), cap - 1 );
+      int* out = rb.vacant_data();
+      for( int ii = 0; ii < 4; ++ii )
+         out[ii] = 10 + ii;
+      rb.extend( 4 );
+      TS_ASSERT_EQUALS( rb.size(), 5 );
+      TS_ASSERT_EQUALS( rb.pop(), 0 );
+      for( int ii = 0; ii < 4; ++ii )
+         TS_ASSERT_EQUALS( rb[ii], 10 + ii );
+   }
+};
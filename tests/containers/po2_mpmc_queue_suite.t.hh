@@ -0,0 +1,109 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include <boost/thread.hpp>
+#include "libhpc/containers/po2_mpmc_queue.hh"
+
+using namespace hpc;
+
+class po2_mpmc_queue_suite : public CxxTest::TestSuite {
+public:
+
+   void test_resize()
+   {
+      po2_mpmc_queue<int> queue;
+      queue.resize( 8 );
+      TS_ASSERT_EQUALS( queue.max_size(), 8 );
+      TS_ASSERT_EQUALS( queue.size(), 0 );
+      TS_ASSERT( queue.empty() );
+   }
+
+   void test_try()
+   {
+      po2_mpmc_queue<int> queue( 4 );
+      int val;
+      TS_ASSERT( !queue.try_pop( val ) );
+
+      // Go round a few laps to exercise the sequence numbers.
+      for( int lap = 0; lap < 3; ++lap ) {
+         for( int ii = 0; ii < 4; ++ii )
+            TS_ASSERT( queue.try_push( 10*lap + ii ) );
+         TS_ASSERT( !queue.try_push( 100 ) );
+         TS_ASSERT_EQUALS( queue.size(), 4 );
+         for( int ii = 0; ii < 4; ++ii ) {
+            TS_ASSERT( queue.try_pop( val ) );
+            TS_ASSERT_EQUALS( val, 10*lap + ii );
+         }
+         TS_ASSERT( !queue.try_pop( val ) );
+      }
+   }
+
+   void test_threads_park()
+   {
+      po2_mpmc_queue<long> queue( 16 );
+      queue.wait_policy().set_spins( 10 );
+      this->_run( queue );
+   }
+
+   void test_threads_spin()
+   {
+      po2_mpmc_queue<long,spin_wait> queue( 16 );
+      this->_run( queue );
+   }
+
+protected:
+
+   static const int num_threads = 4;
+   static const long num_values = 20000;
+
+   template< class Queue >
+   static void
+   produce( Queue* queue,
+            int rank )
+   {
+      for( long ii = rank; ii < num_values; ii += num_threads )
+         queue->push( ii );
+   }
+
+   template< class Queue >
+   static void
+   consume( Queue* queue,
+            long* sum )
+   {
+      for( long ii = 0; ii < num_values/num_threads; ++ii )
+         *sum += queue->pop();
+   }
+
+   template< class Queue >
+   void
+   _run( Queue& queue )
+   {
+      boost::thread_group threads;
+      long sums[num_threads] = { 0 };
+      for( int ii = 0; ii < num_threads; ++ii ) {
+         threads.create_thread( boost::bind( &produce<Queue>, &queue, ii ) );
+         threads.create_thread( boost::bind( &consume<Queue>, &queue, sums + ii ) );
+      }
+      threads.join_all();
+      long sum = 0;
+      for( int ii = 0; ii < num_threads; ++ii )
+         sum += sums[ii];
+      TS_ASSERT_EQUALS( sum, num_values*(num_values - 1)/2 );
+      TS_ASSERT( queue.empty() );
+   }
+};
@@ -15,6 +15,8 @@
 // You should have received a copy of the GNU General Public License
 // along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <unistd.h>
+#include <fcntl.h>
 #include <cxxtest/TestSuite.h>
 #include "libhpc/containers/po2_ring_buffer.hh"
 
@@ -228,4 +230,83 @@ public:
       TS_ASSERT_EQUALS( rb[2], 10 );
       TS_ASSERT_EQUALS( rb[3], 20 );
    }
+
+   void test_fill_from_wrapped()
+   {
+      po2_ring_buffer<int> rb;
+      rb.resize( 8 );
+      for( unsigned ii = 0; ii < 6; ++ii )
+         rb.insert( ii );
+      rb.consume( 4 );
+      int fds[2];
+      TS_ASSERT( pipe( fds ) == 0 );
+      int src[6] = { 10, 11, 12, 13, 14, 15 };
+      TS_ASSERT_EQUALS( write( fds[1], src, sizeof(src) ), sizeof(src) );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), sizeof(src) );
+      TS_ASSERT_EQUALS( rb.size(), 8 );
+      TS_ASSERT_EQUALS( rb[0], 4 );
+      TS_ASSERT_EQUALS( rb[1], 5 );
+      for( unsigned ii = 0; ii < 6; ++ii )
+         TS_ASSERT_EQUALS( rb[ii + 2], 10 + ii );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), 0 );
+      close( fds[0] );
+      close( fds[1] );
+   }
+
+   void test_drain_to_wrapped()
+   {
+      po2_ring_buffer<int> rb;
+      rb.resize( 8 );
+      for( unsigned ii = 0; ii < 6; ++ii )
+         rb.insert( ii );
+      rb.consume( 4 );
+      for( unsigned ii = 0; ii < 5; ++ii )
+         rb.insert( 10 + ii );
+      int fds[2];
+      TS_ASSERT( pipe( fds ) == 0 );
+      TS_ASSERT_EQUALS( rb.drain_to( fds[1] ), 7*sizeof(int) );
+      TS_ASSERT( rb.empty() );
+      int dst[7];
+      TS_ASSERT_EQUALS( read( fds[0], dst, sizeof(dst) ), sizeof(dst) );
+      TS_ASSERT_EQUALS( dst[0], 4 );
+      TS_ASSERT_EQUALS( dst[1], 5 );
+      for( unsigned ii = 0; ii < 5; ++ii )
+         TS_ASSERT_EQUALS( dst[ii + 2], 10 + ii );
+      close( fds[0] );
+      close( fds[1] );
+   }
+
+   void test_fill_from_partial()
+   {
+      po2_ring_buffer<int> rb;
+      rb.resize( 4 );
+      int fds[2];
+      TS_ASSERT( pipe( fds ) == 0 );
+      int src[2] = { 7, 8 };
+      const char* ptr = (const char*)src;
+      TS_ASSERT_EQUALS( write( fds[1], ptr, 6 ), 6 );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), 6 );
+      TS_ASSERT_EQUALS( rb.size(), 1 );
+      TS_ASSERT_EQUALS( rb[0], 7 );
+      TS_ASSERT_EQUALS( write( fds[1], ptr + 6, 2 ), 2 );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), 2 );
+      TS_ASSERT_EQUALS( rb.size(), 2 );
+      TS_ASSERT_EQUALS( rb[1], 8 );
+      close( fds[1] );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), 0 );
+      close( fds[0] );
+   }
+
+   void test_nonblocking()
+   {
+      po2_ring_buffer<int> rb;
+      rb.resize( 4 );
+      int fds[2];
+      TS_ASSERT( pipe( fds ) == 0 );
+      fcntl( fds[0], F_SETFL, fcntl( fds[0], F_GETFL ) | O_NONBLOCK );
+      TS_ASSERT_EQUALS( rb.fill_from( fds[0] ), -1 );
+      TS_ASSERT( rb.empty() );
+      close( fds[0] );
+      close( fds[1] );
+   }
 };
@@ -0,0 +1,142 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cxxtest/TestSuite.h>
+#include <boost/thread.hpp>
+#include "libhpc/containers/po2_spsc_ring_buffer.hh"
+
+using namespace hpc;
+
+class po2_spsc_ring_buffer_suite : public CxxTest::TestSuite {
+public:
+
+   void test_resize()
+   {
+      po2_spsc_ring_buffer<int> rb;
+      rb.resize( 8 );
+      TS_ASSERT_EQUALS( rb.max_size(), 8 );
+      TS_ASSERT_EQUALS( rb.size(), 0 );
+      TS_ASSERT_EQUALS( rb.vacant(), 8 );
+      TS_ASSERT( rb.empty() );
+   }
+
+   void test_separate_lines()
+   {
+      po2_spsc_ring_buffer<int> rb;
+      TS_ASSERT( (char*)&rb._tail - (char*)&rb._head >= 64 );
+      TS_ASSERT( (char*)&rb._head - (char*)&rb._mask >= 64 );
+   }
+
+   void test_insert_pop_one()
+   {
+      po2_spsc_ring_buffer<int> rb( 4 );
+      for( int ii = 0; ii < 4; ++ii )
+         TS_ASSERT( rb.insert( ii ) );
+      TS_ASSERT( !rb.insert( 4 ) );
+      TS_ASSERT_EQUALS( rb.size(), 4 );
+      int val;
+      for( int ii = 0; ii < 4; ++ii ) {
+         TS_ASSERT( rb.pop( val ) );
+         TS_ASSERT_EQUALS( val, ii );
+      }
+      TS_ASSERT( !rb.pop( val ) );
+   }
+
+   void test_insert_pop_many_wrapped()
+   {
+      po2_spsc_ring_buffer<int> rb( 8 );
+      vector<int> buf( 6 ), out( 8 );
+      for( int ii = 0; ii < 6; ++ii )
+         buf[ii] = ii;
+      TS_ASSERT_EQUALS( rb.insert( buf.begin(), buf.end() ), 6 );
+      TS_ASSERT_EQUALS( rb.consume( 4 ), 4 );
+
+      // Wraps around the end of storage.
+      TS_ASSERT_EQUALS( rb.insert( buf.begin(), buf.end() ), 6 );
+      TS_ASSERT_EQUALS( rb.insert( buf.begin(), buf.end() ), 0 );
+      TS_ASSERT_EQUALS( rb.size(), 8 );
+      TS_ASSERT_EQUALS( rb.first_chunk().size(), 4 );
+      TS_ASSERT_EQUALS( rb.second_chunk().size(), 4 );
+
+      TS_ASSERT_EQUALS( rb.pop( out.begin(), 8 ), 8 );
+      TS_ASSERT_EQUALS( out[0], 4 );
+      TS_ASSERT_EQUALS( out[1], 5 );
+      for( int ii = 0; ii < 6; ++ii )
+         TS_ASSERT_EQUALS( out[ii + 2], ii );
+      TS_ASSERT( rb.empty() );
+   }
+
+   void test_vacant_chunks()
+   {
+      po2_spsc_ring_buffer<int> rb( 8 );
+      vector<int> buf( 6 );
+      rb.insert( buf.begin(), buf.end() );
+      rb.consume( 4 );
+      vector<int>::view first = rb.first_vacant_chunk();
+      vector<int>::view second = rb.second_vacant_chunk();
+      TS_ASSERT_EQUALS( first.size(), 2 );
+      TS_ASSERT_EQUALS( second.size(), 4 );
+      first[0] = 100;
+      first[1] = 102;
+      second[0] = 101;
+      rb.extend( 3 );
+      int val;
+      rb.pop( val );
+      rb.pop( val );
+      rb.pop( val );
+      TS_ASSERT_EQUALS( val, 100 );
+      rb.pop( val );
+      TS_ASSERT_EQUALS( val, 102 );
+      rb.pop( val );
+      TS_ASSERT_EQUALS( val, 101 );
+      TS_ASSERT( rb.empty() );
+   }
+
+   void test_threads()
+   {
+      po2_spsc_ring_buffer<long> rb( 64 );
+      long num = 200000;
+      boost::thread producer( fill, &rb, num );
+      vector<long> out( 50 );
+      long next = 0;
+      bool ordered = true;
+      while( next < num ) {
+         size_t cnt = rb.pop( out.begin(), out.size() );
+         for( size_t ii = 0; ii < cnt; ++ii )
+            ordered = ordered && (out[ii] == next++);
+      }
+      producer.join();
+      TS_ASSERT( ordered );
+      TS_ASSERT( rb.empty() );
+   }
+
+protected:
+
+   static void
+   fill( po2_spsc_ring_buffer<long>* rb,
+         long num )
+   {
+      vector<long> batch( 37 );
+      long next = 0;
+      while( next < num ) {
+         long cnt = std::min<long>( batch.size(), num - next );
+         for( long ii = 0; ii < cnt; ++ii )
+            batch[ii] = next + ii;
+         next += rb->insert( batch.begin(), batch.begin() + cnt );
+      }
+   }
+};
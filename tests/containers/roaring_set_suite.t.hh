@@ -0,0 +1,168 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <set>
+#include <cstdlib>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/containers/roaring_set.hh"
+
+using namespace hpc;
+
+class roaring_set_suite : public CxxTest::TestSuite {
+public:
+
+   typedef std::set<uint32_t> ref_type;
+
+   void test_default_ctor()
+   {
+      roaring_set set;
+      TS_ASSERT( set.empty() );
+      TS_ASSERT_EQUALS( set.cardinality(), 0 );
+      TS_ASSERT( !set.has( 0 ) );
+   }
+
+   void test_popcount_words()
+   {
+      std::vector<uint64_t> words( 37 );
+      uint64_t cnt = 0;
+      for( unsigned ii = 0; ii < words.size(); ++ii )
+      {
+         words[ii] = (uint64_t)rand()*rand() ^ ((uint64_t)rand() << 40);
+         cnt += __builtin_popcountll( words[ii] );
+      }
+      TS_ASSERT_EQUALS( popcount_words( &words[0], words.size() ), cnt );
+   }
+
+   void test_insert_values()
+   {
+      roaring_set set;
+      set.insert( 5 );
+      set.insert( 70000 );
+      set.insert( 6 );
+      set.insert( 0xffffffff );
+      TS_ASSERT_EQUALS( set.cardinality(), 4 );
+      TS_ASSERT( set.has( 5 ) );
+      TS_ASSERT( set.has( 6 ) );
+      TS_ASSERT( set.has( 70000 ) );
+      TS_ASSERT( set.has( 0xffffffff ) );
+      TS_ASSERT( !set.has( 7 ) );
+      TS_ASSERT( !set.has( 70001 ) );
+   }
+
+   void test_build_ranges()
+   {
+      std::vector<range<uint32_t> > in;
+      in.push_back( range<uint32_t>( 65530, 65600 ) );
+      in.push_back( range<uint32_t>( 10, 20 ) );
+      in.push_back( range<uint32_t>( 15, 30 ) );
+      in.push_back( range<uint32_t>( 200000, 500000 ) );
+      roaring_set set;
+      set.build( in.begin(), in.end() );
+      TS_ASSERT_EQUALS( set.cardinality(), 20 + 70 + 300000 );
+      std::vector<range<uint32_t> > out;
+      set.ranges( std::back_inserter( out ) );
+      TS_ASSERT_EQUALS( out.size(), 3 );
+      TS_ASSERT_EQUALS( out[0], range<uint32_t>( 10, 30 ) );
+      TS_ASSERT_EQUALS( out[1], range<uint32_t>( 65530, 65600 ) );
+      TS_ASSERT_EQUALS( out[2], range<uint32_t>( 200000, 500000 ) );
+
+      // Long runs should stay compact.
+      TS_ASSERT( set.memory_usage() < 1024 );
+   }
+
+   void test_operations()
+   {
+      for( unsigned rep = 0; rep < 3; ++rep )
+      {
+         ref_type ref_a, ref_b;
+         roaring_set set_a, set_b;
+         _random( ref_a, set_a, rep );
+         _random( ref_b, set_b, rep + 10 );
+
+         ref_type ref;
+         std::set_union( ref_a.begin(), ref_a.end(), ref_b.begin(), ref_b.end(), std::inserter( ref, ref.end() ) );
+         _check( set_a | set_b, ref );
+
+         ref.clear();
+         std::set_intersection( ref_a.begin(), ref_a.end(), ref_b.begin(), ref_b.end(), std::inserter( ref, ref.end() ) );
+         _check( set_a & set_b, ref );
+
+         ref.clear();
+         std::set_difference( ref_a.begin(), ref_a.end(), ref_b.begin(), ref_b.end(), std::inserter( ref, ref.end() ) );
+         _check( set_a - set_b, ref );
+      }
+   }
+
+   void test_equality()
+   {
+      roaring_set set_a, set_b;
+      for( uint32_t ii = 0; ii < 5000; ++ii )
+         set_a.insert( 2*ii );
+      std::vector<range<uint32_t> > in;
+      for( uint32_t ii = 0; ii < 5000; ++ii )
+         in.push_back( range<uint32_t>( 2*ii, 2*ii + 1 ) );
+      set_b.build( in.begin(), in.end() );
+      TS_ASSERT( set_a == set_b );
+      set_b.insert( 1 );
+      TS_ASSERT( set_a != set_b );
+   }
+
+protected:
+
+   // Mix sparse, dense and clustered chunks.
+   void
+   _random( ref_type& ref,
+            roaring_set& set,
+            unsigned seed )
+   {
+      srand( seed );
+      std::vector<range<uint32_t> > in;
+      for( unsigned ii = 0; ii < 200; ++ii )
+      {
+         uint32_t start = rand()%(4*65536);
+         uint32_t len = (ii%3 == 0) ? rand()%2000 : 1;
+         in.push_back( range<uint32_t>( start, start + len ) );
+      }
+      for( unsigned ii = 0; ii < 6000; ++ii )
+         in.push_back( range<uint32_t>( 65536*4 + 2*ii, 65536*4 + 2*ii + 1 ) );
+      for( unsigned ii = 0; ii < in.size(); ++ii )
+      {
+         for( uint32_t jj = in[ii].start(); jj < in[ii].finish(); ++jj )
+            ref.insert( jj );
+      }
+      set.build( in.begin(), in.end() );
+      _check( set, ref );
+   }
+
+   void
+   _check( const roaring_set& set,
+           const ref_type& ref )
+   {
+      TS_ASSERT_EQUALS( set.cardinality(), ref.size() );
+      std::vector<range<uint32_t> > out;
+      set.ranges( std::back_inserter( out ) );
+      ref_type got;
+      for( unsigned ii = 0; ii < out.size(); ++ii )
+      {
+         for( uint32_t jj = out[ii].start(); jj < out[ii].finish(); ++jj )
+            got.insert( jj );
+      }
+      TS_ASSERT( got == ref );
+      for( uint32_t ii = 0; ii < 6*65536; ii += 97 )
+         TS_ASSERT_EQUALS( set.has( ii ), ref.count( ii ) == 1 );
+   }
+};
@@ -0,0 +1,102 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/memory/arena.hh"
+
+using namespace hpc;
+
+class arena_suite : public CxxTest::TestSuite {
+public:
+
+   void test_allocate()
+   {
+      memory::arena arena( 1024 );
+      char* a = (char*)arena.allocate( 10 );
+      char* b = (char*)arena.allocate( 10 );
+      TS_ASSERT_EQUALS( (size_t)a%16, 0 );
+      TS_ASSERT_EQUALS( b - a, 16 );
+      TS_ASSERT_EQUALS( arena.used(), 20 );
+      TS_ASSERT_EQUALS( arena.capacity(), 1024 );
+      char* c = (char*)arena.allocate( 64, 64 );
+      TS_ASSERT_EQUALS( (size_t)c%64, 0 );
+   }
+
+   void test_rollback()
+   {
+      memory::arena arena( 1024 );
+      void* a = arena.allocate( 100 );
+      arena.deallocate( a, 100 );
+      TS_ASSERT_EQUALS( arena.used(), 0 );
+      TS_ASSERT_EQUALS( arena.allocate( 50 ), a );
+   }
+
+   void test_grow_and_reset()
+   {
+      memory::arena arena( 256 );
+      void* first = arena.allocate( 200 );
+      arena.allocate( 200 );
+      arena.allocate( 1000 );
+      TS_ASSERT( arena.capacity() >= 1400 );
+      size_t cap = arena.capacity();
+      arena.reset();
+      TS_ASSERT_EQUALS( arena.used(), 0 );
+      TS_ASSERT_EQUALS( arena.capacity(), cap );
+
+      // The whole phase now fits in the single coalesced block.
+      char* a = (char*)arena.allocate( 200 );
+      char* b = (char*)arena.allocate( 200 );
+      char* c = (char*)arena.allocate( 1000 );
+      TS_ASSERT_EQUALS( arena.capacity(), cap );
+      TS_ASSERT( b > a && c > b );
+      arena.reset();
+      TS_ASSERT_EQUALS( (char*)arena.allocate( 200 ), a );
+      (void)first;
+   }
+
+   void test_release()
+   {
+      memory::arena arena( 256 );
+      arena.allocate( 100 );
+      arena.release();
+      TS_ASSERT_EQUALS( arena.capacity(), 0 );
+      TS_ASSERT_EQUALS( arena.used(), 0 );
+   }
+
+   void test_allocator()
+   {
+      memory::arena arena;
+      std::vector<double,memory::arena_allocator<double> > vec( (memory::arena_allocator<double>( arena )) );
+      vec.reserve( 100 );
+      for( unsigned ii = 0; ii < 100; ++ii )
+         vec.push_back( ii );
+      TS_ASSERT_EQUALS( arena.used(), 100*sizeof(double) );
+      TS_ASSERT_EQUALS( vec[42], 42 );
+
+      memory::arena_allocator<int> rebound( vec.get_allocator() );
+      TS_ASSERT( rebound == vec.get_allocator() );
+      TS_ASSERT( memory::arena_allocator<int>() != rebound );
+   }
+
+   void test_default_allocator()
+   {
+      std::vector<int,memory::arena_allocator<int> > vec( 100, 1 );
+      TS_ASSERT_EQUALS( vec.size(), 100 );
+      TS_ASSERT_EQUALS( vec[99], 1 );
+   }
+};
@@ -94,6 +94,56 @@ public:
 #endif
    }
 
+   void test_free_elsewhere()
+   {
+#ifndef NMEMSTATS
+      // Frees credit the groups charged at allocation, not those the
+      // freeing thread has selected.
+      memory::select( "/a" );
+      int* buf = new int[100];
+      memory::deselect( "/a" );
+      memory::select( "/b" );
+      delete[] buf;
+      memory::deselect( "/b" );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/a" ).data().size, 0 );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/a" ).data().peak, 100*sizeof(int) + padding );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/a" ).data().count, 0 );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/b" ).data().size, 0 );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/b" ).data().peak, 0 );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/b" ).data().count, 0 );
+
+      // Untracked blocks are never credited.
+      auto cur_size = memory::ctx.find_group( "/" ).data().size;
+      int* raw;
+      {
+	 memory::untracked guard;
+	 raw = new int[100];
+      }
+      memory::select( "/b" );
+      delete[] raw;
+      memory::deselect( "/b" );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/" ).data().size, cur_size );
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/b" ).data().size, 0 );
+#endif
+   }
+
+   void test_threaded_free()
+   {
+#if !defined(NMEMSTATS) && defined(_OPENMP)
+      int* buf[4];
+#pragma omp parallel for num_threads(4)
+      for( int ii = 0; ii < 4; ++ii )
+      {
+	 memory::scoped_group grp( "/worker" );
+	 buf[ii] = new int[100];
+      }
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/worker" ).data().size, 4*(100*sizeof(int) + padding) );
+      for( int ii = 0; ii < 4; ++ii )
+	 delete[] buf[ii];
+      TS_ASSERT_EQUALS( memory::ctx.find_group( "/worker" ).data().size, 0 );
+#endif
+   }
+
    void setUp()
    {
 #ifndef NMEMSTATS
@@ -106,9 +156,6 @@ public:
 #endif
    }
 
-#ifndef NDEBUG
-   static const size_t padding = 12;
-#else
-   static const size_t padding = 8;
-#endif
+   // Only the requested bytes are charged.
+   static const size_t padding = 0;
 };
@@ -0,0 +1,95 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/memory/placement.hh"
+#include "libhpc/system/reallocate.hh"
+
+using namespace hpc;
+
+class placement_suite : public CxxTest::TestSuite {
+public:
+
+   void test_allocate()
+   {
+      memory::placement place( memory::placement::interleave );
+      size_t size = 3*(1 << 20) + 100;
+      char* ptr = (char*)memory::placed_allocate( size, place );
+      size_t huge = memory::huge_page_size();
+      if( huge )
+         TS_ASSERT_EQUALS( (size_t)ptr%huge, 0 );
+      TS_ASSERT_EQUALS( ptr[0], 0 );
+      TS_ASSERT_EQUALS( ptr[size - 1], 0 );
+      ptr[size - 1] = 1;
+      memory::placed_deallocate( ptr, size, place );
+   }
+
+   void test_parallel_touch()
+   {
+      std::vector<int> buf( 10000 );
+      for( unsigned ii = 0; ii < buf.size(); ++ii )
+         buf[ii] = ii;
+      memory::parallel_touch( buf.data() + 1, (buf.size() - 1)*sizeof(int) );
+      for( unsigned ii = 0; ii < buf.size(); ++ii )
+         TS_ASSERT_EQUALS( buf[ii], ii );
+   }
+
+   void test_nodes()
+   {
+      TS_ASSERT( memory::numa_nodes() >= 1 );
+      std::vector<char> buf( 1 << 16 );
+      memory::interleave_pages( buf.data(), buf.size() );
+      memory::bind_pages( buf.data(), buf.size(), 0 );
+      TS_ASSERT( !memory::bind_pages( buf.data(), buf.size(), -1 ) );
+      memory::scoped_interleave scope;
+   }
+
+   void test_allocator()
+   {
+      memory::placement place( memory::placement::first_touch, true, true, 4096 );
+      std::vector<double,memory::placed_allocator<double> > vec( (memory::placed_allocator<double>( place )) );
+      vec.resize( 10 );
+      TS_ASSERT_EQUALS( vec[9], 0 );
+      vec.resize( 100000 );
+      TS_ASSERT_EQUALS( vec[9], 0 );
+      TS_ASSERT_EQUALS( vec[99999], 0 );
+      TS_ASSERT_EQUALS( (size_t)vec.data()%4096, 0 );
+      for( unsigned ii = 0; ii < vec.size(); ++ii )
+         vec[ii] = ii;
+      TS_ASSERT_EQUALS( vec[42], 42 );
+
+      memory::placed_allocator<int> rebound( vec.get_allocator() );
+      TS_ASSERT( rebound == vec.get_allocator() );
+      TS_ASSERT( memory::placed_allocator<int>() != rebound );
+   }
+
+   void test_reallocate()
+   {
+      std::vector<float,memory::placed_allocator<float> > vec( 10, 1 );
+      memory::placement place( memory::placement::interleave, false, true, 1024 );
+      reallocate( vec, 1000, place );
+      TS_ASSERT_EQUALS( vec.size(), 1000 );
+      TS_ASSERT_EQUALS( vec[0], 0 );
+      TS_ASSERT( vec.get_allocator().placement() == place );
+
+      // Plain reallocate keeps the placement.
+      reallocate( vec, 2000 );
+      TS_ASSERT( vec.get_allocator().placement() == place );
+      TS_ASSERT_EQUALS( vec[1999], 0 );
+   }
+};
@@ -0,0 +1,97 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <list>
+#include <set>
+#include <cxxtest/TestSuite.h>
+#include "libhpc/memory/pool.hh"
+
+using namespace hpc;
+
+class pool_suite : public CxxTest::TestSuite {
+public:
+
+   void test_block_size()
+   {
+      memory::pool pool( 20 );
+      TS_ASSERT_EQUALS( pool.block_size(), 32 );
+      memory::pool small( 1 );
+      TS_ASSERT_EQUALS( small.block_size(), 16 );
+   }
+
+   void test_allocate()
+   {
+      memory::pool pool( 24, 4 );
+      std::set<void*> ptrs;
+      for( unsigned ii = 0; ii < 10; ++ii )
+      {
+         void* ptr = pool.allocate();
+         TS_ASSERT_EQUALS( (size_t)ptr%16, 0 );
+         ptrs.insert( ptr );
+      }
+      TS_ASSERT_EQUALS( ptrs.size(), 10 );
+      TS_ASSERT_EQUALS( pool.size(), 10 );
+   }
+
+   void test_reuse()
+   {
+      memory::pool pool( 24, 4 );
+      void* a = pool.allocate();
+      pool.allocate();
+      pool.deallocate( a );
+      TS_ASSERT_EQUALS( pool.size(), 1 );
+      TS_ASSERT_EQUALS( pool.allocate(), a );
+   }
+
+   void test_release()
+   {
+      memory::pool pool( 24, 4 );
+      pool.allocate();
+      pool.release();
+      TS_ASSERT_EQUALS( pool.size(), 0 );
+      pool.allocate();
+      TS_ASSERT_EQUALS( pool.size(), 1 );
+   }
+
+   void test_allocator()
+   {
+      memory::pool pool( 64 );
+      {
+         std::list<int,memory::pool_allocator<int> > lst( (memory::pool_allocator<int>( pool )) );
+         for( int ii = 0; ii < 100; ++ii )
+            lst.push_back( ii );
+         TS_ASSERT_EQUALS( pool.size(), 100 );
+         TS_ASSERT_EQUALS( lst.back(), 99 );
+         lst.pop_front();
+         TS_ASSERT_EQUALS( pool.size(), 99 );
+      }
+      TS_ASSERT_EQUALS( pool.size(), 0 );
+   }
+
+   void test_fallback()
+   {
+      memory::pool pool( 16 );
+      memory::pool_allocator<double> alloc( pool );
+      double* arr = alloc.allocate( 10 );
+      TS_ASSERT_EQUALS( pool.size(), 0 );
+      alloc.deallocate( arr, 10 );
+      memory::pool_allocator<char[32]> big( alloc );
+      char (*blk)[32] = big.allocate( 1 );
+      TS_ASSERT_EQUALS( pool.size(), 0 );
+      big.deallocate( blk, 1 );
+   }
+};
@@ -48,3 +48,56 @@ TEST_CASE( "/libhpc/mpi/comm/send" )
    req.wait();
    TEST( inc == circ.first );
 }
+
+TEST_CASE( "/libhpc/mpi/comm/all_to_all/varray" )
+{
+   hpc::mpi::comm const& comm = hpc::mpi::comm::world;
+
+   // Each value spans more than one mapped element.
+   std::vector<hpc::varray<int,2> > out( comm.size() );
+   for( int to = 0; to < comm.size(); ++to )
+   {
+      out[to][0] = comm.rank();
+      out[to][1] = to;
+   }
+   std::vector<hpc::varray<int,2> > inc = comm.all_to_all( out );
+   TEST( inc.size() == comm.size() );
+   for( int from = 0; from < comm.size(); ++from )
+   {
+      TEST( inc[from][0] == from );
+      TEST( inc[from][1] == comm.rank() );
+   }
+}
+
+TEST_CASE( "/libhpc/mpi/comm/all_to_allv" )
+{
+   hpc::mpi::comm const& comm = hpc::mpi::comm::world;
+
+   // Send `to + 1` copies of my rank to each rank `to`.
+   std::vector<int> cnts( comm.size() ), out;
+   for( int to = 0; to < comm.size(); ++to )
+   {
+      cnts[to] = to + 1;
+      out.insert( out.end(), to + 1, comm.rank() );
+   }
+   std::vector<int> inc_cnts;
+   std::vector<int> inc = comm.all_to_allv( out, cnts, &inc_cnts );
+   TEST( inc.size() == (comm.rank() + 1)*comm.size() );
+   TEST( inc_cnts.size() == comm.size() );
+   for( int from = 0; from < comm.size(); ++from )
+   {
+      TEST( inc_cnts[from] == comm.rank() + 1 );
+      TEST( inc[from*(comm.rank() + 1)] == from );
+   }
+}
+
+TEST_CASE( "/libhpc/mpi/comm/scan/array" )
+{
+   hpc::mpi::comm const& comm = hpc::mpi::comm::world;
+   std::vector<long> buf( 2 );
+   buf[0] = 1;
+   buf[1] = comm.rank();
+   comm.scan( hpc::view<std::vector<long> >( buf ) );
+   TEST( buf[0] == comm.rank() );
+   TEST( buf[1] == (long)comm.rank()*(comm.rank() - 1)/2 );
+}
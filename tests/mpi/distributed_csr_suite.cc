@@ -0,0 +1,99 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <libhpc/unit_test/main_mpi.hh>
+#include <libhpc/mpi/distributed_csr.hh>
+
+typedef hpc::mpi::comm comm;
+
+///
+/// Each rank owns rank + 2 rows, and global row r holds r%3 + 1
+/// values of the form 10*r + offset + col.
+///
+void
+make_local( hpc::csr<long>& local,
+            long offset = 0 )
+{
+   long num_rows = comm::world.rank() + 2;
+   long first = 0;
+   for( int ii = 0; ii < comm::world.rank(); ++ii )
+      first += ii + 2;
+   hpc::vector<hpc::index> displs( num_rows + 1 );
+   displs[0] = 0;
+   for( long ii = 0; ii < num_rows; ++ii )
+      displs[ii + 1] = displs[ii] + (first + ii)%3 + 1;
+   local.take_displs( displs );
+   local.setup_array();
+   for( long ii = 0; ii < num_rows; ++ii )
+   {
+      for( long jj = 0; jj < local.row_size( ii ); ++jj )
+         local( ii, jj ) = 10*(first + ii) + offset + jj;
+   }
+}
+
+TEST_CASE( "/libhpc/mpi/distributed_csr/set_local" )
+{
+   hpc::csr<long> local;
+   make_local( local );
+   hpc::mpi::distributed_csr<long> dcsr;
+   dcsr.set_local( local );
+   long size = comm::world.size();
+   TEST( dcsr.num_global_rows() == (size*(size + 1))/2 + size );
+   TEST( (dcsr.row_end() - dcsr.row_begin()) == comm::world.rank() + 2 );
+   TEST( dcsr.owner( dcsr.row_begin() ) == comm::world.rank() );
+   TEST( dcsr.owner( dcsr.row_end() - 1 ) == comm::world.rank() );
+}
+
+TEST_CASE( "/libhpc/mpi/distributed_csr/update_ghosts" )
+{
+   hpc::csr<long> local;
+   make_local( local );
+   hpc::mpi::distributed_csr<long> dcsr;
+   dcsr.set_local( local );
+
+   // Reference the rows either side of my range, the first row and
+   // one of my own.
+   std::vector<hpc::index> refs;
+   refs.push_back( 0 );
+   refs.push_back( dcsr.row_begin() );
+   if( dcsr.row_begin() > 0 )
+      refs.push_back( dcsr.row_begin() - 1 );
+   if( dcsr.row_end() < dcsr.num_global_rows() )
+      refs.push_back( dcsr.row_end() );
+   refs.push_back( 0 );
+   dcsr.setup_ghosts( refs.begin(), refs.end() );
+
+   for( unsigned ii = 0; ii < refs.size(); ++ii )
+   {
+      long row = refs[ii];
+      TEST( dcsr.has_row( row ) == true );
+      TEST( (long)dcsr[row].size() == row%3 + 1 );
+      for( unsigned jj = 0; jj < dcsr[row].size(); ++jj )
+         TEST( dcsr[row][jj] == 10*row + jj );
+   }
+
+   // Change my values and refresh.
+   for( long ii = 0; ii < (long)dcsr.local().array().size(); ++ii )
+      dcsr.mod_local().mod_array()[ii] += 1000;
+   dcsr.update_ghosts();
+   for( unsigned ii = 0; ii < refs.size(); ++ii )
+   {
+      long row = refs[ii];
+      for( unsigned jj = 0; jj < dcsr[row].size(); ++jj )
+         TEST( dcsr[row][jj] == 10*row + 1000 + jj );
+   }
+}
@@ -0,0 +1,57 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <libhpc/unit_test/main_mpi.hh>
+#include <libhpc/mpi/memory_report.hh>
+
+typedef hpc::mpi::comm comm;
+
+SUITE_PREFIX( "/hpc/mpi/memory_report/" );
+
+TEST_CASE( "union_of_groups" )
+{
+   std::vector<hpc::memory::group_report> local( 2 );
+   local[0].path = "/";
+   local[0].size = 10;
+   local[0].peak = 20 + comm::world.rank();
+   local[0].count = 1;
+   local[0].total = 2;
+   local[1].path = (comm::world.rank()%2) ? "/odd" : "/even";
+   local[1].size = 1;
+   local[1].peak = 1;
+   local[1].count = 1;
+   local[1].total = 1;
+
+   std::vector<hpc::mpi::memory_summary> res = hpc::mpi::memory_report( local );
+   unsigned size = comm::world.size();
+   unsigned odd = size/2;
+   TEST( res.size() == (odd ? 3 : 2) );
+   TEST( res[0].path == "/" );
+   TEST( res[0].size_sum == 10*size );
+   TEST( res[0].size_max == 10 );
+   TEST( res[0].peak_sum == 20*size + size*(size - 1)/2 );
+   TEST( res[0].peak_max == 20 + size - 1 );
+   TEST( res[0].count == size );
+   TEST( res[0].total == 2*size );
+   TEST( res[1].path == "/even" );
+   TEST( res[1].size_sum == size - odd );
+   if( odd )
+   {
+      TEST( res[2].path == "/odd" );
+      TEST( res[2].total == odd );
+   }
+}
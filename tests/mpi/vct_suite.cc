@@ -0,0 +1,59 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <libhpc/unit_test/main_mpi.hh>
+#include <libhpc/mpi/vct.hh>
+#include <libhpc/memory/arena.hh>
+
+typedef hpc::mpi::comm comm;
+
+SUITE_PREFIX( "/hpc/mpi/vct/" );
+
+TEST_CASE( "scattera_arena" )
+{
+   std::vector<unsigned> nbrs;
+   for( int ii = 0; ii < comm::world.size(); ++ii )
+   {
+      if( ii != comm::world.rank() )
+         nbrs.push_back( ii );
+   }
+   hpc::mpi::vct vct;
+   vct.set_comm( comm::world );
+   vct.set_neighbors( nbrs );
+
+   // Send rank + 1 copies of my rank to each neighbour.
+   std::vector<int> out, out_displs( 1, 0 );
+   for( unsigned ii = 0; ii < nbrs.size(); ++ii )
+   {
+      out.insert( out.end(), comm::world.rank() + 1, comm::world.rank() );
+      out_displs.push_back( out.size() );
+   }
+
+   hpc::memory::arena arena;
+   std::vector<int,hpc::memory::arena_allocator<int> > inc( (hpc::memory::arena_allocator<int>( arena )) );
+   std::vector<int,hpc::memory::arena_allocator<int> > inc_displs( (hpc::memory::arena_allocator<int>( arena )) );
+   vct.scattera<int,int>( hpc::view<std::vector<int> >( out ), hpc::view<std::vector<int> >( out_displs ), inc, inc_displs );
+   size_t used = arena.used();
+   TEST( used == (inc.size() + inc_displs.size())*sizeof(int) );
+   for( unsigned ii = 0; ii < nbrs.size(); ++ii )
+   {
+      int cnt = inc_displs[ii + 1] - inc_displs[ii];
+      TEST( cnt == (int)nbrs[ii] + 1 );
+      int val = inc[inc_displs[ii]];
+      TEST( val == (int)nbrs[ii] );
+   }
+}
@@ -0,0 +1,54 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <fstream>
+#include <libhpc/unit_test/main.hh>
+#include <libhpc/system/mapped_file.hh>
+#include <libhpc/system/tmpfile.hh>
+
+TEST_CASE( "/libhpc/system/mapped_file/open" )
+{
+   hpc::tmpfile tmp;
+   {
+      std::ofstream file( tmp.filename().c_str() );
+      file << "hello world";
+   }
+   hpc::mapped_file map( tmp.filename() );
+   TEST( map.is_open() == true );
+   TEST( map.size() == 11 );
+   TEST( std::string( (char const*)map.data(), map.size() ) == "hello world" );
+   map.close();
+   TEST( map.is_open() == false );
+   TEST( map.size() == 0 );
+}
+
+TEST_CASE( "/libhpc/system/mapped_file/empty" )
+{
+   hpc::tmpfile tmp;
+   {
+      std::ofstream file( tmp.filename().c_str() );
+   }
+   hpc::mapped_file map( tmp.filename() );
+   TEST( map.is_open() == false );
+   TEST( map.size() == 0 );
+}
+
+TEST_CASE( "/libhpc/system/mapped_file/missing" )
+{
+   hpc::mapped_file map;
+   THROWS_ANY( map.open( "/nonexistent/libhpc/mapped_file" ) );
+}
@@ -0,0 +1,40 @@
+// Copyright 2012 Luke Hodkinson
+
+// This file is part of libhpc.
+// 
+// libhpc is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// libhpc is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with libhpc.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <libhpc/unit_test/main.hh>
+#include <libhpc/system/mirrored_memory.hh>
+
+TEST_CASE( "/libhpc/system/mirrored_memory/allocate" )
+{
+   size_t size = 2*hpc::mirrored_memory::page_size();
+   hpc::mirrored_memory mem( size );
+   TEST( mem.size() == size );
+   char* ptr = (char*)mem.data();
+   ptr[10] = 'a';
+   TEST( ptr[size + 10] == 'a' );
+   ptr[size + size - 1] = 'b';
+   TEST( ptr[size - 1] == 'b' );
+   mem.release();
+   TEST( mem.data() == (void*)0 );
+   TEST( mem.size() == 0 );
+}
+
+TEST_CASE( "/libhpc/system/mirrored_memory/unaligned" )
+{
+   hpc::mirrored_memory mem;
+   THROWS_ANY( mem.allocate( hpc::mirrored_memory::page_size() + 1 ) );
+}